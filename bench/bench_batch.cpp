@@ -0,0 +1,49 @@
+// Lane instructions per second of the batched engine (AVX2 and scalar)
+// against one threaded-engine run per input, on the loop program with a
+// different trip count in every lane.
+#include "batch.h"
+#include "core.h"
+#include "bench_common.h"
+
+using BenchCore = SingleStageCoreT<NullTracer, BasicStats, DirectMemory>;
+
+int main(int argc, char* argv[]) {
+    size_t lanes = argc > 1 ? stoul(argv[1]) : 256;
+    uint32_t iterations = argc > 2 ? (uint32_t)stoul(argv[2]) : 20000;
+    vector<DataMem> inputs;
+    for (size_t l = 0; l < lanes; l++) {
+        // trip counts spread by up to 1/8, so lanes leave the loop at different times
+        uint32_t trips = iterations + (uint32_t)(l * iterations / 8 / lanes);
+        string dir = bench::makeLoopProgram("bench/bench_data/batch/lane" + to_string(l), trips);
+        inputs.emplace_back("SS", dir);
+    }
+    InsMem imem("Imem", "bench/bench_data/batch/lane0");
+
+    uint64_t instructions = 0;
+    vector<uint32_t> ref;
+    double standalone = bench::timeIt([&] {
+        for (size_t l = 0; l < lanes; l++) {
+            DataMem dmem(inputs[l]);
+            BenchCore core("bench/bench_data/batch/lane0", imem, dmem);
+            while (!core.halted) core.runThreaded(UINT64_MAX);
+            instructions += core.getInstructionCount();
+            ref.push_back(core.myRF.readReg(3));
+        }
+    });
+    cout << lanes << " threaded runs: " << instructions / standalone / 1e6 << " MIPS" << endl;
+
+    bool same = true;
+    for (bool simd : {true, false}) {
+        if (simd && !BatchEngine::simdSupported()) continue;
+        BatchEngine batch(imem.getProgram(), lanes);
+        batch.setSimd(simd);
+        for (size_t l = 0; l < lanes; l++) batch.loadMemory(l, inputs[l]);
+        double secs = bench::timeIt([&] { batch.run(); });
+        for (size_t l = 0; l < lanes; l++) same = same && batch.readReg(l, 3) == ref[l];
+        cout << "batch " << (simd ? "AVX2  " : "scalar") << ": " << instructions / secs / 1e6 << " MIPS ("
+             << standalone / secs << "x), " << (double)instructions / batch.getSteps() << " lanes per step"
+             << endl;
+    }
+    cout << "results " << (same ? "match" : "DIFFER") << endl;
+    return same ? 0 : 1;
+}
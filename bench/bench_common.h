@@ -0,0 +1,114 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include "common.h"
+#include <chrono>
+#include <filesystem>
+
+// Shared helpers for the benchmarks: a tiny assembler for the supported
+// subset and a generator for a long-running loop program.
+
+namespace bench {
+
+inline uint32_t encR(uint32_t f7, uint32_t rs2, uint32_t rs1, uint32_t f3, uint32_t rd) {
+    return (f7 << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | 0x33;
+}
+inline uint32_t encI(int32_t imm, uint32_t rs1, uint32_t f3, uint32_t rd, uint32_t opcode) {
+    return ((uint32_t)(imm & 0xFFF) << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | opcode;
+}
+inline uint32_t encS(int32_t imm, uint32_t rs2, uint32_t rs1) {
+    uint32_t u = (uint32_t)imm;
+    return (((u >> 5) & 0x7F) << 25) | (rs2 << 20) | (rs1 << 15) | (2 << 12) | ((u & 0x1F) << 7) | 0x23;
+}
+inline uint32_t encB(int32_t imm, uint32_t rs2, uint32_t rs1, uint32_t f3) {
+    uint32_t u = (uint32_t)imm;
+    return (((u >> 12) & 1) << 31) | (((u >> 5) & 0x3F) << 25) | (rs2 << 20) | (rs1 << 15) |
+           (f3 << 12) | (((u >> 1) & 0xF) << 8) | (((u >> 11) & 1) << 7) | 0x63;
+}
+inline uint32_t encJ(int32_t imm, uint32_t rd) {
+    uint32_t u = (uint32_t)imm;
+    return (((u >> 20) & 1) << 31) | (((u >> 1) & 0x3FF) << 21) | (((u >> 11) & 1) << 20) |
+           (((u >> 12) & 0xFF) << 12) | (rd << 7) | 0x6F;
+}
+const uint32_t HALT = 0xFFFFFFFF;
+
+inline void writeBytes(const string& path, const vector<uint32_t>& words) {
+    ofstream out(path);
+    for (uint32_t w : words) {
+        for (int i = 3; i >= 0; i--) out << bitset<8>((w >> (i * 8)) & 0xFF) << "\n";
+    }
+}
+
+// Writes imem.txt/dmem.txt for a loop of `iterations` trips (8 instructions
+// per trip, with loads, stores, a load-use hazard, a JAL and a taken branch)
+// and returns the directory.
+inline string makeLoopProgram(const string& dir, uint32_t iterations) {
+    std::filesystem::create_directories(dir);
+    vector<uint32_t> prog = {
+        encI(0, 0, 2, 1, 0x03),        // 0:  LW   R1, R0, #0     trip count
+        encI(0, 0, 0, 2, 0x13),        // 4:  ADDI R2, R0, #0
+        encI(1, 2, 0, 2, 0x13),        // 8:  ADDI R2, R2, #1
+        encR(0, 2, 3, 0, 3),           // 12: ADD  R3, R3, R2
+        encR(0, 3, 4, 4, 4),           // 16: XOR  R4, R4, R3
+        encS(8, 3, 0),                 // 20: SW   R3, R0, #8
+        encI(8, 0, 2, 5, 0x03),        // 24: LW   R5, R0, #8
+        encR(0, 4, 5, 7, 6),           // 28: AND  R6, R5, R4     load-use
+        encJ(8, 7),                    // 32: JAL  R7, #8
+        HALT,                          // 36: (skipped)
+        encB(-32, 1, 2, 1),            // 40: BNE  R2, R1, #-32
+        HALT                           // 44: HALT
+    };
+    writeBytes(dir + "/imem.txt", prog);
+    vector<uint32_t> data(MemSize / 4, 0);
+    data[0] = iterations;
+    writeBytes(dir + "/dmem.txt", data);
+    return dir;
+}
+
+// Writes imem.txt/dmem.txt for a loop of `iterations` trips (at most 2047)
+// using every operation of isaTable: all ALU forms, a store and a load of
+// the same word, taken and not-taken BEQ, BNE, JAL and an unknown encoding
+// (NOP). Returns the directory.
+inline string makeMixProgram(const string& dir, int32_t iterations) {
+    std::filesystem::create_directories(dir);
+    vector<uint32_t> prog = {
+        encI(iterations, 0, 0, 1, 0x13),  // 0:  ADDI R1, R0, #iterations
+        encI(-7, 0, 0, 2, 0x13),       // 4:  ADDI R2, R0, #-7
+        encR(0, 2, 3, 0, 3),           // 8:  ADD  R3, R3, R2
+        encR(0x20, 1, 4, 0, 4),        // 12: SUB  R4, R4, R1
+        encR(0, 4, 3, 4, 5),           // 16: XOR  R5, R3, R4
+        encR(0, 2, 5, 6, 6),           // 20: OR   R6, R5, R2
+        encR(0, 3, 6, 7, 7),           // 24: AND  R7, R6, R3
+        encI(0x55, 7, 4, 8, 0x13),     // 28: XORI R8, R7, #0x55
+        encI(-16, 8, 6, 9, 0x13),      // 32: ORI  R9, R8, #-16
+        encI(0x7F, 9, 7, 10, 0x13),    // 36: ANDI R10, R9, #0x7F
+        encS(16, 10, 11),              // 40: SW   R10, R11, #16
+        encI(16, 11, 2, 12, 0x03),     // 44: LW   R12, R11, #16
+        encR(0, 12, 13, 0, 13),        // 48: ADD  R13, R13, R12  load-use
+        encI(4, 11, 0, 11, 0x13),      // 52: ADDI R11, R11, #4
+        encB(8, 10, 12, 0),            // 56: BEQ  R12, R10, #8   taken
+        HALT,                          // 60: (skipped)
+        0x0000000B,                    // 64: unknown opcode, NOP
+        encI(-1, 1, 0, 1, 0x13),       // 68: ADDI R1, R1, #-1
+        encB(-64, 0, 1, 1),            // 72: BNE  R1, R0, #-64
+        encJ(8, 14),                   // 76: JAL  R14, #8
+        HALT,                          // 80: (skipped)
+        encB(8, 0, 2, 0),              // 84: BEQ  R2, R0, #8     not taken
+        HALT                           // 88: HALT
+    };
+    writeBytes(dir + "/imem.txt", prog);
+    writeBytes(dir + "/dmem.txt", vector<uint32_t>(MemSize / 4, 0));
+    return dir;
+}
+
+// Wall-clock seconds spent in f()
+template <class F>
+double timeIt(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace bench
+
+#endif // BENCH_COMMON_H
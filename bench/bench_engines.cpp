@@ -0,0 +1,50 @@
+// Instructions per second of the single stage engines on a long loop,
+// with only the final cycle traced so only simulation work is measured.
+#include "core.h"
+#include "bench_common.h"
+#include <functional>
+
+using BenchCore = FinalStateSingleStageCore;
+
+int main(int argc, char* argv[]) {
+    uint32_t iterations = argc > 1 ? (uint32_t)stoul(argv[1]) : 500000;
+    string dir = bench::makeLoopProgram("bench/bench_data/loop", iterations);
+    string outDir = dir + "/out";
+    InsMem imem("Imem", dir);
+
+    struct Engine {
+        const char* name;
+        function<void(BenchCore&, DataMem&)> run;
+    };
+    vector<Engine> engines = {
+        {"step()               ", [](BenchCore& c, DataMem&) { while (!c.halted) c.step(); }},
+        {"threaded             ", [](BenchCore& c, DataMem&) { while (!c.halted) c.runThreaded(UINT64_MAX); }},
+        {"blocks               ", [](BenchCore& c, DataMem&) { while (!c.halted) c.runBlocks(UINT64_MAX); }},
+        {"jit                  ", [](BenchCore& c, DataMem&) { while (!c.halted) c.runJit(UINT64_MAX); }},
+        {"jit + differential   ", [](BenchCore& c, DataMem&) {
+            c.setJitDiff(true);
+            while (!c.halted) c.runJit(UINT64_MAX);
+            if (c.getJitMismatches()) cout << "JIT mismatches: " << c.getJitMismatches() << endl;
+        }},
+    };
+
+    bool same = true;
+    double t_ref = 0;
+    vector<bitset<32>> ref_regs;
+    for (const Engine& e : engines) {
+        DataMem dmem("SS", dir);
+        BenchCore core(dir, imem, dmem);
+        core.setOutputDirectory(outDir);
+        double secs = bench::timeIt([&] { e.run(core, dmem); });
+        if (t_ref == 0) t_ref = secs;
+        cout << e.name << ": " << core.getInstructionCount() << " instrs in " << secs << " s -> "
+             << core.getInstructionCount() / secs / 1e6 << " MIPS (" << t_ref / secs << "x)" << endl;
+
+        vector<bitset<32>> regs;
+        for (int i = 0; i < 32; i++) regs.push_back(core.myRF.readRF(bitset<5>(i)));
+        if (ref_regs.empty()) ref_regs = regs;
+        same = same && regs == ref_regs;
+    }
+    cout << "results " << (same ? "match" : "DIFFER") << endl;
+    return same ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+// Five stage cycle count and host time of the interval model and of the
+// pipeline replayed from the commits, inline and decoupled on a second
+// thread, against the detailed pipeline, on the sample testcases and a long
+// loop.
+#include "decoupled.h"
+#include "bench_common.h"
+#include <cmath>
+#include <iomanip>
+
+using DetailedCore = FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>;
+
+struct Timed {
+    uint64_t cycles;
+    double secs;
+};
+
+static Timed detailed(const string& dir, InsMem& imem) {
+    DataMem dmem("FS", dir);
+    DetailedCore core(dir, imem, dmem);
+    double secs = bench::timeIt([&] { core.runUntil(StopCondition()); });
+    return {(uint64_t)core.getCycle(), secs};
+}
+
+static Timed interval(const string& dir, InsMem& imem) {
+    DataMem dmem("FS", dir);
+    IntervalCore core(dir, imem, dmem);
+    IntervalModel model;
+    double secs = bench::timeIt([&] { model = runInterval(core); });
+    return {model.cycles(), secs};
+}
+
+static Timed pipeline(const string& dir, InsMem& imem) {
+    DataMem dmem("FS", dir);
+    PipelineCore core(dir, imem, dmem);
+    PipelineTiming timing;
+    double secs = bench::timeIt([&] { timing = runPipeline(core); });
+    return {timing.cycles(), secs};
+}
+
+static Timed decoupled(const string& dir, InsMem& imem) {
+    DataMem dmem("FS", dir);
+    FrontEndCore core(dir, imem, dmem);
+    DecoupledResult result;
+    double secs = bench::timeIt([&] { result = runDecoupled(core); });
+    return {result.timing.cycles(), secs};
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t iterations = argc > 1 ? (uint32_t)stoul(argv[1]) : 500000;
+    vector<string> dirs = {
+        "Sample_Testcases_SS_FS/input/testcase0",
+        "Sample_Testcases_SS_FS/input/testcase1",
+        "Sample_Testcases_SS_FS/input/testcase2",
+        bench::makeLoopProgram("bench/bench_data/interval", iterations),
+    };
+
+    double worst = 0;
+    for (const string& dir : dirs) {
+        InsMem imem("Imem", dir);
+        Timed ref = detailed(dir, imem);
+        Timed est = interval(dir, imem);
+        Timed replay = pipeline(dir, imem);
+        Timed split = decoupled(dir, imem);
+        double error = 100.0 * fabs((double)est.cycles - (double)ref.cycles) / ref.cycles;
+        worst = max(worst, error);
+        cout << dir << ": detailed " << ref.cycles << " cycles, interval " << est.cycles
+             << " cycles, error " << fixed << setprecision(2) << error << "%";
+        cout.unsetf(ios::fixed);
+        cout << ", " << ref.secs / est.secs << "x faster; pipeline replay " << replay.cycles << " cycles, "
+             << ref.secs / replay.secs << "x faster inline, " << ref.secs / split.secs << "x decoupled";
+        if (split.cycles != replay.cycles) cout << " (" << split.cycles << " cycles)";
+        cout << endl;
+    }
+    cout << "max error " << worst << "%" << endl;
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Cost of each core policy: every configuration runs the same loop and is
+// compared against the NullTracer + NullStats + DirectMemory build of its
+// core. File tracing writes two records per cycle, so those rows run a
+// shorter loop and are compared per instruction. Final registers must agree
+// across every configuration of both cores.
+#include "core.h"
+#include "bench_common.h"
+
+struct Result {
+    string name;
+    double nsPerInstr;
+    uint64_t cycles;
+    vector<bitset<32>> regs;
+};
+
+template <class T, class S, class M>
+static void finalState(SingleStageCoreT<T, S, M>& core, Result& r) {
+    r.cycles = core.cycle;
+    for (int i = 0; i < 32; i++) r.regs.push_back(core.myRF.readRF(bitset<5>(i)));
+}
+
+template <class T, class S, class M, class H>
+static void finalState(FiveStageCoreT<T, S, M, H>& core, Result& r) {
+    r.cycles = core.getCycle();
+    for (int i = 0; i < 32; i++) r.regs.push_back(core.getRegisterFile().readRF(bitset<5>(i)));
+}
+
+// Best of reps runs to completion; instrs is the retired count of the program
+template <class CoreType>
+static Result run(const string& name, const string& dir, uint64_t instrs, int reps = 3) {
+    Result r{name, 0, 0, {}};
+    InsMem imem("Imem", dir);
+    for (int i = 0; i < reps; i++) {
+        DataMem dmem("SS", dir);
+        CoreType core(dir, imem, dmem);
+        core.setOutputDirectory(dir + "/out");
+        double secs = bench::timeIt([&] { while (!core.halted) core.step(); });
+        if (i == 0 || secs * 1e9 / instrs < r.nsPerInstr) r.nsPerInstr = secs * 1e9 / instrs;
+        if (i == 0) finalState(core, r);
+    }
+    return r;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t iterations = argc > 1 ? (uint32_t)stoul(argv[1]) : 200000;
+    uint32_t traceIterations = max<uint32_t>(iterations / 1000, 1);
+    string dir = bench::makeLoopProgram("bench/bench_data/policies", iterations);
+    string traceDir = bench::makeLoopProgram("bench/bench_data/policies_trace", traceIterations);
+    // 2 setup instructions, 8 per trip, HALT
+    uint64_t instrs = 3 + 8ull * iterations;
+    uint64_t traceInstrs = 3 + 8ull * traceIterations;
+
+    vector<Result> ss = {
+        run<SingleStageCoreT<NullTracer, NullStats, DirectMemory>>("baseline (null/null/direct)", dir, instrs),
+        run<SingleStageCoreT<NullTracer, BasicStats, DirectMemory>>("BasicStats", dir, instrs),
+        run<SingleStageCoreT<NullTracer, DetailedStats, DirectMemory>>("DetailedStats", dir, instrs),
+        run<SingleStageCoreT<NullTracer, NullStats, CheckedMemory>>("CheckedMemory", dir, instrs),
+        run<SingleStageCoreT<FinalTracer, BasicStats, DirectMemory>>("FinalTracer + BasicStats", dir, instrs),
+        run<SingleStageCoreT<NullTracer, BasicStats, DirectMemory>>("BasicStats (short loop)", traceDir, traceInstrs),
+        run<SingleStageCore>("FileTracer + BasicStats (graded)", traceDir, traceInstrs, 1),
+    };
+    vector<Result> fs = {
+        run<FiveStageCoreT<NullTracer, NullStats, DirectMemory, ForwardingHazards>>("baseline (null/null/direct/fwd)", dir, instrs),
+        run<FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>>("BasicStats", dir, instrs),
+        run<FiveStageCoreT<NullTracer, DetailedStats, DirectMemory, ForwardingHazards>>("DetailedStats", dir, instrs),
+        run<FiveStageCoreT<NullTracer, NullStats, CheckedMemory, ForwardingHazards>>("CheckedMemory", dir, instrs),
+        run<FiveStageCoreT<NullTracer, NullStats, DirectMemory, StallingHazards>>("StallingHazards", dir, instrs),
+        run<FiveStageCoreT<FinalTracer, BasicStats, DirectMemory, ForwardingHazards>>("FinalTracer + BasicStats", dir, instrs),
+        run<FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>>("BasicStats (short loop)", traceDir, traceInstrs),
+        run<FiveStageCore>("FileTracer + BasicStats (graded)", traceDir, traceInstrs, 1),
+    };
+
+    bool same = true;
+    auto report = [&](const char* title, const vector<Result>& rows) {
+        cout << title << endl;
+        for (const Result& r : rows) {
+            cout << "  " << r.name << string(34 - min<size_t>(r.name.size(), 33), ' ') << r.nsPerInstr
+                 << " ns/instr (" << r.nsPerInstr / rows[0].nsPerInstr << "x baseline), "
+                 << r.cycles << " cycles" << endl;
+            // the short loop ends with different counters, compare it to its own rows
+            const Result& ref = r.name.find("short loop") != string::npos || r.name.find("graded") != string::npos
+                                    ? rows[rows.size() - 2] : rows[0];
+            same = same && r.regs == ref.regs;
+        }
+    };
+    report("Single stage:", ss);
+    report("Five stage:", fs);
+    same = same && ss[0].regs == fs[0].regs;
+
+    // the detailed collector's view of the five stage run
+    InsMem imem("Imem", dir);
+    DataMem dmem("FS", dir);
+    FiveStageCoreT<NullTracer, DetailedStats, DirectMemory, ForwardingHazards> core(dir, imem, dmem);
+    while (!core.halted) core.step();
+    cout << "Five stage DetailedStats (" << core.getCycle() << " cycles):" << endl;
+    core.getStats().report(cout);
+
+    cout << "results " << (same ? "match" : "DIFFER") << endl;
+    return same ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#ifndef AOT_H
+#define AOT_H
+
+#include "common.h"
+#include "decoder.h"
+
+// Ahead-of-time translation of an imem program into a standalone C++ file.
+//
+// Reachable basic blocks become labelled regions of a single function whose
+// guest registers are plain locals, so the host compiler can keep them in
+// machine registers across blocks. The generated program is run as
+//     ./prog <dir containing dmem.txt> [<output dir>]
+// and writes SS_DMEMResult.txt and the final SS_RFResult.txt record in the
+// same formats as the simulator.
+
+// Writes the translated program to cppPath; returns false on I/O errors
+bool emitAotSource(const DecodedProgram& program, const string& cppPath);
+
+// Compiles cppPath with the system g++ into exePath; returns false on failure
+bool compileAotSource(const string& cppPath, const string& exePath);
+
+#endif // AOT_H
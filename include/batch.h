@@ -0,0 +1,89 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "common.h"
+#include "decoder.h"
+#include "datamem.h"
+#include "insmem.h"
+#include <memory>
+
+// ==========================================
+// LANE-BATCHED FUNCTIONAL ENGINE
+// ==========================================
+//
+// Runs one program over many data memories at once. Every lane has its own
+// registers, memory and PC. Registers and PCs are stored struct-of-arrays
+// (one row of lanes per register), memories lane after lane. Each step
+// issues the instruction at the lowest PC of any running lane to every
+// lane at that PC, eight lanes per AVX2 instruction under a lane mask.
+// Lanes that took different branches wait at their own PCs and rejoin the
+// others when those reach the same PC (min-PC reconvergence). Hosts
+// without AVX2 run the same steps lane by lane.
+//
+// A lane ends in the state of a standalone single stage run of the same
+// input. A lane's memory is a dense window of the first MemSize bytes, the
+// part SS_DMEMResult.txt holds, so lanes can be gathered from one array,
+// backed by a copy-on-write PagedMemory of the lane's input for the rest
+// of the address space. Words not wholly inside the window take a scalar
+// path byte by byte, so the lane sees the same 32-bit address space as
+// DataMem.
+
+class BatchEngine
+{
+public:
+    BatchEngine(const DecodedProgram& program, size_t lanes);
+
+    size_t lanes() const { return laneCount; }
+    void loadMemory(size_t lane, const DataMem& mem);
+    void storeMemory(size_t lane, DataMem& mem) const;
+    uint32_t readReg(size_t lane, uint32_t reg) const { return regs[reg * stride + lane]; }
+    uint32_t getPC(size_t lane) const { return pcs[lane]; }
+    bool isHalted(size_t lane) const { return !live[lane]; }
+    // Instructions executed by the lane, HALT included
+    uint64_t getInstructionCount(size_t lane) const { return folded[lane] + counts[lane]; }
+
+    // Issues up to maxSteps instructions, stopping early once every lane
+    // has executed HALT; returns the steps issued
+    uint64_t run(uint64_t maxSteps = UINT64_MAX);
+    uint64_t getSteps() const { return steps; }
+
+    static bool simdSupported();
+    // AVX2 is used whenever the host supports it, unless disabled here
+    void setSimd(bool enable) { simd = enable && simdSupported(); }
+    bool usesSimd() const { return simd; }
+
+private:
+    const DecodedProgram& program;
+    size_t laneCount;
+    size_t stride;              // lanes rounded up to a multiple of 8
+    vector<uint32_t> regs;      // 32 rows of stride lanes
+    vector<uint32_t> pcs;
+    vector<uint32_t> live;      // all ones while the lane runs
+    vector<uint32_t> counts;    // instructions since the last fold
+    vector<uint64_t> folded;
+    vector<uint32_t> memBase;   // byte offset of each lane's memory
+    vector<uint8_t> mem;
+    vector<PagedMemory> outside;  // per lane, bytes from MemSize on
+    size_t liveLanes;
+    uint64_t steps = 0;
+    uint64_t sinceFold = 0;
+    bool simd;
+
+    // Executes d for the lanes at pc; both return the lowest PC of a
+    // running lane afterwards
+    uint32_t stepScalar(const DecodedInstr& d, uint32_t pc);
+    uint32_t stepSimd(const DecodedInstr& d, uint32_t pc);
+    // Words not wholly inside the window: bytes below MemSize are in the
+    // window, the others in the lane's paged memory
+    uint32_t loadOutside(size_t lane, uint32_t addr) const;
+    void storeOutside(size_t lane, uint32_t addr, uint32_t value);
+};
+
+// Runs the program of imem once per input directory (its dmem.txt) as one
+// batch. Lane i writes SS_DMEMResult.txt and the final SS_RFResult.txt
+// record of a --no-trace run into outputDirs[i]. Returns the engine for
+// its counters.
+unique_ptr<BatchEngine> runBatch(const InsMem& imem, const vector<string>& inputDirs,
+                                 const vector<string>& outputDirs, bool simd = true);
+
+#endif // BATCH_H
@@ -0,0 +1,75 @@
+#ifndef BBV_H
+#define BBV_H
+
+#include "common.h"
+#include "isa.h"
+#include "interval.h"
+#include <unordered_map>
+
+// ==========================================
+// BASIC BLOCK VECTOR PROFILING
+// ==========================================
+//
+// Splits the commit stream into intervals of a fixed number of instructions
+// and records, per interval, how many instructions each basic block
+// executed (its basic block vector). A block is identified by the PC it was
+// entered at: the first instruction, and every one after a branch or JAL.
+// The interval model runs alongside, so every interval also gets a cheap
+// five stage cycle estimate (simpoint.h uses it for the projected error).
+
+struct BbvInterval {
+    uint64_t start;         // instructions committed before the interval
+    uint64_t instructions;  // intervalSize, except for the last interval
+    uint64_t cycles;        // interval model estimate
+    // (block index, instructions) pairs in block order
+    vector<pair<uint32_t, uint32_t>> blocks;
+};
+
+class BbvProfiler
+{
+public:
+    explicit BbvProfiler(uint64_t intervalSize = 1000000) : intervalSize(intervalSize) {}
+
+    template <class Instr>
+    void commit(const Instr& d, uint32_t pc, bool taken) {
+        if (blockEnded) {
+            block = blockIndex(pc);
+            blockEnded = false;
+        }
+        if (counts[block]++ == 0) touched.push_back(block);
+        timing.commit(d, taken);
+        blockEnded = d.flags & (BRANCH | JUMP);
+        if (++filled == intervalSize) closeInterval();
+    }
+
+    // Closes the last, partial interval
+    void finish() {
+        if (filled) closeInterval();
+    }
+
+    uint64_t getIntervalSize() const { return intervalSize; }
+    const vector<BbvInterval>& intervals() const { return done; }
+    size_t blockCount() const { return blockPCs.size(); }
+    uint32_t blockPC(uint32_t index) const { return blockPCs[index]; }
+    const IntervalModel& model() const { return timing; }
+
+private:
+    uint64_t intervalSize;
+    IntervalModel timing;
+    vector<BbvInterval> done;
+
+    unordered_map<uint32_t, uint32_t> blockIndices;  // entry PC -> index
+    vector<uint32_t> blockPCs;
+    vector<uint32_t> counts;    // of the open interval, per block index
+    vector<uint32_t> touched;   // blocks with a nonzero count
+    uint32_t block = 0;
+    bool blockEnded = true;
+    uint64_t filled = 0;
+    uint64_t committed = 0;
+    uint64_t intervalCycles = 0;  // estimate at the start of the open interval
+
+    uint32_t blockIndex(uint32_t pc);
+    void closeInterval();
+};
+
+#endif // BBV_H
@@ -0,0 +1,71 @@
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+
+#include "common.h"
+#include "decoder.h"
+#include "datamem.h"
+#include "interval.h"
+#include <memory>
+#include <unordered_map>
+
+// A translated basic block: a straight-line run of micro-ops ending at the
+// first BEQ/BNE/JAL/HALT (or after maxBlockLen instructions). Successor
+// blocks are chained directly once they have been seen, so hot loops jump
+// from block to block without going back through the cache lookup.
+//
+// Blocks are translated from the InsMem's DecodedProgram, and the simulator
+// keeps stores in the separate DataMem. For a memory that also holds code,
+// watchStores() drops the blocks a store hits; a store outside the span of
+// translated code costs one range check.
+struct TranslatedBlock {
+    uint32_t startPC;
+    uint32_t endPC;                     // exclusive, startPC + 4 * ops.size()
+    vector<DecodedInstr> ops;           // last op is the block terminator
+    TranslatedBlock* taken = nullptr;   // successor for a taken branch / JAL
+    TranslatedBlock* fallthrough = nullptr;
+    bool valid = true;                  // cleared when invalidated while running
+    uint32_t execCount = 0;             // interpreted executions, for the JIT
+    void* native = nullptr;             // JIT-compiled code, if any
+    BlockTiming timing;                 // interval model summary, without a trailing HALT
+};
+
+class BlockCache
+{
+public:
+    static const size_t maxBlockLen = 64;
+
+    explicit BlockCache(const DecodedProgram& program);
+    ~BlockCache();
+
+    // Block starting at pc, translated on first use
+    TranslatedBlock* lookup(uint32_t pc);
+
+    // Drop every block overlapping [lo, hi) and unlink all chains; they are
+    // retranslated on their next lookup. A dropped block stays allocated,
+    // marked invalid, until collect(), as an engine may still be running it.
+    void invalidate(uint32_t lo, uint32_t hi);
+    // Free blocks dropped by invalidate(); only call between blocks
+    void collect() {
+        if (!retired.empty()) retired.clear();
+    }
+
+    // Invalidate on stores into [lo, hi), for memories that also hold code
+    void watchStores(DataMem& dmem, uint32_t lo, uint32_t hi);
+
+    size_t size() const { return blocks.size(); }
+    uint64_t translations() const { return numTranslations; }
+
+private:
+    const DecodedProgram& program;
+    unordered_map<uint32_t, unique_ptr<TranslatedBlock>> blocks;
+    vector<unique_ptr<TranslatedBlock>> retired;
+    uint64_t numTranslations = 0;
+    uint32_t codeLo = UINT32_MAX;   // span of every block translated so far
+    uint32_t codeHi = 0;
+    DataMem* watchedMem = nullptr;
+    int watchId = -1;
+
+    unique_ptr<TranslatedBlock> translate(uint32_t pc);
+};
+
+#endif // BLOCKCACHE_H
@@ -7,14 +7,45 @@
 #include <bitset>
 #include <fstream>
 #include <cstdint>
+#include <cstring>
 
 using namespace std;
 
-#define MemSize 1000 // memory size, in reality, the memory size should be 2^32, but for this lab, for the space reason, we keep it as this large number, but the memory is still 32-bit addressable.
+// Bytes of the memory images the *_DMEMResult.txt dumps cover by default,
+// and the least IMem holds. DataMem itself spans the full 32-bit address
+// space (pagedmem.h).
+#define MemSize 1000
+
+// Big-endian word access on byte storage (the memory files store the most
+// significant byte first): one 32-bit load/store plus a byte swap on
+// little-endian hosts
+inline uint32_t loadBigEndian32(const uint8_t* p) {
+#if defined(__BYTE_ORDER__)
+    uint32_t w;
+    memcpy(&w, p, 4);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    w = __builtin_bswap32(w);
+#endif
+    return w;
+#else
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+#endif
+}
+
+inline void storeBigEndian32(uint8_t* p, uint32_t w) {
+#if defined(__BYTE_ORDER__)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    w = __builtin_bswap32(w);
+#endif
+    memcpy(p, &w, 4);
+#else
+    p[0] = w >> 24; p[1] = w >> 16; p[2] = w >> 8; p[3] = w;
+#endif
+}
 
 // Pipeline stage structures
 struct IFStruct {
-    bitset<32>  PC;
+    uint32_t    PC;
     bool        nop;  
 };
 
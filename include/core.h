@@ -5,37 +5,87 @@
 #include "insmem.h"
 #include "datamem.h"
 #include "registerfile.h"
+#include "blockcache.h"
+#include "jit.h"
+#include "policies.h"
+#include "tracesink.h"
+#include "runcontrol.h"
+#include <type_traits>
+
+// Raw record of one traced single stage cycle, for the trace writer
+struct SSTraceRecord {
+    uint32_t cycle;
+    IFStruct fetch;
+    uint32_t regs[32];
+};
 
 class Core {
 public:
     RegisterFile myRF;
     uint32_t cycle = 0;
-    uint32_t instruction_count = 0;
     bool halted = false;
     string ioDir;
     struct stateStruct state, nextState;
-    InsMem& ext_imem;
+    const InsMem& ext_imem;
     DataMem& ext_dmem;
+    const DecodedProgram& program;
     
-    Core(string ioDir, InsMem &imem, DataMem &dmem);
+    Core(string ioDir, const InsMem& imem, DataMem& dmem);
     virtual ~Core() = default;
     virtual void step() {}
+    // Steps in a tight loop until a stop condition holds
+    virtual RunResult runUntil(const StopCondition& stop) = 0;
     virtual void printState() {}
     virtual void setOutputDirectory(const string& outputDir);
     virtual void outputPerformanceMetrics(const string& outputDir);
+    virtual uint64_t getInstructionCount() const = 0;
     
 protected:
+    // trace files, kept open for the whole run
+    TraceSink rfSink;
+    TraceSink stateSink;
+
     virtual string getStateOutputPath() const = 0;
-    void printState(stateStruct state, int cycle);
+    // Appends the state record of one cycle to stateSink
+    void printState(const IFStruct& fetch, int cycle);
     virtual string getCoreType() const = 0;
 };
 
-class SingleStageCore : public Core {
+// Single stage core, configured by a tracer, a statistics collector and a
+// memory model (see policies.h)
+template <class Tracer, class Stats, class Memory>
+class SingleStageCoreT : public Core {
 public:
-    SingleStageCore(string ioDir, InsMem &imem, DataMem &dmem);
+    SingleStageCoreT(string ioDir, const InsMem& imem, DataMem& dmem);
     void step();
+    RunResult runUntil(const StopCondition& stop) override;
+    // Threaded-dispatch engine: executes up to maxInstrs instructions (or
+    // until halted) in one call, with output identical to repeated step()
+    uint64_t runThreaded(uint64_t maxInstrs);
+    // Basic-block engine: translated blocks are cached by start PC and
+    // chained to their successors; same output contract as runThreaded
+    uint64_t runBlocks(uint64_t maxInstrs);
+    BlockCache* getBlockCache() { return blocks.get(); }
+    // JIT engine: hot blocks run as x86-64 code, everything else (and any
+    // run with a per-cycle tracer) is interpreted. Only the final state is dumped.
+    uint64_t runJit(uint64_t maxInstrs);
+    // Check every JIT block against an interpreted shadow copy
+    void setJitDiff(bool enable);
+    uint64_t getJitMismatches() const { return jitMismatches; }
+    // nullptr until the first block is hot
+    JitEngine* getJit() { return jit.get(); }
     void printState();
     void setOutputDirectory(const string& outputDir);
+    // Waits for the trace writer and writes out both sinks. Done on halt and
+    // when the core is destroyed; a caller reading the trace files between
+    // runs calls it first.
+    void flushTrace();
+    uint64_t getInstructionCount() const override { return stats.instructions(); }
+    const Stats& getStats() const { return stats; }
+    Stats& getStats() { return stats; }
+    // PC, registers and retired count after the last executed instruction;
+    // a HALT already executed is left to the next core
+    ArchState getArchState() const;
 
 protected:
     string getStateOutputPath() const override { return opFilePath; }
@@ -45,67 +95,81 @@ private:
     stateStruct state, nextState;
     string opFilePath;
     int nopCycles = 0;
-};
+    Stats stats;
+    unique_ptr<BlockCache> blocks;
+    unique_ptr<JitEngine> jit;
+    bool jitDiff = false;
+    unique_ptr<DataMem> jitShadowMem;
+    uint32_t jitShadowRegs[32];
+    uint64_t jitMismatches = 0;
+
+    // with a per-cycle tracer the records are formatted on this writer
+    unique_ptr<TraceWriter<SSTraceRecord>> traceWriter;
 
-#include <string>
-#include <vector>
-#include <cstdint>
+    void dumpCycle();
+    // Creates ioDir and (re)opens SS_RFResult and StateResult_SS, truncated
+    void openTrace();
+    void formatCycle(const SSTraceRecord& record);
+};
 
 // ==========================================
 // PIPELINE STATE STRUCTS
 // ==========================================
+//
+// Plain trivially copyable latches: 32-bit values first, then register
+// numbers and flags as bytes, so the whole pipeline state fits in two cache
+// lines and a snapshot is a single memcpy.
 
 struct InstructionFetchState {
-    bool nop = false;
     uint32_t PC = 0;
+    bool nop = false;
 };
 
 struct InstructionDecodeState {
-    bool nop = true;
-    bool hazard_nop = false;
     uint32_t PC = 0;
     uint32_t instr = 0;
+    bool nop = true;
+    bool hazard_nop = false;
 };
 
 struct ExecutionState {
-    bool nop = true;
     uint32_t instr = 0;
     uint32_t read_data_1 = 0;
     uint32_t read_data_2 = 0;
     uint32_t imm = 0;
-    uint32_t rs = 0;
-    uint32_t rt = 0;
-    uint32_t write_reg_addr = 0;
+    uint8_t rs = 0;
+    uint8_t rt = 0;
+    uint8_t write_reg_addr = 0;
+    AluOp alu_op = AluOp::ADD;  // ADD/AND/OR/XOR, printed as the 2-bit code
+    bool nop = true;
     bool is_I_type = false;
     bool read_mem = false;
     bool write_mem = false;
-    string alu_op = "00";
     bool write_enable = false;
 };
 
 struct MemoryAccessState {
-    bool nop = true;
     uint32_t alu_result = 0;
     uint32_t store_data = 0;
-    uint32_t rs = 0;
-    uint32_t rt = 0;
-    uint32_t write_reg_addr = 0;
+    uint8_t rs = 0;
+    uint8_t rt = 0;
+    uint8_t write_reg_addr = 0;
+    bool nop = true;
     bool read_mem = false;
     bool write_mem = false;
     bool write_enable = false;
 };
 
 struct WriteBackState {
-    bool nop = true;
     uint32_t write_data = 0;
-    uint32_t rs = 0;
-    uint32_t rt = 0;
-    uint32_t write_reg_addr = 0;
+    uint8_t rs = 0;
+    uint8_t rt = 0;
+    uint8_t write_reg_addr = 0;
+    bool nop = true;
     bool write_enable = false;
 };
 
-class State_five {
-public:
+struct alignas(64) State_five {
     InstructionFetchState IF;
     InstructionDecodeState ID;
     ExecutionState EX;
@@ -113,25 +177,56 @@ public:
     WriteBackState WB;
 };
 
+static_assert(std::is_trivially_copyable<State_five>::value, "pipeline latches must stay POD");
+static_assert(sizeof(State_five) <= 128, "pipeline latches should fit in two cache lines");
+
 // ==========================================
 // STAGE CLASSES
 // ==========================================
 
 class InstructionFetchStage {
     State_five* state;
-    InsMem* ins_mem;
+    const DecodedProgram* program;
 public:
-    InstructionFetchStage(State_five* s, InsMem* im);
+    InstructionFetchStage(State_five* s, const DecodedProgram* p);
     void run();
 };
 
+// --- Hazard policies of the five stage core ---
+//
+// detect() returns where ID reads a source register from (0: register file,
+// 1: WB latch, 2: MEM latch) and sets ID.hazard_nop to stall for a cycle.
+
+// EX/MEM and MEM/WB forwarding, one stall cycle for a load-use hazard (the
+// graded model)
+struct ForwardingHazards {
+    void beginCycle(const State_five&) {}
+    int detect(State_five* state, uint32_t rs);
+    uint32_t read(State_five* state, RegisterFile* rf, uint32_t rs, int forward_signal);
+};
+
+// No bypass network: ID stalls until every producer has written back
+struct StallingHazards {
+    // whether EX/MEM run this cycle, i.e. refill the MEM/WB latches
+    bool exLive = false;
+    bool memLive = false;
+
+    void beginCycle(const State_five& s) { exLive = !s.EX.nop; memLive = !s.MEM.nop; }
+    int detect(State_five* state, uint32_t rs);
+    uint32_t read(State_five* state, RegisterFile* rf, uint32_t rs, int forward_signal);
+};
+
+template <class Hazards, class Stats>
 class InstructionDecodeStage {
     State_five* state;
     RegisterFile* rf;
+    const DecodedProgram* program;
+    Hazards* hazards;
+    Stats* stats;
 public:
-    InstructionDecodeStage(State_five* s, RegisterFile* r);
-    int detect_hazard(uint32_t rs);
-    uint32_t read_data(uint32_t rs, int forward_signal);
+    InstructionDecodeStage(State_five* s, RegisterFile* r, const DecodedProgram* p, Hazards* h, Stats* st);
+    int detect_hazard(uint32_t rs) { return hazards->detect(state, rs); }
+    uint32_t read_data(uint32_t rs, int forward_signal) { return hazards->read(state, rf, rs, forward_signal); }
     void run();
 };
 
@@ -142,6 +237,7 @@ public:
     void run();
 };
 
+template <class Memory>
 class MemoryAccessStage {
     State_five* state;
     DataMem* data_mem;
@@ -162,32 +258,147 @@ public:
 // CORE CLASS
 // ==========================================
 
-class FiveStageCore {
+// Five stage core, configured like SingleStageCoreT plus a hazard policy
+template <class Tracer, class Stats, class Memory, class Hazards>
+class FiveStageCoreT {
     State_five state;
     string ioDir;
     string opFilePath;
     
-    InsMem* ext_imem;
+    const InsMem* ext_imem;
     DataMem* ext_dmem;
     RegisterFile myRF;
+    Stats stats;
+    Hazards hazards;
 
     InstructionFetchStage if_stage;
-    InstructionDecodeStage id_stage;
+    InstructionDecodeStage<Hazards, Stats> id_stage;
     ExecutionStage ex_stage;
-    MemoryAccessStage mem_stage;
+    MemoryAccessStage<Memory> mem_stage;
     WriteBackStage wb_stage;
 
     int cycle;
-    int num_instr;
+    uint64_t fastForwarded = 0;  // instructions run before setArchState
+    // trace files, kept open for the whole run
+    TraceSink rfSink;
+    TraceSink stateSink;
+    // state record text of the last traced cycle, per pipeline latch
+    TraceSection<InstructionFetchState, 64> ifTrace;
+    TraceSection<InstructionDecodeState, 64> idTrace;
+    TraceSection<ExecutionState, 512> exTrace;
+    TraceSection<MemoryAccessState, 384> memTrace;
+    TraceSection<WriteBackState, 192> wbTrace;
+
+    // Raw record of one traced cycle; with a per-cycle tracer the records
+    // are formatted on traceWriter, declared after the sinks it writes so
+    // that it stops first
+    struct TraceRecord {
+        int cycle;
+        State_five state;
+        uint32_t regs[32];
+    };
+    unique_ptr<TraceWriter<TraceRecord>> traceWriter;
+
+    void dumpCycle(bool last);
+    void formatCycle(const TraceRecord& record);
+    // One cycle; returns whether it counted an instruction
+    bool stepCycle();
+
+    // Bubble skipping, for two kinds of cycles only. A cycle whose ID only
+    // gives up the bubble of a taken branch or JAL (the refill) runs without
+    // the hazard unit and the decoder. Once HALT is fetched, runUntil runs the
+    // drain in a loop of its own: EX, MEM and WB still step one cycle at a
+    // time, since the instructions in flight must still execute, but IF and
+    // ID are left out and the drained cycles' records go to the trace writer
+    // in one batch. Load-use stalls are single cycles and take the full
+    // stepCycle path, since which latch the forwarding unit picks depends on
+    // fields a bubble leaves behind.
+    bool bubbleSkip = true;
+    static const int maxDrainCycles = 4;  // EX, MEM, WB, then the all-nop cycle
+    bool refillCycle();
+    // Drains up to maxCycles cycles, stopping early once stop is set;
+    // returns the cycles run
+    uint64_t drain(uint64_t maxCycles, const bool& stop);
+    void openCycleTrace();
+    void fillRecord(TraceRecord& record) const;
 
 public:
     bool halted;
     
-    FiveStageCore(string ioDir, InsMem& imem, DataMem& dmem);
-    void step();
+    FiveStageCoreT(string ioDir, const InsMem& imem, DataMem& dmem);
+    // Primes the empty pipeline to fetch from s.pc with registers s.regs.
+    // Only valid before the first cycle; cycles and instructions are then
+    // counted from the hand-over on.
+    void setArchState(const ArchState& s);
+    void step() { stepCycle(); }
+    // Steps in a tight loop until a stop condition holds; the fetch PC is
+    // matched against stop.pc
+    RunResult runUntil(const StopCondition& stop);
+    // Bubble skipping is on by default; off, every cycle takes the full path
+    // (the output is the same)
+    void setBubbleSkip(bool enable) { bubbleSkip = enable; }
     bool isHalted() const;
-    void printState(State_five state, int cycle);
+    // Appends the state record of one cycle to the StateResult_FS sink;
+    // while a per-cycle trace is being written only its writer calls this
+    void printState(const State_five& state, int cycle);
     void setOutputDirectory(const string& outputDir);
+    // Waits for the trace writer and writes out both sinks; see the single
+    // stage core
+    void flushTrace();
     void outputPerformanceMetrics(const string& outputDir);
+    uint64_t getInstructionCount() const { return stats.instructions(); }
+    int getCycle() const { return cycle; }
+    const State_five& getState() const { return state; }
+    const Stats& getStats() const { return stats; }
+    RegisterFile& getRegisterFile() { return myRF; }
 };
+
+// ==========================================
+// CONFIGURATIONS
+// ==========================================
+//
+// Policy combinations built into the simulator and the benchmarks. Template
+// members are defined in the .cpp files and explicitly instantiated there for
+// every entry, so adding a configuration means adding a line here.
+
+#define SS_CORE_CONFIGS(X) \
+    X(FileTracer,  BasicStats,    DirectMemory)  \
+    X(FinalTracer, BasicStats,    DirectMemory)  \
+    X(NullTracer,  BasicStats,    DirectMemory)  \
+    X(NullTracer,  NullStats,     DirectMemory)  \
+    X(NullTracer,  DetailedStats, DirectMemory)  \
+    X(NullTracer,  NullStats,     CheckedMemory) \
+    X(NullTracer,  IntervalStats, DirectMemory)  \
+    X(NullTracer,  PipelineStats, DirectMemory)  \
+    X(NullTracer,  QueueStats,    DirectMemory)  \
+    X(NullTracer,  BbvStats,      DirectMemory)  \
+    X(NullTracer,  CacheStats,    DirectMemory)
+
+#define FS_CORE_CONFIGS(X) \
+    X(FileTracer,  BasicStats,    DirectMemory,  ForwardingHazards) \
+    X(FinalTracer, BasicStats,    DirectMemory,  ForwardingHazards) \
+    X(NullTracer,  BasicStats,    DirectMemory,  ForwardingHazards) \
+    X(NullTracer,  NullStats,     DirectMemory,  ForwardingHazards) \
+    X(NullTracer,  DetailedStats, DirectMemory,  ForwardingHazards) \
+    X(NullTracer,  NullStats,     CheckedMemory, ForwardingHazards) \
+    X(NullTracer,  NullStats,     DirectMemory,  StallingHazards)
+
+// Graded configuration: every cycle's RF/state records plus PerformanceMetrics
+using SingleStageCore = SingleStageCoreT<FileTracer, BasicStats, DirectMemory>;
+using FiveStageCore = FiveStageCoreT<FileTracer, BasicStats, DirectMemory, ForwardingHazards>;
+// --no-trace: only the final cycle's single stage records
+using FinalStateSingleStageCore = SingleStageCoreT<FinalTracer, BasicStats, DirectMemory>;
+// --timing=interval: functional core whose commits drive the interval model
+using IntervalCore = SingleStageCoreT<NullTracer, IntervalStats, DirectMemory>;
+// --timing=decoupled: functional front-end streaming its commits (decoupled.h)
+using FrontEndCore = SingleStageCoreT<NullTracer, QueueStats, DirectMemory>;
+// and its timing back-end inline on one thread
+using PipelineCore = SingleStageCoreT<NullTracer, PipelineStats, DirectMemory>;
+// --fast-forward: functional core run before the detailed window (fastforward.h)
+using FastForwardCore = SingleStageCoreT<NullTracer, BasicStats, DirectMemory>;
+// --timing=simpoint: basic block vector profiling pass (simpoint.h)
+using ProfileCore = SingleStageCoreT<NullTracer, BbvStats, DirectMemory>;
+// --cache-report: miss ratio curves of the committed accesses (reuse.h)
+using CacheCore = SingleStageCoreT<NullTracer, CacheStats, DirectMemory>;
+
 #endif // CORE_H
@@ -2,24 +2,68 @@
 #define DATAMEM_H
 
 #include "common.h"
+#include "pagedmem.h"
+#include <functional>
 
 class DataMem    
 {
 public: 
     string id, opFilePath, ioDir;
     
-    DataMem(string name, string ioDir);
+    // Loads ioDir/dmem.txt, or maps ioDir/dmem.bin (see MappedImage)
+    DataMem(string name, string ioDir, bool binaryImage = false);
+    // Copies contents and dump ranges, store watches stay with the original.
+    // The pages are shared copy-on-write, so a copy costs a page table.
+    DataMem(const DataMem& other);
+    // A copy of base (usually loaded once for several models or runs) that
+    // dumps under its own name
+    DataMem(string name, const DataMem& base);
+    // Native accessors used by the cores; words are big-endian. The whole
+    // 32-bit address space is there, zero until written.
+    uint32_t readWord(uint32_t addr) const { return DMem.readWord(addr); }
+    void writeWord(uint32_t addr, uint32_t value) {
+        DMem.writeWord(addr, value);
+        if (!writeWatches.empty()) notifyWatches(addr);
+    }
+    uint8_t readByte(uint32_t addr) const { return DMem.readByte(addr); }
+    const PagedMemory& contents() const { return DMem; }
+
+    // Pages (or 64-byte lines) stored to since loading or clearDirty()
+    vector<MemRange> dirtyRanges(bool lines = false) const { return DMem.dirtyRanges(lines); }
+    void clearDirty() { DMem.clearDirty(); }
+
+    // bitset wrappers of the above
     bitset<32> readDataMem(bitset<32> Address);
     void writeDataMem(bitset<32> Address, bitset<32> WriteData);
+    
+    // Store watches: callback(addr) runs for every store overlapping [lo, hi)
+    int addWriteWatch(uint32_t lo, uint32_t hi, function<void(uint32_t)> callback);
+    void removeWriteWatch(int id);
+    // The dumps hold the bytes of these ranges in order, one per line;
+    // the first MemSize bytes by default
+    void setDumpRanges(const vector<MemRange>& ranges) { dumpRanges = ranges; }
     void outputDataMem();
     void outputDataMem(string outputDir); 
+    // Writes the whole memory to <id>_DMEMResult.bin (PagedMemory::writeImage)
+    void outputDataImage(string outputDir);
     
     // Debug functions
     void debugPrintMemory(int start, int end);
     bitset<8> debugGetMemoryByte(int index);
 
 private:
-    vector<bitset<8>> DMem;
+    struct WriteWatch {
+        int id;
+        uint32_t lo, hi;
+        function<void(uint32_t)> callback;
+    };
+
+    PagedMemory DMem;
+    vector<MemRange> dumpRanges{{0, MemSize}};
+    vector<WriteWatch> writeWatches;
+    int nextWatchId = 0;
+    void notifyWatches(uint32_t addr);
+    void writeDump(ostream& out) const;
     string getFileSeparator();
 };
 
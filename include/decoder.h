@@ -0,0 +1,59 @@
+#ifndef DECODER_H
+#define DECODER_H
+
+#include "common.h"
+#include "isa.h"
+
+// One predecoded instruction (micro-op record)
+struct DecodedInstr {
+    uint32_t raw;       // original 32-bit encoding (needed for state dumps)
+    uint32_t target;    // PC + imm for branches/JAL, PC + 4 otherwise
+    int32_t  imm;       // sign-extended immediate of the instruction format
+    Op       op;
+    uint8_t  rd;
+    uint8_t  rs1;
+    uint8_t  rs2;
+    AluOp    alu;       // properties copied from the isaTable row
+    Cond     cond;
+    uint8_t  flags;
+};
+
+// Decode a single instruction word located at pc
+DecodedInstr decodeInstr(uint32_t instr, uint32_t pc);
+
+// ALU result of an instruction with operands a and b
+inline uint32_t aluCompute(AluOp op, uint32_t a, uint32_t b) {
+    switch (op) {
+        case AluOp::SUB: return a - b;
+        case AluOp::AND: return a & b;
+        case AluOp::OR:  return a | b;
+        case AluOp::XOR: return a ^ b;
+        default:         return a + b;
+    }
+}
+
+inline bool branchTaken(Cond cond, uint32_t a, uint32_t b) {
+    return cond == Cond::EQ ? a == b : a != b;
+}
+
+// Decoded image of the whole instruction memory, built once at load time.
+// Entry i holds the instruction at PC = 4 * i.
+class DecodedProgram
+{
+public:
+    void build(const vector<uint32_t>& words);
+
+    const DecodedInstr& at(uint32_t pc) const {
+        uint32_t idx = pc >> 2;
+        if ((pc & 3) == 0 && idx < instrs.size()) return instrs[idx];
+        return outOfRange;
+    }
+    size_t size() const { return instrs.size(); }
+
+private:
+    vector<DecodedInstr> instrs;
+    // misaligned PCs and PCs outside the image stop the core like HALT
+    DecodedInstr outOfRange{0xFFFFFFFF, 0, 0, Op::HALT, 0, 0, 0, AluOp::ADD, Cond::None, 0};
+};
+
+#endif // DECODER_H
@@ -0,0 +1,38 @@
+#ifndef DECOUPLED_H
+#define DECOUPLED_H
+
+#include "core.h"
+
+// ==========================================
+// DECOUPLED FUNCTIONAL / TIMING SIMULATION
+// ==========================================
+//
+// The functional front-end (FrontEndCore, the single stage core with
+// QueueStats) runs the program on the calling thread and pushes one
+// CommitRecord per instruction into a bounded SPSC ring. A timing back-end
+// thread pops the records and replays the five stage pipeline from them
+// (PipelineTiming), which only sees register numbers and branch outcomes,
+// never values.
+
+struct DecoupledResult {
+    PipelineTiming timing;
+    uint64_t records = 0;   // passed through the queue
+};
+
+// Runs core to completion (HALT included) with the back-end on a second
+// thread; capacityLog2 sizes the ring
+DecoupledResult runDecoupled(FrontEndCore& core, size_t capacityLog2 = 14);
+
+// The same pipeline replay on one thread, inline in the commits of the
+// threaded engine
+PipelineTiming runPipeline(PipelineCore& core);
+
+// The same on one thread, with the model inline. The first
+// intervalWarmup instructions run on the threaded engine, which commits
+// instruction by instruction and translates nothing, so a short program
+// costs less than on the pipeline; the rest runs on the JIT, which
+// commits whole blocks through their BlockTiming.
+static const uint64_t intervalWarmup = 1 << 14;
+IntervalModel runInterval(IntervalCore& core);
+
+#endif // DECOUPLED_H
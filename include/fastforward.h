@@ -0,0 +1,27 @@
+#ifndef FASTFORWARD_H
+#define FASTFORWARD_H
+
+#include "core.h"
+
+// ==========================================
+// FAST-FORWARD TO A DETAILED WINDOW
+// ==========================================
+//
+// The start of a long run is executed by FastForwardCore, the untraced
+// single stage core, and only a window after it is simulated by the five
+// stage pipeline:
+//
+//     FastForwardCore functional(ioDir, imem, dmem);
+//     fastForward(functional, StopCondition::instructions(n));
+//     FiveStageCore detailed(ioDir, imem, dmem);
+//     detailed.setArchState(functional.getArchState());
+//     detailed.runUntil(StopCondition::instructions(window));
+//
+// The detailed core's cycles, instructions and trace then cover the window
+// only.
+
+// Runs core up to `to`: its instruction limit (on the threaded engine) or
+// the next visit of its PC marker. Other conditions of `to` are ignored.
+RunResult fastForward(FastForwardCore& core, const StopCondition& to);
+
+#endif // FASTFORWARD_H
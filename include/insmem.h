@@ -2,23 +2,44 @@
 #define INSMEM_H
 
 #include "common.h"
+#include "decoder.h"
+#include "pagedmem.h"
 
+// Instruction memory. Everything is loaded and predecoded by the
+// constructor and never changes afterwards, so one InsMem is shared
+// read-only by cores running on different threads.
 class InsMem
 {
 public:
-    string id, ioDir;
+    const string id, ioDir;
     
-    InsMem(string name, string ioDir);
-    bitset<32> readInstr(bitset<32> ReadAddress);
+    // Loads ioDir/imem.txt, or maps ioDir/imem.bin (see MappedImage)
+    InsMem(string name, string ioDir, bool binaryImage = false);
+    // Big-endian instruction word at addr; zero past the loaded bytes
+    uint32_t readWord(uint32_t addr) const {
+        if ((size_t)addr + 4 <= byteCount) return loadBigEndian32(bytes() + addr);
+        uint32_t w = 0;
+        for (uint32_t i = 0; i < 4; i++) w = (w << 8) | byteAt((size_t)addr + i);
+        return w;
+    }
+    // bitset wrapper of readWord
+    bitset<32> readInstr(bitset<32> ReadAddress) const;
+    const DecodedProgram& getProgram() const { return program; }
     
     // Debug functions
-    void debugPrintMemory(int start, int end);
-    size_t debugGetMemorySize();
-    bitset<8> debugGetMemoryByte(int index);
+    void debugPrintMemory(int start, int end) const;
+    size_t debugGetMemorySize() const;
+    bitset<8> debugGetMemoryByte(int index) const;
     
 private:
-    vector<bitset<8>> IMem;
-    string getFileSeparator();
+    vector<uint8_t> IMem;              // the bytes of imem.txt
+    shared_ptr<MappedImage> image;     // or the mapping of imem.bin, read in place
+    size_t byteCount = 0;              // bytes loaded
+    size_t imageSize = 0;              // whole words, at least MemSize bytes
+    DecodedProgram program;  // predecoded at load time, shared by both cores
+    const uint8_t* bytes() const { return image ? image->data() : IMem.data(); }
+    uint8_t byteAt(size_t addr) const { return addr < byteCount ? bytes()[addr] : 0; }
+    string getFileSeparator() const;
 };
 
 #endif // INSMEM_H
\ No newline at end of file
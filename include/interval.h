@@ -0,0 +1,130 @@
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include "common.h"
+#include "decoder.h"
+#include <algorithm>
+
+// ==========================================
+// INTERVAL TIMING MODEL
+// ==========================================
+//
+// Estimates the cycle count of the five stage pipeline (ForwardingHazards)
+// from the committed instruction stream of a functional core. Every
+// instruction takes one cycle in ID, plus the miss events of the detailed
+// model:
+//   - load-use: the previous instruction is a LW whose rd the current one
+//     reads (one stall, as in ForwardingHazards::detect). As there, the
+//     MEM/WB forward wins when the instruction before the LW wrote the same
+//     register, and then there is no stall.
+//   - redirect: a taken branch or JAL resolved in ID (one bubble)
+// Branches never enter EX, so the pipeline drains four cycles after the
+// last instruction that did, plus the all-nop cycle that stops the core.
+
+// Timing of a straight-line block, which is the same on every execution
+// except for a load-use stall of its first instruction and the redirect of
+// its last one. Built once per translated block (blockcache.h).
+struct BlockTiming {
+    uint32_t count = 0;         // instructions summarized
+    uint32_t innerStalls = 0;   // load-use stalls between them
+    uint32_t lastOffset = 0;    // ID cycle of the last one, from the first
+    int32_t exOffset = -1;      // ID cycle of the last one entering EX, or -1
+    uint8_t firstRs1 = 0;       // source registers of the first one (0: none)
+    uint8_t firstRs2 = 0;
+    uint8_t loadRd = 0;         // rd of the last one if it is a LW
+    uint8_t entryShadow = 0;    // rd of a leading LW whose stall depends on the entry state
+    uint8_t exCount = 0;        // instructions entering EX, at most 2
+    uint8_t exRd = 0;           // and the rd of the last two of them
+    uint8_t exRd2 = 0;
+    uint8_t lastFlags = 0;
+
+    // ops of the block without a trailing HALT
+    static BlockTiming of(const DecodedInstr* ops, size_t n);
+};
+
+class IntervalModel
+{
+public:
+    // Instruction d (a DecodedInstr or a CommitRecord, anything with op,
+    // flags and register numbers); taken is set for a taken branch and JAL
+    template <class Instr>
+    void commit(const Instr& d, bool taken) {
+        instrs++;
+        uint64_t id = nextID;
+        if (loadUse(d.flags & READS_RS1 ? d.rs1 : 0, d.flags & READS_RS2 ? d.rs2 : 0)) {
+            id++;
+            stalls++;
+        }
+        if (d.op == Op::HALT) {
+            // IF fetches HALT while the instruction before it is in ID
+            total = max(lastEX + 5, id + 1);
+            return;
+        }
+        if (!(d.flags & BRANCH)) {
+            lastEX = id;
+            exRd2 = exRd;
+            exRd = (d.flags & WRITES_RD) ? d.rd : 0;
+        }
+        // the pipeline flushes on every taken branch, even one to PC + 4
+        bool redirect = taken && (d.flags & (BRANCH | JUMP));
+        redirects += redirect;
+        nextID = id + 1 + redirect;
+        loadRd = (d.flags & MEM_READ) ? d.rd : 0;
+    }
+
+    // All instructions of a block summarized by BlockTiming::of; taken
+    // applies to its last one
+    void commit(const BlockTiming& t, bool taken) {
+        if (t.count == 0) return;
+        instrs += t.count;
+        uint64_t id = nextID;
+        if (loadUse(t.firstRs1, t.firstRs2)) {
+            id++;
+            stalls++;
+        }
+        // the second instruction's stall on a leading LW is forwarded away
+        // when the LW's rd was also written by the instruction before it
+        uint32_t skipped = (t.entryShadow != 0 && t.entryShadow == exRd);
+        stalls += t.innerStalls - skipped;
+        if (t.exOffset >= 0) lastEX = id + t.exOffset - (t.exOffset > 0 ? skipped : 0);
+        bool redirect = taken && (t.lastFlags & (BRANCH | JUMP));
+        redirects += redirect;
+        nextID = id + t.lastOffset - skipped + 1 + redirect;
+        loadRd = t.loadRd;
+        if (t.exCount >= 2) exRd2 = t.exRd2;
+        else if (t.exCount == 1) exRd2 = exRd;
+        if (t.exCount >= 1) exRd = t.exRd;
+    }
+
+    // Final cycle count once HALT has committed, the estimate so far before
+    uint64_t cycles() const { return total ? total : lastEX + 5; }
+    uint64_t instructions() const { return instrs; }
+    uint64_t loadUseStalls() const { return stalls; }
+    uint64_t redirectBubbles() const { return redirects; }
+
+    // Appends a "Performance of Five Stage" record like
+    // FiveStageCoreT::outputPerformanceMetrics, marked as an estimate
+    void outputPerformanceMetrics(const string& outputDir) const;
+
+private:
+    friend struct BlockTiming;
+
+    uint64_t instrs = 0;
+    uint64_t stalls = 0;
+    uint64_t redirects = 0;
+    uint64_t nextID = 1;    // cycle the next instruction reaches ID
+    uint64_t lastEX = 0;    // ID cycle of the last instruction that enters EX
+    uint64_t total = 0;
+    uint8_t loadRd = 0;     // rd of the previous instruction if it was a LW
+    uint8_t exRd = 0;       // rd of the last two instructions that entered EX
+    uint8_t exRd2 = 0;      // (0 if they do not write one)
+
+    // Whether reading rs1/rs2 (0: not read) stalls on the previous LW; the
+    // WB latch then holds the instruction that entered EX before the LW
+    bool loadUse(uint8_t rs1, uint8_t rs2) const {
+        if (loadRd == 0) return false;
+        return (rs1 == loadRd && rs1 != exRd2) || (rs2 == loadRd && rs2 != exRd2);
+    }
+};
+
+#endif // INTERVAL_H
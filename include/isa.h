@@ -0,0 +1,143 @@
+#ifndef ISA_H
+#define ISA_H
+
+#include <array>
+#include <cstdint>
+
+// ==========================================
+// ISA DESCRIPTION
+// ==========================================
+//
+// The supported RV32I subset is described once, in isaTable below. The
+// decoder lookup table is generated from it at compile time, and both cores
+// execute from the per-instruction properties (ALU op, operand format,
+// memory/branch flags) instead of their own opcode/funct3 if chains.
+// Adding an instruction means adding an Op and one table row.
+
+// Operations of the RV32I subset supported by the simulator
+enum class Op : uint8_t {
+    ADD, SUB, XOR, OR, AND,     // R-type
+    ADDI, XORI, ORI, ANDI,      // I-type arithmetic
+    LW,                         // Load
+    SW,                         // Store
+    BEQ, BNE,                   // Branch
+    JAL,                        // Jump
+    HALT,                       // 0xFFFFFFFF
+    NOP                         // any other encoding, only advances PC
+};
+
+// Operand/immediate layout of an encoding
+enum class Format : uint8_t { R, I, S, B, J, None };
+
+// ALU operation of the execute stage. The numeric values are the two-bit
+// alu_op codes of the five stage model (SUB runs as ADD of the negated
+// operand there).
+enum class AluOp : uint8_t { ADD = 0, AND = 1, OR = 2, XOR = 3, SUB = 4 };
+
+// Comparison of a conditional branch
+enum class Cond : uint8_t { None, EQ, NE };
+
+// Instruction property flags
+enum : uint8_t {
+    READS_RS1   = 1 << 0,
+    READS_RS2   = 1 << 1,
+    WRITES_RD   = 1 << 2,
+    IMM_OPERAND = 1 << 3,   // ALU operand 2 is the immediate
+    MEM_READ    = 1 << 4,
+    MEM_WRITE   = 1 << 5,
+    BRANCH      = 1 << 6,
+    JUMP        = 1 << 7,
+};
+
+struct InstrSpec {
+    const char* name;
+    uint32_t mask;      // bits that identify the instruction
+    uint32_t match;     // value of those bits
+    Op op;
+    Format format;
+    AluOp alu;
+    Cond cond;
+    uint8_t flags;
+};
+
+// Masks follow the simulator's historical decoding: XOR/OR/AND and their
+// immediate forms ignore funct7, LW/SW ignore funct3.
+constexpr InstrSpec isaTable[] = {
+    // name    mask        match       op        format       alu         cond       flags
+    {"add",  0xFE00707F, 0x00000033, Op::ADD,  Format::R,    AluOp::ADD, Cond::None, READS_RS1 | READS_RS2 | WRITES_RD},
+    {"sub",  0xFE00707F, 0x40000033, Op::SUB,  Format::R,    AluOp::SUB, Cond::None, READS_RS1 | READS_RS2 | WRITES_RD},
+    {"xor",  0x0000707F, 0x00004033, Op::XOR,  Format::R,    AluOp::XOR, Cond::None, READS_RS1 | READS_RS2 | WRITES_RD},
+    {"or",   0x0000707F, 0x00006033, Op::OR,   Format::R,    AluOp::OR,  Cond::None, READS_RS1 | READS_RS2 | WRITES_RD},
+    {"and",  0x0000707F, 0x00007033, Op::AND,  Format::R,    AluOp::AND, Cond::None, READS_RS1 | READS_RS2 | WRITES_RD},
+    {"addi", 0x0000707F, 0x00000013, Op::ADDI, Format::I,    AluOp::ADD, Cond::None, READS_RS1 | WRITES_RD | IMM_OPERAND},
+    {"xori", 0x0000707F, 0x00004013, Op::XORI, Format::I,    AluOp::XOR, Cond::None, READS_RS1 | WRITES_RD | IMM_OPERAND},
+    {"ori",  0x0000707F, 0x00006013, Op::ORI,  Format::I,    AluOp::OR,  Cond::None, READS_RS1 | WRITES_RD | IMM_OPERAND},
+    {"andi", 0x0000707F, 0x00007013, Op::ANDI, Format::I,    AluOp::AND, Cond::None, READS_RS1 | WRITES_RD | IMM_OPERAND},
+    {"lw",   0x0000007F, 0x00000003, Op::LW,   Format::I,    AluOp::ADD, Cond::None, READS_RS1 | WRITES_RD | IMM_OPERAND | MEM_READ},
+    {"sw",   0x0000007F, 0x00000023, Op::SW,   Format::S,    AluOp::ADD, Cond::None, READS_RS1 | READS_RS2 | IMM_OPERAND | MEM_WRITE},
+    {"beq",  0x0000707F, 0x00000063, Op::BEQ,  Format::B,    AluOp::ADD, Cond::EQ,   READS_RS1 | READS_RS2 | BRANCH},
+    {"bne",  0x0000707F, 0x00001063, Op::BNE,  Format::B,    AluOp::ADD, Cond::NE,   READS_RS1 | READS_RS2 | BRANCH},
+    {"jal",  0x0000007F, 0x0000006F, Op::JAL,  Format::J,    AluOp::ADD, Cond::None, WRITES_RD | JUMP},
+    {"halt", 0xFFFFFFFF, 0xFFFFFFFF, Op::HALT, Format::None, AluOp::ADD, Cond::None, 0},
+    {"nop",  0x00000000, 0x00000000, Op::NOP,  Format::None, AluOp::ADD, Cond::None, 0},
+};
+
+constexpr size_t isaTableSize = sizeof(isaTable) / sizeof(isaTable[0]);
+constexpr uint8_t nopSpec = isaTableSize - 1;
+
+constexpr const InstrSpec& specOf(Op op) { return isaTable[(size_t)op]; }
+
+// Rows must be in Op order so specOf() is a plain index
+constexpr bool isaTableInOpOrder() {
+    for (size_t i = 0; i < isaTableSize; i++) {
+        if ((size_t)isaTable[i].op != i) return false;
+    }
+    return true;
+}
+static_assert(isaTableInOpOrder(), "isaTable rows must follow the Op enum order");
+
+// ==========================================
+// GENERATED DECODE TABLE
+// ==========================================
+//
+// A key of opcode[6:2] | funct3 | instr[30] selects at most one candidate
+// row per encoding (checked below); decode then verifies that row's full
+// mask/match and falls back to NOP.
+
+constexpr uint32_t decodeKey(uint32_t instr) {
+    return ((instr >> 2) & 0x1F) | (((instr >> 12) & 0x7) << 5) | (((instr >> 30) & 0x1) << 8);
+}
+
+constexpr bool rowMatchesKey(uint32_t row, uint32_t key) {
+    uint32_t keyMask = decodeKey(isaTable[row].mask);
+    return (key & keyMask) == (decodeKey(isaTable[row].match) & keyMask);
+}
+
+constexpr std::array<uint8_t, 512> buildDecodeTable() {
+    std::array<uint8_t, 512> table{};
+    for (uint32_t key = 0; key < 512; key++) {
+        table[key] = nopSpec;
+        for (uint32_t row = 0; row < nopSpec; row++) {
+            if (rowMatchesKey(row, key)) {
+                table[key] = (uint8_t)row;
+                break;
+            }
+        }
+    }
+    return table;
+}
+
+// Two rows sharing a key would need more than one lookup to tell apart
+constexpr bool decodeKeysUnambiguous() {
+    for (uint32_t key = 0; key < 512; key++) {
+        int rows = 0;
+        for (uint32_t row = 0; row < nopSpec; row++) rows += rowMatchesKey(row, key);
+        if (rows > 1) return false;
+    }
+    return true;
+}
+static_assert(decodeKeysUnambiguous(), "isaTable rows overlap in the decode key");
+
+constexpr std::array<uint8_t, 512> decodeTable = buildDecodeTable();
+
+#endif // ISA_H
@@ -0,0 +1,64 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "common.h"
+#include "datamem.h"
+#include "blockcache.h"
+
+// x86-64 dynamic binary translator for the single stage functional path.
+//
+// Hot TranslatedBlocks are compiled into native code in an mmap'd buffer.
+// A compiled block has the signature
+//     uint32_t block(uint32_t* regs, JitContext* ctx)
+// and returns the next guest PC. Guest registers live in the host array
+// `regs`. LW/SW call the core's memory model (Memory::load/store, see
+// policies.h) directly, with a rel32 call when the code buffer could be
+// placed within 2 GiB of it. With inlineLoads (plain DirectMemory) an LW
+// first probes the PagedMemory TLB itself and only calls on a miss. Blocks ending in HALT are compiled without
+// the HALT, which is left to the interpreter. On other hosts available()
+// is false and everything stays interpreted.
+
+struct JitContext {
+    DataMem* dmem;
+};
+
+typedef uint32_t (*JitBlockFn)(uint32_t* regs, JitContext* ctx);
+typedef uint32_t (*JitLoadFn)(DataMem& mem, uint32_t addr);
+typedef void (*JitStoreFn)(DataMem& mem, uint32_t addr, uint32_t value);
+
+class JitEngine
+{
+public:
+    static const uint32_t hotThreshold = 16;      // interpreted runs before compiling
+    static const size_t codeBufferSize = 16 << 20;
+
+    JitEngine(DataMem& dmem, JitLoadFn load, JitStoreFn store, bool inlineLoads);
+    ~JitEngine();
+    JitEngine(const JitEngine&) = delete;
+    JitEngine& operator=(const JitEngine&) = delete;
+
+    static bool available();
+
+    // Native code for the first n ops of the block, or nullptr if it cannot
+    // be translated (unsupported host, buffer full)
+    JitBlockFn compile(const TranslatedBlock& block, size_t n);
+    JitContext* context() { return &ctx; }
+
+    uint64_t compiledBlocks() const { return numCompiled; }
+    size_t codeBytes() const { return used; }
+    // Whether LW/SW reach the memory model with rel32 calls
+    bool nearCalls() const;
+
+private:
+    JitContext ctx;
+    JitLoadFn load;
+    JitStoreFn store;
+    bool inlineLoads;
+    uint8_t* code = nullptr;
+    size_t used = 0;
+    uint64_t numCompiled = 0;
+
+    bool setWritable(bool writable);
+};
+
+#endif // JIT_H
@@ -0,0 +1,182 @@
+#ifndef PAGEDMEM_H
+#define PAGEDMEM_H
+
+#include "common.h"
+#include <array>
+#include <atomic>
+#include <memory>
+
+// [lo, hi) byte range of the 32-bit address space
+struct MemRange {
+    uint32_t lo;
+    uint64_t hi;
+};
+
+// ==========================================
+// BINARY MEMORY IMAGES
+// ==========================================
+//
+// A binary image holds the bytes of a memory from address 0, without any
+// header. MappedImage maps one read-only: reads come straight from the page
+// cache, and PagedMemory copies a page before its first store, so the file
+// is never modified.
+
+class MappedImage
+{
+public:
+    // Throws runtime_error if the file cannot be opened or mapped
+    explicit MappedImage(const string& path);
+    ~MappedImage();
+    MappedImage(const MappedImage&) = delete;
+    MappedImage& operator=(const MappedImage&) = delete;
+
+    uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+    // Bytes mapped: the size rounded up to whole PagedMemory pages
+    size_t mappedSize() const { return mapped; }
+
+private:
+    uint8_t* base = nullptr;
+    size_t length = 0;
+    size_t mapped = 0;
+};
+
+// Converts a text image (one 8-bit binary number per line, as imem.txt and
+// dmem.txt) to a binary one; returns false if either file cannot be opened
+bool convertTextImage(const string& textPath, const string& binaryPath);
+
+// ==========================================
+// SPARSE PAGED ADDRESS SPACE
+// ==========================================
+//
+// A byte-addressed memory covering the whole 32-bit address space. A two
+// level page table (1024 tables of 1024 pages of 4 KiB) maps pages only
+// when they are first written; reads of unmapped memory return zero.
+// The page of the last access is cached in a one-entry soft TLB, so an
+// aligned access on the same page as the previous one costs a compare and
+// a load. Words crossing a page boundary and TLB misses take the slow path.
+// Words are big-endian and wrap around at the top of the address space.
+//
+// Pages are copy-on-write. Copying a PagedMemory shares every page with
+// the original under an atomic reference count, and whichever side stores
+// to a shared page first copies it. A parsed dmem.txt is therefore loaded
+// once and every model or run starts from a copy, costing a page table
+// plus one private page per page it writes. Copies may be used on
+// different threads. The pages of an attached MappedImage are entered
+// into the table without being read and are never written in place.
+//
+// Every store also marks its 64-byte lines dirty, in one 64-bit mask per
+// page, and a page's first store since the last clearDirty() appends it to
+// a list. The TLB only takes writes for pages already on the list, so the
+// fast path just ORs two bits into the cached mask. Dumps, checkpoints and
+// comparisons can then visit the modified pages or lines alone.
+
+class PagedMemory
+{
+public:
+    static constexpr uint32_t PageBits = 12;
+    static constexpr uint32_t PageSize = 1u << PageBits;
+    static constexpr uint32_t PageMask = PageSize - 1;
+    static constexpr uint32_t LineBits = 6;  // dirty granularity within a page
+    static constexpr uint32_t LineSize = 1u << LineBits;
+
+    PagedMemory() = default;
+    // Shares every page with other until one of them stores to it
+    PagedMemory(const PagedMemory& other);
+    PagedMemory& operator=(const PagedMemory& other);
+    ~PagedMemory();
+
+    uint32_t readWord(uint32_t addr) const {
+        uint32_t offset = addr & PageMask;
+        if ((addr >> PageBits) == tlbRead && offset <= PageSize - 4) return loadBigEndian32(tlbData + offset);
+        return readWordSlow(addr);
+    }
+    void writeWord(uint32_t addr, uint32_t value) {
+        uint32_t offset = addr & PageMask;
+        if ((addr >> PageBits) == tlbWrite && offset <= PageSize - 4) {
+            storeBigEndian32(tlbData + offset, value);
+            *tlbDirty |= (1ull << (offset >> LineBits)) | (1ull << ((offset + 3) >> LineBits));
+            return;
+        }
+        writeWordSlow(addr, value);
+    }
+    uint8_t readByte(uint32_t addr) const;
+    void writeByte(uint32_t addr, uint8_t value);
+
+    // Where the TLB's read side lives, for generated code that repeats the
+    // readWord fast path inline: a word at addr with addr >> PageBits equal
+    // to *readPage and (addr & PageMask) <= PageSize - 4 is the big-endian
+    // word at *data + (addr & PageMask). Stable while this memory lives.
+    struct TlbProbe {
+        const uint32_t* readPage;
+        uint8_t* const* data;
+    };
+    TlbProbe tlbProbe() const { return {&tlbRead, &tlbData}; }
+
+    // Replaces the contents with the image, from address 0
+    void attachImage(shared_ptr<MappedImage> image);
+    // Writes every mapped page to a binary image at its address; unmapped
+    // pages below the last one become holes of a sparse file. The file is
+    // as long as the attached image or the last mapped page, whichever
+    // ends later. With dirtyOnly, only the dirty pages are written into the
+    // existing file, which brings a dump taken at the last clearDirty() up
+    // to date. Returns false on an I/O error.
+    bool writeImage(const string& path, bool dirtyOnly = false) const;
+
+    // Sorted, coalesced ranges of the pages (or, with lines, the 64-byte
+    // lines) stored to since the last clearDirty()
+    vector<MemRange> dirtyRanges(bool lines = false) const;
+    size_t dirtyPageCount() const { return dirtyList.size(); }
+    void clearDirty();
+
+    size_t mappedPages() const { return pages; }
+    // Mapped pages not shared with another memory or an image
+    size_t privatePages() const;
+    // Lowest address whose byte differs from other's, or -1 if none;
+    // unmapped pages compare as zeros
+    int64_t firstDifference(const PagedMemory& other) const;
+    // The same, looking only at lines dirty in either memory. Exact when
+    // both were equal at their last clearDirty(), or one is a copy of the
+    // other (dirty state included) and neither was cleared since.
+    int64_t firstDirtyDifference(const PagedMemory& other) const;
+
+private:
+    static constexpr uint32_t TableBits = 10;
+    static constexpr uint32_t TableMask = (1 << TableBits) - 1;
+    static constexpr uint32_t NoPage = UINT32_MAX;  // above every page number
+    // A heap page and the number of tables holding it
+    struct Page {
+        atomic<uint32_t> refs{1};
+        uint8_t bytes[PageSize];
+    };
+    struct Table {
+        array<uint8_t*, 1 << TableBits> pages{};  // bytes of owners, or in the image
+        array<Page*, 1 << TableBits> owners{};    // nullptr for image pages
+        array<uint64_t, 1 << TableBits> dirty{};  // line masks
+    };
+
+    array<unique_ptr<Table>, 1 << TableBits> directory;
+    shared_ptr<MappedImage> image;
+    size_t pages = 0;
+    vector<uint32_t> dirtyList;  // page numbers with a nonzero mask
+
+    // One-entry TLB. tlbData is the page of tlbRead, which is also in
+    // tlbWrite, with its mask in tlbDirty, once it is dirty and private; an
+    // unmapped page is read from zeroPage. Copying a memory clears the
+    // original's tlbWrite, since its pages become shared.
+    mutable uint32_t tlbRead = NoPage;
+    mutable uint32_t tlbWrite = NoPage;
+    mutable uint8_t* tlbData = nullptr;
+    mutable uint64_t* tlbDirty = nullptr;
+
+    const uint8_t* findPage(uint32_t page) const;  // nullptr if unmapped
+    uint64_t dirtyMask(uint32_t page) const;
+    void fillWriteTlb(uint32_t page);
+    static bool isPrivate(const Page* owner);
+    static void release(Page* owner);
+    void clear();
+    uint32_t readWordSlow(uint32_t addr) const;
+    void writeWordSlow(uint32_t addr, uint32_t value);
+};
+
+#endif // PAGEDMEM_H
@@ -0,0 +1,163 @@
+#ifndef PIPETIMING_H
+#define PIPETIMING_H
+
+#include "common.h"
+#include "decoder.h"
+
+// ==========================================
+// PIPELINE TIMING MODEL
+// ==========================================
+//
+// The five stage pipeline (ForwardingHazards) replayed cycle by cycle from
+// the committed instruction stream of a functional core, without an ALU,
+// register file or data memory. Each latch keeps only what the stage logic
+// and the forwarding unit look at: the nop flags, the destination register,
+// write_enable and read_mem. Those fields are updated exactly as in the
+// stages of core.cpp, including the stale values a bubble leaves behind, and
+// branch outcomes come from the commits instead of the register values. IF
+// only ever fetches the next committed instruction (ID resolves branches
+// before IF runs), so the cycle count is that of FiveStageCoreT whenever
+// both take the same path.
+
+class PipelineTiming
+{
+public:
+    // Instruction d (a DecodedInstr or a CommitRecord); taken is set for a
+    // taken branch and JAL. Runs the pipeline until IF has fetched d, and
+    // after HALT until the pipeline has drained.
+    template <class Instr>
+    void commit(const Instr& d, bool taken) {
+        next = {d.op, d.flags, d.rd, d.rs1, d.rs2, taken};
+        pending = true;
+        while (pending) cycle();
+        if (d.op == Op::HALT) {
+            while (!halted) cycle();
+        }
+    }
+
+    uint64_t cycles() const { return cycleCount; }
+    uint64_t instructions() const { return fetched; }
+    uint64_t stalls() const { return stallCount; }
+    uint64_t flushes() const { return flushCount; }
+    bool isHalted() const { return halted; }
+
+    // Appends a "Performance of Five Stage" record like
+    // FiveStageCoreT::outputPerformanceMetrics, marked as a timing model
+    void outputPerformanceMetrics(const string& outputDir) const;
+
+private:
+    struct Slot {
+        Op op = Op::NOP;
+        uint8_t flags = 0;
+        uint8_t rd = 0;
+        uint8_t rs1 = 0;
+        uint8_t rs2 = 0;
+        bool taken = false;
+    };
+    // EX, MEM and WB latches: destination register and the flags read by
+    // the next stage or by the forwarding unit
+    struct Latch {
+        uint8_t rd = 0;
+        bool nop = true;
+        bool writeEnable = false;
+        bool readMem = false;
+    };
+
+    Slot next;              // the instruction IF fetches next
+    Slot id;                // the instruction in ID
+    Latch ex, mem, wb;
+    bool pending = false;   // next not fetched yet
+    bool ifNop = false;
+    bool idNop = true;
+    bool hazardNop = false;
+    bool halted = false;
+    uint64_t cycleCount = 0;
+    uint64_t fetched = 0;
+    uint64_t stallCount = 0;
+    uint64_t flushCount = 0;
+
+    // ForwardingHazards::detect without the operand selection: a stall
+    // unless the MEM latch holds no load of rs or the WB latch forwards it
+    bool loadUse(uint8_t rs) const {
+        return rs != 0 && rs == mem.rd && mem.readMem && !(rs == wb.rd && wb.writeEnable);
+    }
+
+    // One cycle of FiveStageCoreT::stepCycle, stages in reverse order
+    void cycle() {
+        bool allNop = ifNop && idNop && ex.nop && mem.nop && wb.nop;
+
+        if (wb.nop) {
+            if (!mem.nop) wb.nop = false;
+        } else if (mem.nop) {
+            wb.nop = true;
+        }
+
+        if (mem.nop) {
+            if (!ex.nop) mem.nop = false;
+        } else {
+            wb.rd = mem.rd;
+            wb.writeEnable = mem.writeEnable;
+            if (ex.nop) mem.nop = true;
+        }
+
+        if (ex.nop) {
+            if (!idNop) ex.nop = false;
+        } else {
+            mem.rd = ex.rd;
+            mem.writeEnable = ex.writeEnable;
+            mem.readMem = ex.readMem;
+            if (idNop) ex.nop = true;
+        }
+
+        if (idNop) {
+            if (!ifNop) idNop = false;
+        } else {
+            decode();
+        }
+
+        if (!(ifNop || idNop || (hazardNop && ex.nop))) {
+            pending = false;
+            fetched++;
+            if (next.op == Op::HALT) {
+                ifNop = true;
+                idNop = true;
+            } else {
+                id = next;
+            }
+        }
+
+        cycleCount++;
+        if (allNop) halted = true;
+    }
+
+    void decode() {
+        ex.rd = 0;
+        ex.writeEnable = false;
+        ex.readMem = false;
+        hazardNop = ((id.flags & READS_RS1) && loadUse(id.rs1)) || ((id.flags & READS_RS2) && loadUse(id.rs2));
+        if (hazardNop) {
+            stallCount++;
+            ex.nop = true;
+            return;
+        }
+        if (id.flags & WRITES_RD) {
+            ex.rd = id.rd;
+            ex.writeEnable = true;
+        }
+        ex.readMem = id.flags & MEM_READ;
+
+        if (id.flags & BRANCH) {
+            if (id.taken) {
+                idNop = true;
+                flushCount++;
+            }
+            ex.nop = true;
+        } else if (id.flags & JUMP) {
+            idNop = true;
+            flushCount++;
+        }
+        if (ifNop) idNop = true;
+    }
+};
+
+#endif // PIPETIMING_H
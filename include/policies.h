@@ -0,0 +1,201 @@
+#ifndef POLICIES_H
+#define POLICIES_H
+
+#include "common.h"
+#include "isa.h"
+#include "decoder.h"
+#include "datamem.h"
+#include "interval.h"
+#include "pipetiming.h"
+#include "bbv.h"
+#include "reuse.h"
+#include "spscqueue.h"
+#include <stdexcept>
+
+// ==========================================
+// CORE POLICIES
+// ==========================================
+//
+// SingleStageCoreT/FiveStageCoreT are configured at compile time with the
+// policies below. Everything a disabled policy would do is dropped through
+// `if constexpr` or empty inline members, so a NullTracer + NullStats core
+// has no tracing or statistics code in its step loop at all. The hazard
+// policies of the five stage core live in core.h next to the pipeline latches.
+
+// --- Tracers: which cycles write the RF/state records ---
+
+// Every cycle (the graded output)
+struct FileTracer {
+    static constexpr bool everyCycle = true;
+    static constexpr bool finalCycle = false;
+};
+
+// Only the last cycle, replacing the records of earlier runs (--no-trace)
+struct FinalTracer {
+    static constexpr bool everyCycle = false;
+    static constexpr bool finalCycle = true;
+};
+
+// Nothing
+struct NullTracer {
+    static constexpr bool everyCycle = false;
+    static constexpr bool finalCycle = false;
+};
+
+// --- Statistics collectors ---
+//
+// retire() counts instructions; collectors with `commits` set also get
+// commit(d, pc, memAddr, taken) for every instruction of the single stage
+// core in program order. memAddr is the address of a LW/SW (unspecified
+// for other instructions) and taken marks a taken branch or a JAL. With
+// `commitsBlocks` the JIT commits whole blocks through
+// commit(const BlockTiming&, taken); without it a committing collector
+// keeps runJit on the block interpreter.
+
+struct NullStats {
+    static constexpr bool enabled = false;
+    static constexpr bool commits = false;
+    static constexpr bool commitsBlocks = false;
+    void retire(Op) {}
+    void retire(const DecodedInstr*, size_t) {}
+    void commit(const DecodedInstr&, uint32_t, uint32_t, bool) {}
+    void stall() {}
+    void flush() {}
+    uint64_t instructions() const { return 0; }
+    void report(ostream&) const {}
+};
+
+// Retired instruction count for PerformanceMetrics.txt
+struct BasicStats {
+    static constexpr bool enabled = true;
+    static constexpr bool commits = false;
+    static constexpr bool commitsBlocks = false;
+    uint64_t retired = 0;
+
+    void retire(Op) { retired++; }
+    void retire(const DecodedInstr*, size_t n) { retired += n; }
+    void commit(const DecodedInstr&, uint32_t, uint32_t, bool) {}
+    void stall() {}
+    void flush() {}
+    uint64_t instructions() const { return retired; }
+    void report(ostream&) const {}
+};
+
+// Instruction mix plus pipeline stalls and flushes
+struct DetailedStats : BasicStats {
+    uint64_t opCounts[isaTableSize] = {};
+    uint64_t stalls = 0;
+    uint64_t flushes = 0;
+
+    void retire(Op op) {
+        retired++;
+        opCounts[(size_t)op]++;
+    }
+    void retire(const DecodedInstr* ops, size_t n) {
+        retired += n;
+        for (size_t i = 0; i < n; i++) opCounts[(size_t)ops[i].op]++;
+    }
+    void stall() { stalls++; }
+    void flush() { flushes++; }
+    void report(ostream& out) const {
+        for (size_t i = 0; i < isaTableSize; i++) {
+            if (opCounts[i]) out << isaTable[i].name << " -> " << opCounts[i] << endl;
+        }
+        out << "stalls -> " << stalls << endl;
+        out << "flushes -> " << flushes << endl;
+    }
+};
+
+// Five stage cycle estimate from the single stage commit stream (interval.h)
+struct IntervalStats : BasicStats {
+    static constexpr bool commits = true;
+    static constexpr bool commitsBlocks = true;
+    IntervalModel model;
+
+    void commit(const DecodedInstr& d, uint32_t, uint32_t, bool taken) { model.commit(d, taken); }
+    void commit(const BlockTiming& t, bool taken) { model.commit(t, taken); }
+};
+
+// Five stage pipeline replayed from the single stage commit stream
+// (pipetiming.h)
+struct PipelineStats : BasicStats {
+    static constexpr bool commits = true;
+    PipelineTiming model;
+
+    void commit(const DecodedInstr& d, uint32_t, uint32_t, bool taken) { model.commit(d, taken); }
+};
+
+// Basic block vectors per instruction interval (bbv.h)
+struct BbvStats : BasicStats {
+    static constexpr bool commits = true;
+    BbvProfiler profile;
+
+    void commit(const DecodedInstr& d, uint32_t pc, uint32_t, bool taken) { profile.commit(d, pc, taken); }
+};
+
+// Miss ratio curves of the fetch and LW/SW address streams (reuse.h)
+struct CacheStats : BasicStats {
+    static constexpr bool commits = true;
+    CacheProfiler fetches;
+    CacheProfiler data;
+
+    void commit(const DecodedInstr& d, uint32_t pc, uint32_t memAddr, bool) {
+        fetches.access(pc);
+        if (d.flags & (MEM_READ | MEM_WRITE)) data.access(memAddr);
+    }
+};
+
+// One committed instruction as the functional front-end of the decoupled
+// mode hands it to the timing back-end (decoupled.h)
+struct CommitRecord {
+    uint32_t pc;
+    uint32_t memAddr;   // LW/SW address
+    Op op;
+    uint8_t rd;
+    uint8_t rs1;
+    uint8_t rs2;
+    uint8_t flags;      // isaTable flags, for the register dependences
+    bool taken;         // taken branch or JAL
+};
+
+// Every commit becomes a record in a queue read by another thread
+struct QueueStats : BasicStats {
+    static constexpr bool commits = true;
+    SpscQueue<CommitRecord>* queue = nullptr;
+
+    void commit(const DecodedInstr& d, uint32_t pc, uint32_t memAddr, bool taken) {
+        queue->push({pc, memAddr, d.op, d.rd, d.rs1, d.rs2, d.flags, taken});
+    }
+};
+
+// --- Memory models: how LW/SW reach DataMem ---
+
+// Plain DataMem accesses
+struct DirectMemory {
+    static uint32_t load(DataMem& mem, uint32_t addr) {
+        return mem.readWord(addr);
+    }
+    static void store(DataMem& mem, uint32_t addr, uint32_t value) {
+        mem.writeWord(addr, value);
+    }
+};
+
+// Bounds-checked accesses; throws out_of_range for words that run past the
+// top of the 32-bit address space instead of wrapping around
+struct CheckedMemory {
+    static void check(uint32_t addr, const char* what) {
+        if (addr > UINT32_MAX - 3) {
+            throw out_of_range(string(what) + " outside data memory at " + to_string(addr));
+        }
+    }
+    static uint32_t load(DataMem& mem, uint32_t addr) {
+        check(addr, "load");
+        return DirectMemory::load(mem, addr);
+    }
+    static void store(DataMem& mem, uint32_t addr, uint32_t value) {
+        check(addr, "store");
+        DirectMemory::store(mem, addr, value);
+    }
+};
+
+#endif // POLICIES_H
@@ -2,6 +2,7 @@
 #define REGISTERFILE_H
 
 #include "common.h"
+#include "tracesink.h"
 
 class RegisterFile
 {
@@ -9,10 +10,24 @@ public:
     string outputFile;
     
     RegisterFile(string ioDir);
+    // Native accessors used by the cores; x0 always reads 0
+    uint32_t readReg(uint32_t reg) const { return reg < 32 ? Registers[reg] : 0; }
+    void writeReg(uint32_t reg, uint32_t value) {
+        if (reg < 32 && reg != 0) Registers[reg] = value;
+    }
+
+    // bitset wrappers of the above
     bitset<32> readRF(bitset<5> Reg_addr);
     void writeRF(bitset<5> Reg_addr, bitset<32> Wrt_reg_data);
     void outputRF(int cycle);
     void outputRF(int cycle, string outputDir); 
+    // Same record as outputRF, appended to an already open sink. Only the
+    // registers written since the previous call are reformatted.
+    void traceRF(TraceSink& sink, int cycle) { traceRF(sink, cycle, Registers); }
+    // The same for a copy of the registers; touches nothing but the trace
+    // cache, so it may run on a trace writer thread
+    void traceRF(TraceSink& sink, int cycle, const uint32_t* values);
+    const uint32_t* values() const { return Registers; }
     void setFilePrefix(string prefix);  // Add method to set file prefix 
     
     // Debug functions
@@ -21,8 +36,14 @@ public:
     void debugSetRegister(int index, bitset<32> value);
 
 private:
-    vector<bitset<32>> Registers;
+    uint32_t Registers[32] = {};
     string filePrefix;  // Add file prefix member
+
+    // traceRF text of every register and the values it was formatted from
+    static const size_t lineSize = 33;
+    char tracedLines[32 * lineSize];
+    uint32_t tracedValues[32];
+    bool tracedValid = false;
 };
 
 #endif // REGISTERFILE_H
\ No newline at end of file
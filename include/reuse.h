@@ -0,0 +1,88 @@
+#ifndef REUSE_H
+#define REUSE_H
+
+#include "common.h"
+#include <unordered_map>
+
+// ==========================================
+// SINGLE-PASS CACHE SIMULATION
+// ==========================================
+//
+// LRU caches have the inclusion property: an access hits in every cache of
+// at least its stack distance, the number of distinct lines touched since
+// the previous access to its line. One pass that records the distances of
+// a stream therefore gives the miss ratio of every capacity at once
+// (Mattson et al.).
+//   - Fully associative: StackDistance finds each distance with a Fenwick
+//     tree over access times that holds a 1 at the latest access of every
+//     line; the distance is the sum between the line's previous access
+//     and now. O(log n) per access.
+//   - Set associative: for every power-of-two number of sets up to
+//     2^maxSetBits, each set keeps an LRU stack of its maxWays most recent
+//     lines. The depth at which an access is found is its stack distance
+//     within the set, so it hits in every associativity above that depth.
+// CacheProfiler runs both on one address stream and writes the miss ratio
+// curves.
+
+class StackDistance
+{
+public:
+    static constexpr uint64_t Cold = UINT64_MAX;  // first access to the line
+
+    uint64_t access(uint32_t line);
+    size_t lines() const { return latest.size(); }
+
+private:
+    unordered_map<uint32_t, uint32_t> latest;  // line -> time of its latest access
+    vector<uint32_t> tree;                     // Fenwick tree, 1-based times
+    uint32_t now = 0;
+
+    void add(uint32_t time, int32_t delta);
+    uint32_t prefix(uint32_t time) const;
+    // Renumbers the live times 1..lines() into a tree of room for more
+    void compact();
+};
+
+class CacheProfiler
+{
+public:
+    // Associativities the report lists besides fully associative
+    static constexpr uint32_t reportWays[] = {1, 2, 4, 8, 16};
+
+    explicit CacheProfiler(uint32_t lineBytes = 64, uint32_t maxWays = 16, uint32_t maxSetBits = 14);
+
+    void access(uint32_t addr);
+
+    uint64_t accesses() const { return total; }
+    uint64_t coldMisses() const { return cold; }
+    uint32_t getLineBytes() const { return 1u << lineBits; }
+    // Miss ratio of an LRU cache of capacity bytes; ways 0 means fully
+    // associative. Returns -1 for a geometry outside the profile (ways above
+    // maxWays, or a set count that is no power of two up to 2^maxSetBits).
+    double missRatio(uint64_t capacity, uint32_t ways = 0) const;
+
+    // One row per power-of-two capacity from one line up, stopping once
+    // every column is down to the cold misses
+    void report(ostream& out, const string& stream) const;
+
+private:
+    uint32_t lineBits;
+    uint32_t maxWays;
+    uint32_t maxSetBits;
+    uint64_t total = 0;
+    uint64_t cold = 0;
+
+    StackDistance full;
+    vector<uint64_t> distances;   // fully associative accesses by finite distance
+
+    // per set count 2^s: maxWays tags per set, most recent first, and the
+    // accesses found at each depth
+    vector<vector<uint32_t>> stacks;
+    vector<vector<uint8_t>> depths;  // tags in use per set
+    vector<vector<uint64_t>> hitsAt;
+};
+
+// Writes CacheReport.txt: the instruction fetch and data curves of a run
+void outputCacheReport(const string& outputDir, const CacheProfiler& fetches, const CacheProfiler& data);
+
+#endif // REUSE_H
@@ -0,0 +1,63 @@
+#ifndef RUNCONTROL_H
+#define RUNCONTROL_H
+
+#include "common.h"
+
+// Stop conditions for Core::runUntil / FiveStageCoreT::runUntil. A run
+// always stops when the core halts; every other condition is optional and
+// the limits count from the start of the call.
+struct StopCondition {
+    uint64_t maxCycles = UINT64_MAX;
+    uint64_t maxInstructions = UINT64_MAX;
+    // stop when the next instruction to fetch is at pc (checked from the
+    // second cycle on, so repeated calls advance to the next visit)
+    bool matchPC = false;
+    uint32_t pc = 0;
+    // stop after the cycle whose store overlaps [writeLo, writeHi)
+    bool watchWrites = false;
+    uint32_t writeLo = 0;
+    uint32_t writeHi = 0;
+
+    static StopCondition cycles(uint64_t n) {
+        StopCondition c;
+        c.maxCycles = n;
+        return c;
+    }
+    static StopCondition instructions(uint64_t n) {
+        StopCondition c;
+        c.maxInstructions = n;
+        return c;
+    }
+    static StopCondition atPC(uint32_t pc) {
+        StopCondition c;
+        c.matchPC = true;
+        c.pc = pc;
+        return c;
+    }
+    static StopCondition onWrite(uint32_t lo, uint32_t hi) {
+        StopCondition c;
+        c.watchWrites = true;
+        c.writeLo = lo;
+        c.writeHi = hi;
+        return c;
+    }
+};
+
+enum class StopReason { Halted, CycleLimit, InstructionLimit, PCMatch, MemoryWrite };
+
+struct RunResult {
+    StopReason reason;
+    uint64_t cycles;        // simulated in this call
+    uint64_t instructions;  // retired in this call
+};
+
+// Architectural state handed from a functional core to a detailed one
+// (fast-forwarding). Memory is not copied: both cores are built on the same
+// DataMem, which the first one has already updated.
+struct ArchState {
+    uint32_t pc = 0;            // next instruction to execute
+    uint32_t regs[32] = {};
+    uint64_t instructions = 0;  // retired before the hand-over
+};
+
+#endif // RUNCONTROL_H
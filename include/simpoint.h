@@ -0,0 +1,77 @@
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+
+#include "core.h"
+
+// ==========================================
+// SIMPOINT SAMPLED SIMULATION
+// ==========================================
+//
+// Three passes over the program:
+//  1. ProfileCore runs it on the block engine and collects a basic block
+//     vector per interval (bbv.h).
+//  2. The vectors are normalized, randomly projected to a few dimensions
+//     and clustered with k-means. The number of clusters is the smallest
+//     whose BIC score is within 90% of the best one. The interval closest
+//     to each centroid represents its cluster, weighted by the cluster's
+//     share of the instructions.
+//  3. FastForwardCore runs to each representative in turn, and a five
+//     stage core simulates that interval from a copy of the memory
+//     (fastforward.h). It starts `warmup` instructions early, so the window
+//     is timed from a filled pipeline rather than an empty one. The window
+//     that ends the program runs on through the drain after HALT; when no
+//     representative does, a last window of the HALT alone measures it.
+// The weighted CPI of the representatives plus the drain estimates the
+// whole program's cycles; a program of one interval is simulated whole.
+// Without a full detailed run there is no error to report; the estimate is
+// only compared with the interval model's cycles for the whole run.
+
+struct SimPointOptions {
+    uint64_t intervalSize = 1000000;  // instructions per interval
+    uint32_t maxClusters = 10;
+    uint32_t dimensions = 15;         // of the random projection
+    uint64_t warmup = 1000;           // instructions simulated before each window
+    uint32_t seed = 1;
+};
+
+struct SimPoint {
+    uint64_t interval;      // index of the representative interval
+    uint64_t start;         // its first instruction
+    uint64_t instructions;
+    uint32_t members;       // intervals in the cluster
+    double weight;          // share of the program's instructions
+    double cpi;             // of the detailed simulation, fetch to fetch
+    double modelCpi;        // of the interval model
+};
+
+struct SimPointResult {
+    uint64_t intervalSize = 0;
+    uint64_t intervals = 0;
+    uint64_t instructions = 0;   // of the whole program
+    vector<SimPoint> points;     // by start
+    double cpi = 0;              // weighted estimate, drain included
+    uint64_t drainCycles = 0;    // after HALT is fetched
+    uint64_t modelCycles = 0;    // interval model over the whole program
+
+    double ipc() const { return cpi > 0 ? 1.0 / cpi : 0; }
+    uint64_t cycles() const;
+    // Relative difference of cycles() and modelCycles, in percent; an
+    // estimate against an estimate, not an error
+    double modelDifference() const;
+
+    // Writes the points and the estimate to SimPoints.txt
+    void outputSimPoints(const string& outputDir) const;
+    // Appends a "Performance of Five Stage (SimPoint estimate)" record
+    void outputPerformanceMetrics(const string& outputDir) const;
+};
+
+// Cluster index of every point: k-means for 1..maxClusters clusters, the
+// smallest k within 90% of the best BIC score
+vector<uint32_t> clusterPoints(const vector<vector<double>>& points, uint32_t maxClusters, uint32_t seed);
+
+// Samples the program of imem with dmem as its initial memory, which holds
+// the final memory on return
+SimPointResult runSimPoints(const string& ioDir, const InsMem& imem, DataMem& dmem,
+                            const SimPointOptions& opts = SimPointOptions());
+
+#endif // SIMPOINT_H
@@ -0,0 +1,73 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include "common.h"
+#include <atomic>
+#include <thread>
+
+// Bounded lock-free ring between exactly one producer and one consumer
+// thread. Capacity is a power of two. The producer publishes with a release
+// store of tail and the consumer with a release store of head; each side
+// keeps a cached copy of the other's index and only reloads it when the
+// ring looks full (producer) or empty (consumer). push() and pop() spin
+// with yield, which is the backpressure between the two threads.
+template <class T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacityLog2 = 14)
+        : mask(((size_t)1 << capacityLog2) - 1), slots(mask + 1) {}
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // --- producer side ---
+    bool tryPush(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - headCache > mask) {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache > mask) return false;
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    void push(const T& value) {
+        while (!tryPush(value)) std::this_thread::yield();
+    }
+    // No more pushes; the consumer drains what is left
+    void close() { closed.store(true, std::memory_order_release); }
+
+    // --- consumer side ---
+    bool tryPop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tailCache) {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h == tailCache) return false;
+        }
+        value = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    // Waits for the next value; false once the queue is closed and empty
+    bool pop(T& value) {
+        while (!tryPop(value)) {
+            if (closed.load(std::memory_order_acquire)) return tryPop(value);
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+private:
+    const size_t mask;
+    vector<T> slots;
+    // producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t headCache = 0;   // producer's view of head
+    alignas(64) std::atomic<size_t> head{0};
+    size_t tailCache = 0;   // consumer's view of tail
+    alignas(64) std::atomic<bool> closed{false};
+};
+
+#endif // SPSCQUEUE_H
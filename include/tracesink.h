@@ -0,0 +1,229 @@
+#ifndef TRACESINK_H
+#define TRACESINK_H
+
+#include "common.h"
+#include "spscqueue.h"
+#include <cstdio>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Buffered writer for the per-cycle trace files. The buffer is allocated
+// once at construction and the file stays open between cycles, so appending
+// a record never touches the heap; numbers and bit strings are formatted
+// directly into the buffer instead of through ostream/bitset.
+class TraceSink
+{
+public:
+    static const size_t bufferSize = 1 << 16;
+
+    TraceSink();
+    ~TraceSink();
+    TraceSink(const TraceSink&) = delete;
+    TraceSink& operator=(const TraceSink&) = delete;
+
+    // Truncates path and starts writing to it; false if it cannot be opened
+    bool open(const string& path);
+    bool isOpen() const { return file != nullptr; }
+    void flush();
+    void close();
+
+    void put(const char* s, size_t n) {
+        if (used + n > bufferSize) flush();
+        if (n > bufferSize) { writeOut(s, n); return; }
+        memcpy(&buf[used], s, n);
+        used += n;
+    }
+    template <size_t N>
+    void put(const char (&s)[N]) { put(s, N - 1); }
+
+    // value as `width` (1 to 32) binary digits, most significant bit first
+    void putBits(uint32_t value, int width) {
+        if (used + 32 > bufferSize) flush();
+        formatBits(&buf[used], value, width);
+        used += width;
+    }
+    void putUnsigned(uint64_t value);
+    void newline() { put("\n", 1); }
+
+    // Makes room for a record of at most n bytes so that it stays contiguous
+    // in the buffer, and returns its start; data(start) is the text written
+    // since, up to position()
+    size_t reserve(size_t n) {
+        if (used + n > bufferSize) flush();
+        return used;
+    }
+    size_t position() const { return used; }
+    const char* data(size_t pos) const { return &buf[pos]; }
+
+    // Writes the `width` (1 to 32) low bits of value as '0'/'1' digits, most
+    // significant first, eight digits per SIMD byte lane: each byte of the
+    // value is broadcast to eight lanes, ANDed with one bit per lane and
+    // compared, and the all-ones lanes are subtracted from '0'. May store
+    // up to 32 bytes at out, past the digits; putBits reserves that room.
+    static void formatBits(char* out, uint32_t value, int width) {
+        uint32_t v = value << (32 - width);  // first digit in bit 31
+#if defined(__SSE2__)
+        __m128i x = _mm_cvtsi32_si128((int)__builtin_bswap32(v));
+        x = _mm_unpacklo_epi8(x, x);
+        x = _mm_unpacklo_epi16(x, x);  // each byte four times, first digit first
+        const __m128i bits = _mm_set1_epi64x(0x0102040810204080);
+        const __m128i zero = _mm_set1_epi8('0');
+        __m128i head = _mm_unpacklo_epi32(x, x);
+        _mm_storeu_si128((__m128i*)out, _mm_sub_epi8(zero, _mm_cmpeq_epi8(_mm_and_si128(head, bits), bits)));
+        if (width > 16) {
+            __m128i tail = _mm_unpackhi_epi32(x, x);
+            _mm_storeu_si128((__m128i*)(out + 16), _mm_sub_epi8(zero, _mm_cmpeq_epi8(_mm_and_si128(tail, bits), bits)));
+        }
+#else
+        // the same eight digits at a time in a 64-bit word (little-endian host)
+        for (int i = 0; i < width; i += 8) {
+            uint64_t x = ((v >> (24 - i)) & 0xFF) * 0x0101010101010101ull & 0x0102040810204080ull;
+            x = (((x + 0x7F7F7F7F7F7F7F7Full) >> 7) & 0x0101010101010101ull) | 0x3030303030303030ull;
+            memcpy(out + i, &x, 8);
+        }
+#endif
+    }
+    // One line of eight digits per byte, "bbbbbbbb\n" as the DMEM dumps are
+    // written; stores exactly 9 * n bytes. Four bytes per AVX2 vector when
+    // the host has it, unless simd is false.
+    static void formatBytes(char* out, const uint8_t* bytes, size_t n, bool simd = true);
+    static bool simdSupported();
+
+private:
+    FILE* file = nullptr;
+    vector<char> buf;
+    size_t used = 0;
+
+    void writeOut(const char* s, size_t n);
+};
+
+// Formatted text of one record section, replayed while the value it was
+// formatted from is byte-for-byte unchanged. Format is called as
+// format(TraceSink&) and must write at most N bytes.
+template <class Value, size_t N>
+class TraceSection
+{
+public:
+    template <class Format>
+    void emit(TraceSink& out, const Value& value, Format format) {
+        if (valid && memcmp(&cached, &value, sizeof(Value)) == 0) {
+            out.put(text, len);
+            return;
+        }
+        size_t start = out.reserve(N);
+        format(out);
+        len = out.position() - start;
+        memcpy(text, out.data(start), len);
+        memcpy(&cached, &value, sizeof(Value));
+        valid = true;
+    }
+
+private:
+    Value cached;
+    bool valid = false;
+    size_t len = 0;
+    char text[N];
+};
+
+// Formats trace records on a background thread. The simulating thread
+// pushes fixed-size raw records (a cycle number, latches, registers) into a
+// preallocated ring, and format(record) turns them into text and writes
+// them on the writer thread, so the core neither formats nor touches the
+// filesystem. push() spins while the ring is full, which holds the core
+// back to the writer's pace. One thread serves the writer's whole
+// lifetime: it spins briefly on an empty ring, then sleeps until the next
+// push. flush() waits until every record pushed so far is formatted
+// without stopping the thread; from then until the next push the sinks
+// and caches format uses belong to the caller again. The destructor
+// formats what is left and joins.
+template <class Record>
+class TraceWriter
+{
+public:
+    explicit TraceWriter(function<void(const Record&)> format, size_t capacityLog2 = 10)
+        : format(std::move(format)), queue(capacityLog2), writer([this] { run(); }) {}
+    ~TraceWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        wake.notify_one();
+        writer.join();
+    }
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    void push(const Record& record) { push(&record, 1); }
+    // n records in order, waking the writer at most once
+    void push(const Record* records, size_t n) {
+        for (size_t i = 0; i < n; i++) queue.push(records[i]);
+        pushed += n;
+        // pairs with the fence in run(): either the writer sees these records
+        // before it sleeps or this sees it asleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            wake.notify_one();
+        }
+    }
+    void flush() {
+        while (formatted.load(std::memory_order_acquire) != pushed) std::this_thread::yield();
+    }
+    std::thread::id threadId() const { return writer.get_id(); }
+
+private:
+    static const int spinsBeforeSleep = 64;
+
+    function<void(const Record&)> format;
+    SpscQueue<Record> queue;
+    uint64_t pushed = 0;  // producer only
+    alignas(64) std::atomic<uint64_t> formatted{0};
+    std::atomic<bool> sleeping{false};
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool closed = false;  // under mutex
+    std::thread writer;   // last: starts once everything it uses exists
+
+    void formatOne(const Record& r) {
+        format(r);
+        formatted.store(formatted.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    void run() {
+        Record r;
+        int idle = 0;
+        while (true) {
+            if (queue.tryPop(r)) {
+                formatOne(r);
+                idle = 0;
+                continue;
+            }
+            if (++idle < spinsBeforeSleep) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool ready = queue.tryPop(r);
+            if (!ready && !closed) {
+                wake.wait(lock);
+                ready = queue.tryPop(r);
+            }
+            sleeping.store(false, std::memory_order_relaxed);
+            if (!ready) {
+                if (closed) return;
+                continue;
+            }
+            lock.unlock();
+            formatOne(r);
+            idle = 0;
+        }
+    }
+};
+
+#endif // TRACESINK_H
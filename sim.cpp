@@ -1,93 +1,359 @@
-#include "include/common.h"
-#include "include/insmem.h"
-#include "include/datamem.h"
-#include "include/registerfile.h"
-#include "include/core.h"
-#include <cstdio>  // for std::remove
-
-// Function to extract testcase name from path
-string extractTestcaseName(const string& path) {
-    // Find the last occurrence of '/' or '\'
-    size_t lastSlash = path.find_last_of("/\\");
-    if (lastSlash != string::npos) {
-        string dirname = path.substr(lastSlash + 1);
-        // Check if it's a testcase directory
-        if (dirname.find("testcase") == 0) {
-            return dirname;
-        }
-    }
-    
-    // Fallback: look for testcase in the path
-    size_t pos = path.find("testcase");
-    if (pos != string::npos) {
-        // Extract testcase name (assume format like "testcase0", "testcase1", etc.)
-        size_t start = pos;
-        size_t end = start + 8; // "testcase" length
-        while (end < path.length() && isdigit(path[end])) {
-            end++;
-        }
-        return path.substr(start, end - start);
-    }
-    
-    return "default"; // fallback name
-}
-
-int main(int argc, char* argv[]) {
-	
-	string ioDir = "";
-    if (argc == 1) {
-        cout << "Enter path containing the memory files: ";
-        cin >> ioDir;
-    }
-    else if (argc > 2) {
-        cout << "Invalid number of arguments. Machine stopped." << endl;
-        return -1;
-    }
-    else {
-        ioDir = argv[1];
-        cout << "IO Directory: " << ioDir << endl;
-    }
-
-    InsMem imem = InsMem("Imem", ioDir);
-    DataMem dmem_ss = DataMem("SS", ioDir);
-	DataMem dmem_fs = DataMem("FS", ioDir);
-
-    // Extract testcase name and create result subdirectory
-    string testcaseName = extractTestcaseName(ioDir);
-    string resultDir = "result/" + testcaseName;
-    
-    cout << "Testcase: " << testcaseName << endl;
-    cout << "Result directory: " << resultDir << endl;
-
-	SingleStageCore SSCore(ioDir, imem, dmem_ss);
-	FiveStageCore FSCore(ioDir, imem, dmem_fs);
-
-    // Set output directory for both cores
-    SSCore.setOutputDirectory(resultDir);
-    FSCore.setOutputDirectory(resultDir);
-
-    while (1) {
-		if (!SSCore.halted)
-			SSCore.step();
-		
-		if (!FSCore.halted)
-			FSCore.step();
-
-		if (SSCore.halted && FSCore.halted)
-			break;
-    }
-    
-	// dump both data memories to result directory
-	dmem_ss.outputDataMem(resultDir);
-	dmem_fs.outputDataMem(resultDir);
-
-    // Clear the performance metrics file and output for both cores
-    string perfFile = resultDir + "/PerformanceMetrics.txt";
-    std::remove(perfFile.c_str());  // Remove existing file to start fresh
-    
-    // Output performance metrics for both cores
-    SSCore.outputPerformanceMetrics(resultDir);
-    FSCore.outputPerformanceMetrics(resultDir);
-
-	return 0;
-}
\ No newline at end of file
+#include "include/common.h"
+#include "include/insmem.h"
+#include "include/datamem.h"
+#include "include/registerfile.h"
+#include "include/core.h"
+#include "include/aot.h"
+#include "include/decoupled.h"
+#include "include/fastforward.h"
+#include "include/simpoint.h"
+#include "include/batch.h"
+#include "include/reuse.h"
+#include <cstdio>  // for std::remove
+#include <functional>
+#include <memory>
+#include <thread>
+#include <sys/stat.h>
+
+// Function to extract testcase name from path
+string extractTestcaseName(const string& path) {
+    // Find the last occurrence of '/' or '\'
+    size_t lastSlash = path.find_last_of("/\\");
+    if (lastSlash != string::npos) {
+        string dirname = path.substr(lastSlash + 1);
+        // Check if it's a testcase directory
+        if (dirname.find("testcase") == 0) {
+            return dirname;
+        }
+    }
+    
+    // Fallback: look for testcase in the path
+    size_t pos = path.find("testcase");
+    if (pos != string::npos) {
+        // Extract testcase name (assume format like "testcase0", "testcase1", etc.)
+        size_t start = pos;
+        size_t end = start + 8; // "testcase" length
+        while (end < path.length() && isdigit(path[end])) {
+            end++;
+        }
+        return path.substr(start, end - start);
+    }
+    
+    return "default"; // fallback name
+}
+
+// Command line options following the IO directory
+struct SimOptions {
+    string engine = "interp";   // single stage engine: interp | threaded | block | jit
+    bool trace = true;          // per-cycle single stage RF/state dumps
+    bool jitDiff = false;       // check JIT blocks against the interpreter
+    string aotSource;           // translate imem to this C++ file and exit
+    string aotExe;              // ...and compile it into this executable (source
+                                // defaults to <exe>.cpp)
+    string timing = "detailed"; // five stage timing: detailed | interval | decoupled | simpoint
+    bool fastForward = false;   // run the five stage program functionally up to...
+    StopCondition skipTo;       // ...this instruction count or PC marker
+    uint64_t window = UINT64_MAX;  // detailed instructions after the fast-forward
+    SimPointOptions simpoint;
+    string batchList;           // file of dmem directories to run as one batch
+    vector<MemRange> dumpRanges{{0, MemSize}};  // bytes of the DMEM result files
+    bool image = false;         // map imem.bin/dmem.bin, also write *_DMEMResult.bin
+    uint64_t cacheLine = 0;     // bytes per line of the cache report, 0: no report
+};
+
+// Decimal or 0x-prefixed number of an option
+static bool parseNumber(const string& text, uint64_t& value) {
+    try {
+        size_t used;
+        value = stoull(text, &used, 0);
+        return used == text.size();
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+// Comma-separated <lo>:<hi> byte ranges, hi exclusive
+static bool parseRanges(const string& text, vector<MemRange>& ranges) {
+    ranges.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == string::npos) end = text.size();
+        string range = text.substr(start, end - start);
+        size_t colon = range.find(':');
+        uint64_t lo, hi;
+        if (colon == string::npos || !parseNumber(range.substr(0, colon), lo) ||
+            !parseNumber(range.substr(colon + 1), hi) || lo > hi || hi > ((uint64_t)1 << 32))
+            return false;
+        ranges.push_back({(uint32_t)lo, hi});
+        start = end + 1;
+    }
+    return true;
+}
+
+static bool parseOptions(int argc, char* argv[], SimOptions& opts) {
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--engine=", 0) == 0) {
+            opts.engine = arg.substr(9);
+            if (opts.engine != "interp" && opts.engine != "threaded" && opts.engine != "block" &&
+                opts.engine != "jit")
+                return false;
+        } else if (arg == "--no-trace") {
+            opts.trace = false;
+        } else if (arg.rfind("--aot=", 0) == 0) {
+            opts.aotSource = arg.substr(6);
+        } else if (arg.rfind("--aot-exe=", 0) == 0) {
+            opts.aotExe = arg.substr(10);
+        } else if (arg.rfind("--timing=", 0) == 0) {
+            opts.timing = arg.substr(9);
+            if (opts.timing != "detailed" && opts.timing != "interval" && opts.timing != "decoupled" &&
+                opts.timing != "simpoint")
+                return false;
+        } else if (arg.rfind("--simpoint-interval=", 0) == 0) {
+            if (!parseNumber(arg.substr(20), opts.simpoint.intervalSize) || opts.simpoint.intervalSize == 0)
+                return false;
+        } else if (arg.rfind("--simpoint-k=", 0) == 0) {
+            uint64_t k;
+            if (!parseNumber(arg.substr(13), k) || k == 0 || k > 1000) return false;
+            opts.simpoint.maxClusters = (uint32_t)k;
+        } else if (arg.rfind("--simpoint-warmup=", 0) == 0) {
+            if (!parseNumber(arg.substr(18), opts.simpoint.warmup)) return false;
+        } else if (arg.rfind("--fast-forward=", 0) == 0) {
+            uint64_t n;
+            if (!parseNumber(arg.substr(15), n)) return false;
+            opts.fastForward = true;
+            opts.skipTo = StopCondition::instructions(n);
+        } else if (arg.rfind("--fast-forward-pc=", 0) == 0) {
+            uint64_t pc;
+            if (!parseNumber(arg.substr(18), pc) || pc > UINT32_MAX) return false;
+            opts.fastForward = true;
+            opts.skipTo = StopCondition::atPC((uint32_t)pc);
+        } else if (arg.rfind("--window=", 0) == 0) {
+            if (!parseNumber(arg.substr(9), opts.window)) return false;
+        } else if (arg.rfind("--dump=", 0) == 0) {
+            if (!parseRanges(arg.substr(7), opts.dumpRanges)) return false;
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            opts.batchList = arg.substr(8);
+        } else if (arg == "--cache-report") {
+            if (!opts.cacheLine) opts.cacheLine = 64;
+        } else if (arg.rfind("--cache-line=", 0) == 0) {
+            uint64_t bytes;
+            if (!parseNumber(arg.substr(13), bytes) || bytes < 4 || bytes > 4096 || (bytes & (bytes - 1)))
+                return false;
+            opts.cacheLine = bytes;
+        } else if (arg == "--image") {
+            opts.image = true;
+        } else if (arg == "--jit-diff") {
+            opts.engine = "jit";
+            opts.jitDiff = true;
+        } else {
+            return false;
+        }
+    }
+    // --aot-exe alone translates to <exe>.cpp next to the executable
+    if (!opts.aotExe.empty() && opts.aotSource.empty()) opts.aotSource = opts.aotExe + ".cpp";
+    // the analytic and sampled modes have no detailed window to fast-forward to
+    return opts.timing == "detailed" || (!opts.fastForward && opts.window == UINT64_MAX);
+}
+
+// Converts ioDir/<name>.txt to <name>.bin unless the binary image is newer
+static void prepareImage(const string& ioDir, const string& name) {
+    string text = ioDir + "/" + name + ".txt", binary = ioDir + "/" + name + ".bin";
+    struct stat textStat, binaryStat;
+    if (stat(text.c_str(), &textStat) != 0) return;  // binary image only
+    if (stat(binary.c_str(), &binaryStat) == 0 && binaryStat.st_mtime >= textStat.st_mtime) return;
+    if (convertTextImage(text, binary)) cout << "Converted " << text << " to " << binary << endl;
+}
+
+// The DMEM dump, and with --image the binary image of the whole memory
+static void outputMemory(DataMem& dmem, const string& resultDir, const SimOptions& opts) {
+    dmem.outputDataMem(resultDir);
+    if (opts.image) dmem.outputDataImage(resultDir);
+}
+
+// Runs the five stage model in the mode of opts and writes its result
+// files; returns what appends its PerformanceMetrics record
+static function<void()> simulateFiveStage(const string& ioDir, const InsMem& imem, DataMem& dmem,
+                                          const string& resultDir, const SimOptions& opts) {
+    if (opts.timing == "detailed") {
+        auto core = make_shared<FiveStageCore>(ioDir, imem, dmem);
+        core->setOutputDirectory(resultDir);
+        if (opts.fastForward) {
+            FastForwardCore functional(ioDir, imem, dmem);
+            fastForward(functional, opts.skipTo);
+            ArchState arch = functional.getArchState();
+            core->setArchState(arch);
+            cout << "Fast-forwarded " << arch.instructions << " instructions to PC " << arch.pc << endl;
+        }
+        core->runUntil(StopCondition::instructions(opts.window));
+        outputMemory(dmem, resultDir, opts);
+        return [core, resultDir] { core->outputPerformanceMetrics(resultDir); };
+    }
+
+    // only FS_DMEMResult and the metrics are written, so traces of an
+    // earlier detailed run would no longer match
+    std::remove((resultDir + "/FS_RFResult.txt").c_str());
+    std::remove((resultDir + "/StateResult_FS.txt").c_str());
+    if (opts.timing == "simpoint") {
+        SimPointResult sampled = runSimPoints(ioDir, imem, dmem, opts.simpoint);
+        outputMemory(dmem, resultDir, opts);
+        sampled.outputSimPoints(resultDir);
+        return [sampled, resultDir] { sampled.outputPerformanceMetrics(resultDir); };
+    }
+    if (opts.timing == "decoupled") {
+        // the pipeline replayed from the commits on a second thread
+        FrontEndCore core(ioDir, imem, dmem);
+        PipelineTiming timing = runDecoupled(core).timing;
+        outputMemory(dmem, resultDir, opts);
+        return [timing, resultDir] { timing.outputPerformanceMetrics(resultDir); };
+    }
+    // a functional core runs the program and its commits are timed analytically
+    IntervalCore core(ioDir, imem, dmem);
+    IntervalModel model = runInterval(core);
+    outputMemory(dmem, resultDir, opts);
+    return [model, resultDir] { model.outputPerformanceMetrics(resultDir); };
+}
+
+// Cache report: a third functional run whose fetch and LW/SW addresses
+// give the miss ratio curves of every cache size at once (reuse.h)
+static void simulateCaches(const string& ioDir, const InsMem& imem, DataMem& dmem, const string& resultDir,
+                           uint32_t lineBytes) {
+    CacheCore core(ioDir, imem, dmem);
+    core.getStats().fetches = CacheProfiler(lineBytes);
+    core.getStats().data = CacheProfiler(lineBytes);
+    while (!core.halted && core.runThreaded(UINT64_MAX)) {}
+    core.runUntil(StopCondition());
+    outputCacheReport(resultDir, core.getStats().fetches, core.getStats().data);
+}
+
+// Batch mode: the program of imem against every directory listed in
+// listFile, one lane each. Each writes the single stage results of a
+// --no-trace run to result/<testcase>.
+static int simulateBatch(const InsMem& imem, const string& listFile) {
+    ifstream list(listFile);
+    if (!list.is_open()) {
+        cout << "Unable to open batch list: " << listFile << endl;
+        return -1;
+    }
+    vector<string> inputs, outputs;
+    string line;
+    while (getline(list, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        inputs.push_back(line);
+        outputs.push_back("result/" + extractTestcaseName(line));
+    }
+    unique_ptr<BatchEngine> batch = runBatch(imem, inputs, outputs);
+    cout << "Batch of " << inputs.size() << " lanes: " << batch->getSteps() << " steps ("
+         << (batch->usesSimd() ? "AVX2" : "scalar") << ")" << endl;
+    return 0;
+}
+
+// Runs both cores; SSCoreType selects the single stage tracer
+template <class SSCoreType>
+static int simulate(const string& ioDir, const InsMem& imem, const SimOptions& opts) {
+    // dmem is parsed once; the models share its pages until they store.
+    // Every copy is made here, before any model thread starts.
+    DataMem base("Base", ioDir, opts.image);
+    base.setDumpRanges(opts.dumpRanges);
+    DataMem dmem_ss = DataMem("SS", base);
+    DataMem dmem_fs = DataMem("FS", base);
+    DataMem dmem_cache("Cache", base);
+
+    // Extract testcase name and create result subdirectory
+    string testcaseName = extractTestcaseName(ioDir);
+    string resultDir = "result/" + testcaseName;
+    
+    cout << "Testcase: " << testcaseName << endl;
+    cout << "Result directory: " << resultDir << endl;
+
+    SSCoreType SSCore(ioDir, imem, dmem_ss);
+    SSCore.setOutputDirectory(resultDir);
+    SSCore.setJitDiff(opts.jitDiff);
+
+    // The models share nothing but the read-only InsMem and write different
+    // files, so each runs to completion on its own thread. Only the five
+    // stage thread prints.
+    std::thread ssThread([&] {
+        if (opts.engine == "threaded") {
+            while (!SSCore.halted)
+                SSCore.runThreaded(UINT64_MAX);
+        } else if (opts.engine == "block") {
+            while (!SSCore.halted)
+                SSCore.runBlocks(UINT64_MAX);
+        } else if (opts.engine == "jit") {
+            while (!SSCore.halted)
+                SSCore.runJit(UINT64_MAX);
+        }
+        SSCore.runUntil(StopCondition());
+        outputMemory(dmem_ss, resultDir, opts);
+    });
+    function<void()> fsMetrics;
+    std::thread fsThread([&] { fsMetrics = simulateFiveStage(ioDir, imem, dmem_fs, resultDir, opts); });
+    std::thread cacheThread;
+    if (opts.cacheLine)
+        cacheThread = std::thread([&] { simulateCaches(ioDir, imem, dmem_cache, resultDir, (uint32_t)opts.cacheLine); });
+    ssThread.join();
+    fsThread.join();
+    if (cacheThread.joinable()) cacheThread.join();
+
+    if (opts.jitDiff) {
+        cout << "JIT differential check: " << SSCore.getJitMismatches() << " mismatches" << endl;
+    }
+
+    // Clear the performance metrics file and output for both cores, in
+    // the same order whichever finished first
+    string perfFile = resultDir + "/PerformanceMetrics.txt";
+    std::remove(perfFile.c_str());  // Remove existing file to start fresh
+    SSCore.outputPerformanceMetrics(resultDir);
+    fsMetrics();
+
+    return SSCore.getJitMismatches() == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+
+    string ioDir = "";
+    SimOptions opts;
+    if (argc == 1) {
+        cout << "Enter path containing the memory files: ";
+        cin >> ioDir;
+    }
+    else if (!parseOptions(argc, argv, opts)) {
+        cout << "Usage: " << argv[0] << " <ioDir> [--engine=interp|threaded|block|jit] [--jit-diff] [--no-trace]"
+             << " [--timing=detailed|interval|decoupled|simpoint]"
+             << " [--simpoint-interval=<n>] [--simpoint-k=<n>] [--simpoint-warmup=<n>] [--batch=<dir list>]"
+             << " [--fast-forward=<n>|--fast-forward-pc=<pc>] [--window=<n>] [--dump=<lo>:<hi>,...] [--image]"
+             << " [--cache-report [--cache-line=<bytes>]]"
+             << " [--aot=<out.cpp>] [--aot-exe=<exe>]" << endl;
+        cout << "Invalid arguments. Machine stopped." << endl;
+        return -1;
+    }
+    else {
+        ioDir = argv[1];
+        cout << "IO Directory: " << ioDir << endl;
+    }
+
+    if (opts.image) {
+        prepareImage(ioDir, "imem");
+        prepareImage(ioDir, "dmem");
+    }
+    InsMem imem = InsMem("Imem", ioDir, opts.image);
+
+    // AOT tool mode: translate the program instead of simulating it
+    if (!opts.aotSource.empty()) {
+        if (!emitAotSource(imem.getProgram(), opts.aotSource)) return -1;
+        cout << "Translated program written to " << opts.aotSource << endl;
+        if (!opts.aotExe.empty()) {
+            if (!compileAotSource(opts.aotSource, opts.aotExe)) return -1;
+            cout << "Native program built: " << opts.aotExe << endl;
+        }
+        return 0;
+    }
+    if (!opts.batchList.empty()) return simulateBatch(imem, opts.batchList);
+    // the JIT only produces final architectural state
+    if (opts.trace && opts.engine != "jit")
+        return simulate<SingleStageCore>(ioDir, imem, opts);
+    return simulate<FinalStateSingleStageCore>(ioDir, imem, opts);
+}
@@ -0,0 +1,189 @@
+#include "../include/aot.h"
+#include <set>
+
+static bool endsBlock(Op op) {
+    return op == Op::BEQ || op == Op::BNE || op == Op::JAL || op == Op::HALT;
+}
+
+// Guest register as a C++ expression; x0 reads as a constant
+static string reg(uint32_t r) {
+    return r == 0 ? string("0u") : "x" + to_string(r);
+}
+
+static string label(uint32_t pc) {
+    return "pc_" + to_string(pc);
+}
+
+// Start PCs of every basic block reachable from PC 0
+static set<uint32_t> findBlocks(const DecodedProgram& program) {
+    set<uint32_t> leaders;
+    vector<uint32_t> work = {0};
+    while (!work.empty()) {
+        uint32_t start = work.back();
+        work.pop_back();
+        if (!leaders.insert(start).second) continue;
+        uint32_t pc = start;
+        while (true) {
+            const DecodedInstr& d = program.at(pc);
+            if (d.op == Op::BEQ || d.op == Op::BNE) {
+                work.push_back(d.target);
+                work.push_back(pc + 4);
+                break;
+            }
+            if (d.op == Op::JAL) {
+                work.push_back(d.target);
+                break;
+            }
+            if (d.op == Op::HALT) break;
+            pc += 4;
+        }
+    }
+    return leaders;
+}
+
+static void emitBlock(ostream& out, const DecodedProgram& program,
+                      const set<uint32_t>& leaders, uint32_t start) {
+    out << label(start) << ": {\n";
+    uint32_t pc = start;
+    uint32_t n = 0;
+    while (true) {
+        const DecodedInstr& d = program.at(pc);
+        n++;
+        string rd = "x" + to_string(d.rd);
+        string rs1 = reg(d.rs1), rs2 = reg(d.rs2);
+        string imm = to_string((uint32_t)d.imm) + "u";
+        bool writes = d.rd != 0;
+        switch (d.op) {
+            case Op::ADD:  if (writes) out << "    " << rd << " = " << rs1 << " + " << rs2 << ";\n"; break;
+            case Op::SUB:  if (writes) out << "    " << rd << " = " << rs1 << " - " << rs2 << ";\n"; break;
+            case Op::XOR:  if (writes) out << "    " << rd << " = " << rs1 << " ^ " << rs2 << ";\n"; break;
+            case Op::OR:   if (writes) out << "    " << rd << " = " << rs1 << " | " << rs2 << ";\n"; break;
+            case Op::AND:  if (writes) out << "    " << rd << " = " << rs1 << " & " << rs2 << ";\n"; break;
+            case Op::ADDI: if (writes) out << "    " << rd << " = " << rs1 << " + " << imm << ";\n"; break;
+            case Op::XORI: if (writes) out << "    " << rd << " = " << rs1 << " ^ " << imm << ";\n"; break;
+            case Op::ORI:  if (writes) out << "    " << rd << " = " << rs1 << " | " << imm << ";\n"; break;
+            case Op::ANDI: if (writes) out << "    " << rd << " = " << rs1 << " & " << imm << ";\n"; break;
+            case Op::LW:
+                out << "    { uint32_t v = ld(mem, " << rs1 << " + " << imm << ");";
+                if (writes) out << " " << rd << " = v;";
+                out << " }\n";
+                break;
+            case Op::SW:
+                out << "    st(mem, " << rs1 << " + " << imm << ", " << rs2 << ");\n";
+                break;
+            case Op::BEQ: case Op::BNE:
+                out << "    count += " << n << ";\n";
+                out << "    if (" << rs1 << (d.op == Op::BEQ ? " == " : " != ") << rs2 << ") goto "
+                    << label(d.target) << ";\n";
+                out << "    goto " << label(pc + 4) << ";\n";
+                break;
+            case Op::JAL:
+                if (writes) out << "    " << rd << " = " << pc + 4 << "u;\n";
+                out << "    count += " << n << ";\n";
+                out << "    goto " << label(d.target) << ";\n";
+                break;
+            case Op::HALT:
+                out << "    count += " << n << ";\n";
+                out << "    goto done;\n";
+                break;
+            default:
+                break;
+        }
+        if (endsBlock(d.op)) break;
+        pc += 4;
+        if (leaders.count(pc)) {  // fall into the next block
+            out << "    count += " << n << ";\n";
+            out << "    goto " << label(pc) << ";\n";
+            break;
+        }
+    }
+    out << "}\n";
+}
+
+// Runtime shared by every generated program: dmem.txt parsing and the
+// SS_DMEMResult.txt / SS_RFResult.txt writers
+static const char* aotRuntime = R"(#include <bitset>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+static const size_t MemSize = )";
+
+static const char* aotRuntimeTail = R"(;
+
+static inline uint32_t ld(const vector<uint8_t>& mem, uint32_t a) {
+    if (a + 4 > mem.size()) { cerr << "load outside data memory: " << a << endl; exit(2); }
+    return (uint32_t)mem[a] << 24 | (uint32_t)mem[a + 1] << 16 | (uint32_t)mem[a + 2] << 8 | mem[a + 3];
+}
+
+static inline void st(vector<uint8_t>& mem, uint32_t a, uint32_t v) {
+    if (a + 4 > mem.size()) { cerr << "store outside data memory: " << a << endl; exit(2); }
+    mem[a] = v >> 24; mem[a + 1] = v >> 16; mem[a + 2] = v >> 8; mem[a + 3] = v;
+}
+
+static vector<uint8_t> loadDmem(const string& dir) {
+    vector<uint8_t> mem(MemSize, 0);
+    ifstream in(dir + "/dmem.txt");
+    if (!in.is_open()) cout << "Unable to open DMEM input file: " << dir << "/dmem.txt" << endl;
+    string line;
+    size_t i = 0;
+    while (getline(in, line) && i < MemSize) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) mem[i++] = (uint8_t)bitset<8>(line).to_ulong();
+    }
+    return mem;
+}
+
+static void dumpResults(const string& dir, const vector<uint8_t>& mem, const uint32_t* regs, uint64_t cycle) {
+    ofstream dmemout(dir + "/SS_DMEMResult.txt", ios_base::trunc);
+    for (size_t j = 0; j < 1000 && j < mem.size(); j++) dmemout << bitset<8>(mem[j]) << "\n";
+    ofstream rfout(dir + "/SS_RFResult.txt", ios_base::trunc);
+    rfout << "State of RF after executing cycle:  " << cycle << "\n";
+    for (int j = 0; j < 32; j++) rfout << bitset<32>(regs[j]) << "\n";
+}
+)";
+
+bool emitAotSource(const DecodedProgram& program, const string& cppPath) {
+    ofstream out(cppPath, ios_base::trunc);
+    if (!out.is_open()) {
+        cout << "Unable to open " << cppPath << " for writing." << endl;
+        return false;
+    }
+    set<uint32_t> leaders = findBlocks(program);
+
+    out << "// Generated by the RISC-V simulator AOT translator, do not edit.\n";
+    out << aotRuntime << MemSize << aotRuntimeTail << "\n";
+
+    out << "static uint64_t run(vector<uint8_t>& mem, uint32_t* regs) {\n";
+    out << "    uint64_t count = 0;\n";
+    for (int r = 1; r < 32; r++) out << "    uint32_t x" << r << " = 0;\n";
+    out << "    goto " << label(0) << ";\n";
+    for (uint32_t start : leaders) emitBlock(out, program, leaders, start);
+    out << "done:\n";
+    out << "    regs[0] = 0;\n";
+    for (int r = 1; r < 32; r++) out << "    regs[" << r << "] = x" << r << ";\n";
+    out << "    return count;\n";
+    out << "}\n\n";
+
+    out << "int main(int argc, char* argv[]) {\n";
+    out << "    if (argc < 2) { cout << \"Usage: \" << argv[0] << \" <dmemDir> [outputDir]\" << endl; return -1; }\n";
+    out << "    string outDir = argc > 2 ? argv[2] : argv[1];\n";
+    out << "    vector<uint8_t> mem = loadDmem(argv[1]);\n";
+    out << "    uint32_t regs[32];\n";
+    out << "    uint64_t instrs = run(mem, regs);\n";
+    out << "    dumpResults(outDir, mem, regs, instrs);\n";
+    out << "    cout << \"#Cycles -> \" << instrs + 1 << endl;\n";
+    out << "    cout << \"#Instructions -> \" << instrs << endl;\n";
+    out << "    return 0;\n";
+    out << "}\n";
+    return out.good();
+}
+
+bool compileAotSource(const string& cppPath, const string& exePath) {
+    string cmd = "g++ -std=c++17 -O2 -o '" + exePath + "' '" + cppPath + "'";
+    return system(cmd.c_str()) == 0;
+}
@@ -0,0 +1,292 @@
+#include "../include/batch.h"
+#include "../include/registerfile.h"
+#include <cstdio>
+#include <map>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define BATCH_AVX2 1
+#endif
+
+BatchEngine::BatchEngine(const DecodedProgram& program, size_t lanes)
+    : program(program), laneCount(lanes), stride((lanes + 7) & ~(size_t)7),
+      regs(32 * stride, 0), pcs(stride, 0), live(stride, 0), counts(stride, 0), folded(stride, 0),
+      memBase(stride), mem(stride * MemSize, 0), outside(lanes), liveLanes(lanes) {
+    for (size_t l = 0; l < stride; l++) memBase[l] = (uint32_t)(l * MemSize);
+    for (size_t l = 0; l < laneCount; l++) live[l] = UINT32_MAX;
+    simd = simdSupported();
+}
+
+bool BatchEngine::simdSupported() {
+#ifdef BATCH_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+void BatchEngine::loadMemory(size_t lane, const DataMem& in) {
+    for (uint32_t a = 0; a < MemSize; a++) mem[memBase[lane] + a] = in.readByte(a);
+    outside[lane] = in.contents();
+    outside[lane].clearDirty();
+}
+
+void BatchEngine::storeMemory(size_t lane, DataMem& out) const {
+    // unchanged words are skipped, so pages shared with other lanes stay shared
+    for (uint32_t a = 0; a + 4 <= MemSize; a += 4) {
+        uint32_t value = loadBigEndian32(&mem[memBase[lane] + a]);
+        if (out.readWord(a) != value) out.writeWord(a, value);
+    }
+    // then whatever the lane stored past the window
+    for (const MemRange& r : outside[lane].dirtyRanges(true)) {
+        for (uint64_t a = max<uint64_t>(r.lo, MemSize); a < r.hi; a += 4) {
+            uint32_t value = outside[lane].readWord((uint32_t)a);
+            if (out.readWord((uint32_t)a) != value) out.writeWord((uint32_t)a, value);
+        }
+    }
+}
+
+uint32_t BatchEngine::loadOutside(size_t lane, uint32_t addr) const {
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        uint32_t a = addr + i;  // wraps like DataMem
+        value = (value << 8) | (a < MemSize ? mem[memBase[lane] + a] : outside[lane].readByte(a));
+    }
+    return value;
+}
+
+void BatchEngine::storeOutside(size_t lane, uint32_t addr, uint32_t value) {
+    for (uint32_t i = 0; i < 4; i++) {
+        uint32_t a = addr + i;
+        uint8_t byte = (uint8_t)(value >> (24 - 8 * i));
+        if (a < MemSize) mem[memBase[lane] + a] = byte;
+        else outside[lane].writeByte(a, byte);
+    }
+}
+
+uint64_t BatchEngine::run(uint64_t maxSteps) {
+    uint32_t pc = UINT32_MAX;
+    for (size_t l = 0; l < laneCount; l++) {
+        if (live[l]) pc = min(pc, pcs[l]);
+    }
+    uint64_t n = 0;
+    while (liveLanes > 0 && n < maxSteps) {
+        const DecodedInstr& d = program.at(pc);
+        pc = simd ? stepSimd(d, pc) : stepScalar(d, pc);
+        n++;
+        // the per-lane counters are 32-bit and gain at most one per step
+        if (++sinceFold == ((uint64_t)1 << 31)) {
+            for (size_t l = 0; l < stride; l++) {
+                folded[l] += counts[l];
+                counts[l] = 0;
+            }
+            sinceFold = 0;
+        }
+    }
+    steps += n;
+    return n;
+}
+
+// ==========================================
+// SCALAR STEP
+// ==========================================
+
+uint32_t BatchEngine::stepScalar(const DecodedInstr& d, uint32_t pc) {
+    uint32_t lowest = UINT32_MAX;
+    for (size_t l = 0; l < laneCount; l++) {
+        if (live[l] && pcs[l] == pc) {
+            counts[l]++;
+            uint32_t a = regs[d.rs1 * stride + l];
+            uint32_t b = (d.flags & IMM_OPERAND) ? (uint32_t)d.imm : regs[d.rs2 * stride + l];
+            uint32_t result = aluCompute(d.alu, a, b);
+            uint32_t next = d.target;
+            switch (d.op) {
+                case Op::LW:
+                    result = result <= MemSize - 4 ? loadBigEndian32(&mem[memBase[l] + result])
+                                                   : loadOutside(l, result);
+                    break;
+                case Op::SW:
+                    if (result <= MemSize - 4) storeBigEndian32(&mem[memBase[l] + result], regs[d.rs2 * stride + l]);
+                    else storeOutside(l, result, regs[d.rs2 * stride + l]);
+                    break;
+                case Op::BEQ:
+                case Op::BNE:
+                    if (!branchTaken(d.cond, a, regs[d.rs2 * stride + l])) next = pc + 4;
+                    break;
+                case Op::JAL:
+                    result = pc + 4;
+                    break;
+                case Op::HALT:
+                    live[l] = 0;
+                    liveLanes--;
+                    break;
+                default:
+                    break;
+            }
+            if ((d.flags & WRITES_RD) && d.rd != 0) regs[d.rd * stride + l] = result;
+            pcs[l] = next;
+        }
+        if (live[l]) lowest = min(lowest, pcs[l]);
+    }
+    return lowest;
+}
+
+// ==========================================
+// AVX2 STEP
+// ==========================================
+
+#ifdef BATCH_AVX2
+
+__attribute__((target("avx2")))
+static __m256i aluCompute8(AluOp op, __m256i a, __m256i b) {
+    switch (op) {
+        case AluOp::SUB: return _mm256_sub_epi32(a, b);
+        case AluOp::AND: return _mm256_and_si256(a, b);
+        case AluOp::OR:  return _mm256_or_si256(a, b);
+        case AluOp::XOR: return _mm256_xor_si256(a, b);
+        default:         return _mm256_add_epi32(a, b);
+    }
+}
+
+// All ones in the lanes whose word at addr is wholly inside the window
+__attribute__((target("avx2")))
+static __m256i insideWindow8(__m256i addr) {
+    __m256i limit = _mm256_set1_epi32(MemSize - 4);
+    return _mm256_cmpeq_epi32(_mm256_min_epu32(addr, limit), addr);
+}
+
+__attribute__((target("avx2")))
+uint32_t BatchEngine::stepSimd(const DecodedInstr& d, uint32_t pc) {
+    const __m256i atPC = _mm256_set1_epi32((int)pc);
+    const __m256i fallThrough = _mm256_set1_epi32((int)(pc + 4));
+    const __m256i target = _mm256_set1_epi32((int)d.target);
+    const __m256i imm = _mm256_set1_epi32(d.imm);
+    const __m256i byteSwap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                              3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const bool writes = (d.flags & WRITES_RD) && d.rd != 0;
+    const uint32_t* rs1Row = &regs[d.rs1 * stride];
+    const uint32_t* rs2Row = &regs[d.rs2 * stride];
+    uint32_t* rdRow = &regs[d.rd * stride];
+    __m256i lowest = _mm256_set1_epi32(-1);
+
+    for (size_t c = 0; c < stride; c += 8) {
+        __m256i lanePC = _mm256_loadu_si256((const __m256i*)&pcs[c]);
+        __m256i running = _mm256_loadu_si256((const __m256i*)&live[c]);
+        __m256i mask = _mm256_and_si256(running, _mm256_cmpeq_epi32(lanePC, atPC));
+
+        if (!_mm256_testz_si256(mask, mask)) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)&rs1Row[c]);
+            __m256i rs2 = _mm256_loadu_si256((const __m256i*)&rs2Row[c]);
+            __m256i result = aluCompute8(d.alu, a, (d.flags & IMM_OPERAND) ? imm : rs2);
+            __m256i next = target;
+            switch (d.op) {
+                case Op::LW: {
+                    __m256i inside = _mm256_and_si256(mask, insideWindow8(result));
+                    int outsideLanes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(inside, mask)));
+                    __m256i offset = _mm256_add_epi32(result, _mm256_loadu_si256((const __m256i*)&memBase[c]));
+                    __m256i word = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)mem.data(),
+                                                               offset, inside, 1);
+                    if (outsideLanes) {
+                        // the rest of the address space, lane by lane
+                        uint32_t addrs[8], words[8];
+                        _mm256_storeu_si256((__m256i*)addrs, result);
+                        _mm256_storeu_si256((__m256i*)words, word);
+                        for (; outsideLanes; outsideLanes &= outsideLanes - 1) {
+                            int i = __builtin_ctz(outsideLanes);
+                            words[i] = __builtin_bswap32(loadOutside(c + i, addrs[i]));
+                        }
+                        word = _mm256_loadu_si256((const __m256i*)words);
+                    }
+                    result = _mm256_shuffle_epi8(word, byteSwap);
+                    break;
+                }
+                case Op::SW: {
+                    // no scatter in AVX2
+                    uint32_t addrs[8];
+                    _mm256_storeu_si256((__m256i*)addrs, result);
+                    int lanes = _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+                    for (; lanes; lanes &= lanes - 1) {
+                        size_t l = c + __builtin_ctz(lanes);
+                        if (addrs[l - c] <= MemSize - 4) storeBigEndian32(&mem[memBase[l] + addrs[l - c]], rs2Row[l]);
+                        else storeOutside(l, addrs[l - c], rs2Row[l]);
+                    }
+                    break;
+                }
+                case Op::BEQ:
+                case Op::BNE: {
+                    __m256i equal = _mm256_cmpeq_epi32(a, rs2);
+                    // BEQ takes the target where equal, BNE where not
+                    next = d.cond == Cond::EQ ? _mm256_blendv_epi8(fallThrough, target, equal)
+                                              : _mm256_blendv_epi8(target, fallThrough, equal);
+                    break;
+                }
+                case Op::JAL:
+                    result = fallThrough;
+                    break;
+                case Op::HALT:
+                    running = _mm256_andnot_si256(mask, running);
+                    _mm256_storeu_si256((__m256i*)&live[c], running);
+                    liveLanes -= __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+                    break;
+                default:
+                    break;
+            }
+            if (writes) {
+                __m256i old = _mm256_loadu_si256((const __m256i*)&rdRow[c]);
+                _mm256_storeu_si256((__m256i*)&rdRow[c], _mm256_blendv_epi8(old, result, mask));
+            }
+            lanePC = _mm256_blendv_epi8(lanePC, next, mask);
+            _mm256_storeu_si256((__m256i*)&pcs[c], lanePC);
+            __m256i count = _mm256_loadu_si256((const __m256i*)&counts[c]);
+            _mm256_storeu_si256((__m256i*)&counts[c], _mm256_sub_epi32(count, mask));
+        }
+        lowest = _mm256_min_epu32(lowest, _mm256_or_si256(lanePC, _mm256_andnot_si256(running, _mm256_set1_epi32(-1))));
+    }
+
+    // horizontal minimum of the eight candidates
+    __m128i m = _mm_min_epu32(_mm256_castsi256_si128(lowest), _mm256_extracti128_si256(lowest, 1));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(m);
+}
+
+#else
+
+uint32_t BatchEngine::stepSimd(const DecodedInstr& d, uint32_t pc) {
+    return stepScalar(d, pc);
+}
+
+#endif
+
+// ==========================================
+// BATCH RUNS
+// ==========================================
+
+unique_ptr<BatchEngine> runBatch(const InsMem& imem, const vector<string>& inputDirs,
+                                 const vector<string>& outputDirs, bool simd) {
+    auto engine = make_unique<BatchEngine>(imem.getProgram(), inputDirs.size());
+    engine->setSimd(simd);
+    // each distinct input is parsed once, lanes share its pages
+    map<string, DataMem> bases;
+    vector<DataMem> mems;
+    mems.reserve(inputDirs.size());
+    for (size_t l = 0; l < inputDirs.size(); l++) {
+        auto base = bases.find(inputDirs[l]);
+        if (base == bases.end()) base = bases.emplace(inputDirs[l], DataMem("SS", inputDirs[l])).first;
+        mems.emplace_back("SS", base->second);
+        engine->loadMemory(l, mems[l]);
+    }
+
+    engine->run();
+
+    for (size_t l = 0; l < inputDirs.size(); l++) {
+        engine->storeMemory(l, mems[l]);
+        mems[l].outputDataMem(outputDirs[l]);
+        RegisterFile rf(outputDirs[l]);
+        for (uint32_t r = 1; r < 32; r++) rf.writeReg(r, engine->readReg(l, r));
+        // the single final-state record, as --no-trace writes it
+        std::remove((outputDirs[l] + "/SS_RFResult.txt").c_str());
+        rf.outputRF((int)engine->getInstructionCount(l), outputDirs[l]);
+    }
+    return engine;
+}
@@ -0,0 +1,35 @@
+#include "../include/bbv.h"
+#include <algorithm>
+
+uint32_t BbvProfiler::blockIndex(uint32_t pc) {
+    auto it = blockIndices.find(pc);
+    if (it != blockIndices.end()) return it->second;
+    uint32_t index = (uint32_t)blockPCs.size();
+    blockIndices.emplace(pc, index);
+    blockPCs.push_back(pc);
+    counts.push_back(0);
+    return index;
+}
+
+void BbvProfiler::closeInterval() {
+    BbvInterval interval;
+    interval.start = committed;
+    interval.instructions = filled;
+    // the estimate so far includes the drain, so consecutive differences
+    // add up to the final cycle count
+    uint64_t now = timing.cycles();
+    interval.cycles = now - intervalCycles;
+    intervalCycles = now;
+
+    sort(touched.begin(), touched.end());
+    interval.blocks.reserve(touched.size());
+    for (uint32_t b : touched) {
+        interval.blocks.push_back({b, counts[b]});
+        counts[b] = 0;
+    }
+    touched.clear();
+
+    committed += filled;
+    filled = 0;
+    done.push_back(move(interval));
+}
@@ -0,0 +1,187 @@
+#include "../include/blockcache.h"
+#include "../include/core.h"
+
+static bool endsBlock(Op op) {
+    return op == Op::BEQ || op == Op::BNE || op == Op::JAL || op == Op::HALT;
+}
+
+BlockCache::BlockCache(const DecodedProgram& program) : program(program) {}
+
+BlockCache::~BlockCache() {
+    if (watchedMem) watchedMem->removeWriteWatch(watchId);
+}
+
+unique_ptr<TranslatedBlock> BlockCache::translate(uint32_t pc) {
+    unique_ptr<TranslatedBlock> block(new TranslatedBlock());
+    block->startPC = pc;
+    uint32_t cur = pc;
+    while (true) {
+        const DecodedInstr& d = program.at(cur);
+        block->ops.push_back(d);
+        cur += 4;
+        if (endsBlock(d.op) || block->ops.size() >= maxBlockLen) break;
+    }
+    block->endPC = cur;
+    codeLo = min(codeLo, pc);
+    codeHi = max(codeHi, cur);
+    size_t n = block->ops.size() - (block->ops.back().op == Op::HALT);
+    block->timing = BlockTiming::of(block->ops.data(), n);
+    numTranslations++;
+    return block;
+}
+
+TranslatedBlock* BlockCache::lookup(uint32_t pc) {
+    auto it = blocks.find(pc);
+    if (it != blocks.end()) return it->second.get();
+    TranslatedBlock* block = translate(pc).release();
+    blocks[pc].reset(block);
+    return block;
+}
+
+void BlockCache::invalidate(uint32_t lo, uint32_t hi) {
+    bool dropped = false;
+    for (auto it = blocks.begin(); it != blocks.end();) {
+        TranslatedBlock* b = it->second.get();
+        if (b->startPC < hi && b->endPC > lo) {
+            b->valid = false;
+            retired.push_back(std::move(it->second));
+            it = blocks.erase(it);
+            dropped = true;
+        } else {
+            ++it;
+        }
+    }
+    if (!dropped) return;
+    // any remaining chain may point at a dropped block
+    for (auto& entry : blocks) {
+        entry.second->taken = nullptr;
+        entry.second->fallthrough = nullptr;
+    }
+    for (auto& b : retired) {
+        b->taken = nullptr;
+        b->fallthrough = nullptr;
+    }
+}
+
+void BlockCache::watchStores(DataMem& dmem, uint32_t lo, uint32_t hi) {
+    if (watchedMem) watchedMem->removeWriteWatch(watchId);
+    watchedMem = &dmem;
+    watchId = dmem.addWriteWatch(lo, hi, [this](uint32_t addr) {
+        if (addr < codeHi && (uint64_t)addr + 4 > codeLo) invalidate(addr, addr + 4);
+    });
+}
+
+// ==========================================
+// BLOCK ENGINE FOR SingleStageCore
+// ==========================================
+
+template <class Tracer, class Stats, class Memory>
+uint64_t SingleStageCoreT<Tracer, Stats, Memory>::runBlocks(uint64_t maxInstrs) {
+    if (!blocks) blocks.reset(new BlockCache(program));
+    if (halted || maxInstrs == 0) return 0;
+    if (state.IF.nop) {  // HALT already executed, only the drain cycle is left
+        step();
+        return 0;
+    }
+
+    uint32_t regs[32];
+    for (int i = 0; i < 32; i++) {
+        regs[i] = myRF.readReg(i);
+    }
+    uint32_t pc = state.IF.PC;
+    uint64_t executed = 0;
+
+    auto retire = [&](const DecodedInstr& d, uint32_t next_pc, uint32_t mem_addr, bool taken) {
+        regs[0] = 0;
+        stats.retire(d.op);
+        stats.commit(d, pc, mem_addr, taken);
+        if constexpr (Tracer::everyCycle) {
+            myRF.writeReg(d.rd, regs[d.rd]);
+            state.IF.PC = next_pc;
+            dumpCycle();
+        }
+        cycle++;
+    };
+
+    TranslatedBlock* b = blocks->lookup(pc);
+    while (true) {
+        size_t n = b->ops.size();
+        const DecodedInstr& last = b->ops[n - 1];
+        // leave HALT and partial blocks to step()
+        if (last.op == Op::HALT) n--;
+        if (n == 0 || executed + n > maxInstrs) break;
+
+        for (size_t i = 0; i < n; i++) {
+            const DecodedInstr& d = b->ops[i];
+            uint32_t next_pc = pc + 4;
+            uint32_t mem_addr = 0;
+            bool taken = false;
+            switch (d.op) {
+                case Op::ADD:  regs[d.rd] = regs[d.rs1] + regs[d.rs2]; break;
+                case Op::SUB:  regs[d.rd] = regs[d.rs1] - regs[d.rs2]; break;
+                case Op::XOR:  regs[d.rd] = regs[d.rs1] ^ regs[d.rs2]; break;
+                case Op::OR:   regs[d.rd] = regs[d.rs1] | regs[d.rs2]; break;
+                case Op::AND:  regs[d.rd] = regs[d.rs1] & regs[d.rs2]; break;
+                case Op::ADDI: regs[d.rd] = regs[d.rs1] + (uint32_t)d.imm; break;
+                case Op::XORI: regs[d.rd] = regs[d.rs1] ^ (uint32_t)d.imm; break;
+                case Op::ORI:  regs[d.rd] = regs[d.rs1] | (uint32_t)d.imm; break;
+                case Op::ANDI: regs[d.rd] = regs[d.rs1] & (uint32_t)d.imm; break;
+                case Op::LW:
+                    mem_addr = regs[d.rs1] + d.imm;
+                    regs[d.rd] = Memory::load(ext_dmem, mem_addr);
+                    break;
+                case Op::SW:
+                    mem_addr = regs[d.rs1] + d.imm;
+                    Memory::store(ext_dmem, mem_addr, regs[d.rs2]);
+                    break;
+                case Op::BEQ:
+                    taken = regs[d.rs1] == regs[d.rs2];
+                    break;
+                case Op::BNE:
+                    taken = regs[d.rs1] != regs[d.rs2];
+                    break;
+                case Op::JAL:
+                    regs[d.rd] = pc + 4;
+                    taken = true;
+                    break;
+                default:
+                    break;
+            }
+            if (taken) next_pc = d.target;
+            retire(d, next_pc, mem_addr, taken);
+            pc = next_pc;
+        }
+        executed += n;
+        if (n < b->ops.size()) break;  // stopped in front of HALT
+
+        // follow (or create) the chain to the successor block; a block a
+        // store dropped while it ran has no chains left to follow
+        TranslatedBlock* next;
+        if (b->valid) {
+            TranslatedBlock*& link = (pc != b->endPC) ? b->taken : b->fallthrough;
+            if (!link) link = blocks->lookup(pc);
+            next = link;
+        } else {
+            next = blocks->lookup(pc);
+        }
+        blocks->collect();  // no dropped block is referenced past this point
+        b = next;
+    }
+
+    for (int i = 1; i < 32; i++) {
+        myRF.writeReg(i, regs[i]);
+    }
+    state.IF.PC = pc;
+    nextState = state;
+
+    // HALT, the drain cycle and any remaining budget go through step()
+    while (!halted && executed < maxInstrs) {
+        if (!state.IF.nop) executed++;
+        step();
+    }
+    return executed;
+}
+
+#define INSTANTIATE_SS(T, S, M) template uint64_t SingleStageCoreT<T, S, M>::runBlocks(uint64_t);
+SS_CORE_CONFIGS(INSTANTIATE_SS)
+#undef INSTANTIATE_SS
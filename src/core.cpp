@@ -11,10 +11,11 @@
 #include <iostream>
 #include <iomanip>
 #include <filesystem>
+#include <cstdio>
 
 // Core class implementations
-Core::Core(string ioDir, InsMem &imem, DataMem &dmem) 
-    : myRF(ioDir), ioDir{ioDir}, ext_imem{imem}, ext_dmem{dmem} {}
+Core::Core(string ioDir, const InsMem& imem, DataMem& dmem) 
+    : myRF(ioDir), ioDir{ioDir}, ext_imem{imem}, ext_dmem{dmem}, program{imem.getProgram()} {}
 
 void Core::setOutputDirectory(const string& outputDir) {
     if (outputDir.empty()) return;
@@ -42,6 +43,7 @@ void Core::outputPerformanceMetrics(const std::string& output_dir) {
     }
     
     // Calculate CPI and IPC
+    uint64_t instruction_count = getInstructionCount();
     double cpi = instruction_count > 0 ? (double)cycle / instruction_count : 0.0;
     double ipc = cycle > 0 ? (double)instruction_count / cycle : 0.0;
     
@@ -57,25 +59,19 @@ void Core::outputPerformanceMetrics(const std::string& output_dir) {
     outFile.close();
 }
 
-void Core::printState(stateStruct state, int cycle) {
-    string outputPath = getStateOutputPath();
-    ofstream printstate;
-    if (cycle == 0)
-        printstate.open(outputPath, std::ios_base::trunc);
-    else 
-        printstate.open(outputPath, std::ios_base::app);
-    if (printstate.is_open()) {
-        printstate << "----------------------------------------------------------------------" << endl;
-        printstate << "State after executing cycle: " << cycle << endl;
-        printstate << "IF.PC: " << state.IF.PC.to_ulong()  << endl; // to fit the printed state from 4?
-        printstate << "IF.nop: " << (state.IF.nop ? "True" : "False") << endl;
-        printstate.close();
-    }
-    else cout << "Unable to open " << outputPath << " for writing." << endl;
+void Core::printState(const IFStruct& fetch, int cycle) {
+    stateSink.put("----------------------------------------------------------------------\n");
+    stateSink.put("State after executing cycle: ");
+    stateSink.putUnsigned(cycle);
+    stateSink.put("\nIF.PC: ");
+    stateSink.putUnsigned(fetch.PC);
+    if (fetch.nop) stateSink.put("\nIF.nop: True\n");
+    else stateSink.put("\nIF.nop: False\n");
 }
 
 // SingleStageCore implementations
-SingleStageCore::SingleStageCore(string ioDir, InsMem &imem, DataMem &dmem)
+template <class Tracer, class Stats, class Memory>
+SingleStageCoreT<Tracer, Stats, Memory>::SingleStageCoreT(string ioDir, const InsMem& imem, DataMem& dmem)
     : Core(ioDir + "SS_", imem, dmem), opFilePath(ioDir + "/StateResult_SS.txt") {
     // Initialize single stage state - PC starts at 0 but will be updated before first print
     state.IF.PC = 0;
@@ -83,242 +79,210 @@ SingleStageCore::SingleStageCore(string ioDir, InsMem &imem, DataMem &dmem)
     nextState = state;
 }
 
-void SingleStageCore::setOutputDirectory(const string& outputDir) {
+template <class Tracer, class Stats, class Memory>
+void SingleStageCoreT<Tracer, Stats, Memory>::setOutputDirectory(const string& outputDir) {
     Core::setOutputDirectory(outputDir);
     opFilePath = outputDir + "/StateResult_SS.txt";
+    if (traceWriter) traceWriter->flush();
+    rfSink.close();
+    stateSink.close();
+}
+
+template <class Tracer, class Stats, class Memory>
+void SingleStageCoreT<Tracer, Stats, Memory>::openTrace() {
+    std::error_code ec;
+    std::filesystem::create_directories(ioDir, ec);
+    rfSink.open(ioDir + "/SS_RFResult.txt");
+    stateSink.open(opFilePath);
+    if (Tracer::everyCycle && !traceWriter) {
+        traceWriter = make_unique<TraceWriter<SSTraceRecord>>(
+            [this](const SSTraceRecord& record) { formatCycle(record); });
+    }
+}
+
+template <class Tracer, class Stats, class Memory>
+void SingleStageCoreT<Tracer, Stats, Memory>::formatCycle(const SSTraceRecord& record) {
+    myRF.traceRF(rfSink, record.cycle, record.regs);
+    Core::printState(record.fetch, record.cycle);
 }
 
-void SingleStageCore::step() {
+template <class Tracer, class Stats, class Memory>
+void SingleStageCoreT<Tracer, Stats, Memory>::flushTrace() {
+    if (traceWriter) traceWriter->flush();
+    rfSink.flush();
+    stateSink.flush();
+}
+
+template <class Tracer, class Stats, class Memory>
+void SingleStageCoreT<Tracer, Stats, Memory>::step() {
             // Initialize next state
             nextState = state;
             
             if (state.IF.nop) {
                 nopCycles++;
-                myRF.outputRF(cycle, ioDir);
-                Core::printState(state, cycle);
-                cycle++;
                 if (nopCycles >= 1) {  // Stop after 2 nop cycles
                     halted = true;
                 }
+                dumpCycle();
+                cycle++;
                 return;
             }            
-            // Fetch instruction
-            bitset<32> instruction = ext_imem.readInstr(state.IF.PC);
+            // Fetch the predecoded instruction
+            const DecodedInstr& d = program.at(state.IF.PC);
             
             // Check for HALT instruction (all 1s)
-            if (instruction.to_ulong() == 0xFFFFFFFF) {
+            if (d.op == Op::HALT) {
                 nextState.IF.nop = true;
-                instruction_count++; // Count HALT as an instruction
+                stats.retire(d.op); // Count HALT as an instruction
+                stats.commit(d, state.IF.PC, 0, false);
                 
                 // Simple HALT behavior - don't update PC
                 nextState.IF.PC = state.IF.PC;  // Keep current PC
                 
                 // Update state to reflect halt condition for printing
                 state = nextState;
-                myRF.outputRF(cycle, ioDir);
-                Core::printState(state, cycle);
+                dumpCycle();
                 cycle++;
                 return;
             }
             
             // Count this as an executed instruction
-            instruction_count++;
-            
-            // Decode instruction
-            uint32_t instr = static_cast<uint32_t>(instruction.to_ulong());
-            uint32_t opcode = instr & 0x7F;
-            uint32_t rd = (instr >> 7) & 0x1F;
-            uint32_t funct3 = (instr >> 12) & 0x7;
-            uint32_t rs1 = (instr >> 15) & 0x1F;
-            uint32_t rs2 = (instr >> 20) & 0x1F;
-            uint32_t funct7 = (instr >> 25) & 0x7F;
+            stats.retire(d.op);
             
             // Read register values
-            bitset<32> rs1_val = myRF.readRF(bitset<5>(rs1));
-            bitset<32> rs2_val = myRF.readRF(bitset<5>(rs2));
-            
-            // Execute based on opcode
-            bitset<32> alu_result;
-            bitset<32> write_data;
-            bool write_enable = false;
+            uint32_t rs1_val = myRF.readReg(d.rs1);
+            uint32_t rs2_val = myRF.readReg(d.rs2);
+            uint32_t imm = (uint32_t)d.imm;
             
-            switch (opcode) {
-                case 0x33: { // R-type (ADD, SUB, XOR, OR, AND)
-                    write_enable = true;
-                    if (funct3 == 0 && funct7 == 0) { // ADD
-                        alu_result = bitset<32>(rs1_val.to_ulong() + rs2_val.to_ulong());
-                    } else if (funct3 == 0 && funct7 == 0x20) { // SUB
-                        alu_result = bitset<32>(rs1_val.to_ulong() - rs2_val.to_ulong());
-                    } else if (funct3 == 4) { // XOR
-                        alu_result = rs1_val ^ rs2_val;
-                    } else if (funct3 == 6) { // OR
-                        alu_result = rs1_val | rs2_val;
-                    } else if (funct3 == 7) { // AND
-                        alu_result = rs1_val & rs2_val;
-                    }
-                    write_data = alu_result;
-                    nextState.IF.PC = bitset<32>(state.IF.PC.to_ulong() + 4);
-                    break;
-                }
-                case 0x13: { // I-type arithmetic (ADDI, XORI, ORI, ANDI)
-                    write_enable = true;
-                    int32_t imm = static_cast<int32_t>(instr) >> 20; // Sign extend
-                    if (funct3 == 0) { // ADDI
-                        alu_result = bitset<32>(rs1_val.to_ulong() + imm);
-                    } else if (funct3 == 4) { // XORI
-                        alu_result = rs1_val ^ bitset<32>(imm);
-                    } else if (funct3 == 6) { // ORI
-                        alu_result = rs1_val | bitset<32>(imm);
-                    } else if (funct3 == 7) { // ANDI
-                        alu_result = rs1_val & bitset<32>(imm);
-                    }
-                    write_data = alu_result;
-                    nextState.IF.PC = bitset<32>(state.IF.PC.to_ulong() + 4);
-                    break;
-                }
-                case 0x03: { // Load (LW)
-                    write_enable = true;
-                    int32_t imm = static_cast<int32_t>(instr) >> 20; // Sign extend
-                    uint32_t address = rs1_val.to_ulong() + imm;
-                    write_data = ext_dmem.readDataMem(bitset<32>(address));
-                    nextState.IF.PC = bitset<32>(state.IF.PC.to_ulong() + 4);
-                    break;
-                }
-                case 0x23: { // Store (SW)
-                    int32_t imm = ((instr >> 7) & 0x1F) | (((instr >> 25) & 0x7F) << 5);
-                    if (imm & 0x800) imm |= 0xFFFFF000; // Sign extend
-                    uint32_t address = rs1_val.to_ulong() + imm;
-                    ext_dmem.writeDataMem(bitset<32>(address), rs2_val);
-                    nextState.IF.PC = bitset<32>(state.IF.PC.to_ulong() + 4);
-                    break;
-                }
-                case 0x63: { // Branch (BEQ, BNE)
-                    int32_t imm = ((instr >> 7) & 0x1) << 11 |
-                                  ((instr >> 8) & 0xF) << 1 |
-                                  ((instr >> 25) & 0x3F) << 5 |
-                                  ((instr >> 31) & 0x1) << 12;
-                    if (imm & 0x1000) imm |= 0xFFFFE000; // Sign extend
-                    
-                    bool take_branch = false;
-                    if (funct3 == 0) { // BEQ
-                        take_branch = (rs1_val == rs2_val);
-                    } else if (funct3 == 1) { // BNE
-                        take_branch = (rs1_val != rs2_val);
-                    }
-                    
-                    if (take_branch) {
-                        nextState.IF.PC = bitset<32>(state.IF.PC.to_ulong() + imm);
-                    } else {
-                        nextState.IF.PC = bitset<32>(state.IF.PC.to_ulong() + 4);
-                    }
-                    break;
-                }
-                case 0x6F: { // JAL
-                    write_enable = true;
-                    write_data = bitset<32>(state.IF.PC.to_ulong() + 4);
-                    int32_t imm = ((instr >> 21) & 0x3FF) << 1 |
-                                  ((instr >> 20) & 0x1) << 11 |
-                                  ((instr >> 12) & 0xFF) << 12 |
-                                  ((instr >> 31) & 0x1) << 20;
-                    if (imm & 0x100000) imm |= 0xFFE00000; // Sign extend
-                    nextState.IF.PC = bitset<32>(state.IF.PC.to_ulong() + imm);
-                    break;
-                }
-                default:
-                    // Update PC for normal instructions
-                    nextState.IF.PC = bitset<32>(state.IF.PC.to_ulong() + 4);
-                    break;
+            // Execute from the instruction's isaTable properties
+            uint32_t next_pc = state.IF.PC + 4;
+            uint32_t operand_2 = (d.flags & IMM_OPERAND) ? imm : rs2_val;
+            uint32_t alu_result = aluCompute(d.alu, rs1_val, operand_2);
+            uint32_t write_data = alu_result;
+            bool write_enable = d.flags & WRITES_RD;
+
+            if (d.flags & MEM_READ) {
+                write_data = Memory::load(ext_dmem, alu_result);
+            }
+            if (d.flags & MEM_WRITE) {
+                Memory::store(ext_dmem, alu_result, rs2_val);
+            }
+            bool taken = (d.flags & JUMP) || ((d.flags & BRANCH) && branchTaken(d.cond, rs1_val, rs2_val));
+            if (d.flags & JUMP) {
+                write_data = next_pc; // return address
             }
+            if (taken) {
+                next_pc = d.target;
+            }
+            nextState.IF.PC = next_pc;
+            stats.commit(d, state.IF.PC, alu_result, taken);
             
             // Write back to register file
-            if (write_enable && rd != 0) { // Don't write to register 0
-                myRF.writeRF(bitset<5>(rd), write_data);
+            if (write_enable && d.rd != 0) { // Don't write to register 0
+                myRF.writeReg(d.rd, write_data);
             }
             
             // Update state to reflect instruction execution
             state = nextState;
             
-            myRF.outputRF(cycle, ioDir); // dump RF
-            Core::printState(state, cycle); //print states after executing cycle 0, cycle 1, cycle 2 ... 
+            dumpCycle(); //print states after executing cycle 0, cycle 1, cycle 2 ... 
             
             cycle++;
         }
 
-void SingleStageCore::printState() {
-    ofstream printstate;
-    if (cycle == 0)
-        printstate.open(opFilePath, std::ios_base::trunc);
-    else 
-        printstate.open(opFilePath, std::ios_base::app);
-    if (printstate.is_open()) {
-        printstate<<"----------------------------------------------------------------------"<<endl;
-        printstate<<"State after executing cycle: "<<cycle<<endl; 
-        printstate<<"IF.PC: "<<state.IF.PC.to_ulong()<<endl;
-        printstate<<"IF.nop: "<<(state.IF.nop ? "True" : "False")<<endl;
+template <class Tracer, class Stats, class Memory>
+RunResult SingleStageCoreT<Tracer, Stats, Memory>::runUntil(const StopCondition& stop) {
+    RunResult r{StopReason::Halted, 0, 0};
+    bool written = false;
+    int watch = stop.watchWrites
+        ? ext_dmem.addWriteWatch(stop.writeLo, stop.writeHi, [&written](uint32_t) { written = true; })
+        : -1;
+
+    while (true) {
+        if (halted) { r.reason = StopReason::Halted; break; }
+        if (r.cycles >= stop.maxCycles) { r.reason = StopReason::CycleLimit; break; }
+        if (r.instructions >= stop.maxInstructions) { r.reason = StopReason::InstructionLimit; break; }
+        if (stop.matchPC && r.cycles > 0 && !state.IF.nop && state.IF.PC == stop.pc) {
+            r.reason = StopReason::PCMatch;
+            break;
+        }
+        // every cycle with a live IF retires one instruction (HALT included)
+        r.instructions += !state.IF.nop;
+        SingleStageCoreT::step();  // qualified: no virtual dispatch
+        r.cycles++;
+        if (written) { r.reason = StopReason::MemoryWrite; break; }
     }
-    else cout<<"Unable to open SS StateResult output file." << endl;
-    printstate.close();
-}
-
 
-// ==========================================
-// HELPER FUNCTIONS (Internal)
-// ==========================================
+    if (watch >= 0) ext_dmem.removeWriteWatch(watch);
+    return r;
+}
 
-// Helper to convert std::string to uint32_t (if needed) or handle bit manipulation
-static uint32_t get_bits(uint32_t val, int high, int low) {
-    uint32_t mask = (1ULL << (high - low + 1)) - 1;
-    return (val >> low) & mask;
+template <class Tracer, class Stats, class Memory>
+ArchState SingleStageCoreT<Tracer, Stats, Memory>::getArchState() const {
+    ArchState s;
+    s.pc = state.IF.PC;
+    for (uint32_t r = 0; r < 32; r++) s.regs[r] = myRF.readReg(r);
+    s.instructions = stats.instructions();
+    // after HALT the PC stays on it and the receiving core executes it again
+    if (state.IF.nop && s.instructions > 0) s.instructions--;
+    return s;
 }
 
-static int32_t sign_extend(uint32_t val, int bits) {
-    int32_t shift = 32 - bits;
-    return ((int32_t)val << shift) >> shift;
+template <class Tracer, class Stats, class Memory>
+void SingleStageCoreT<Tracer, Stats, Memory>::dumpCycle() {
+    if constexpr (Tracer::everyCycle) {
+        if (!rfSink.isOpen()) openTrace();
+    } else if (Tracer::finalCycle && halted) {
+        // only the final cycle is written, so drop records of earlier runs
+        openTrace();
+    } else {
+        return;
+    }
+    SSTraceRecord record;
+    record.cycle = cycle;
+    record.fetch = state.IF;
+    memcpy(record.regs, myRF.values(), sizeof(record.regs));
+    if (traceWriter) traceWriter->push(record);
+    else formatCycle(record);
+    if (halted) flushTrace();
 }
 
-// Convert uint32 to bitset<32> string for printing (matches Python formatting)
-static string int2bin(uint32_t val) {
-    return bitset<32>(val).to_string();
+template <class Tracer, class Stats, class Memory>
+void SingleStageCoreT<Tracer, Stats, Memory>::printState() {
+    if (!stateSink.isOpen()) openTrace();
+    if (traceWriter) traceWriter->flush();
+    Core::printState(state.IF, cycle);
+    stateSink.flush();
 }
 
-// ==========================================
+
 // ==========================================
 // STAGE LOGIC
 // ==========================================
 
 // --- Instruction Fetch ---
-InstructionFetchStage::InstructionFetchStage(State_five* s, InsMem* im) 
-    : state(s), ins_mem(im) {}
+InstructionFetchStage::InstructionFetchStage(State_five* s, const DecodedProgram* p) 
+    : state(s), program(p) {}
 
 void InstructionFetchStage::run() {
     if (state->IF.nop || state->ID.nop || (state->ID.hazard_nop && state->EX.nop)) {
         return;
     }
 
-    // INTERFACE ADAPTER: uint32 -> bitset<32>
-    bitset<32> addr(state->IF.PC);
-    
-    // INTERFACE CALL
-    bitset<32> instr_bits = ins_mem->readInstr(addr);
-    
-    // INTERFACE ADAPTER: bitset<32> -> uint32
-    uint32_t instr = (uint32_t)instr_bits.to_ulong();
+    const DecodedInstr& d = program->at(state->IF.PC);
     
-    if (instr_bits.all()) { // Equivalent to "1"*32 check
+    if (d.op == Op::HALT) {
         state->IF.nop = true;
         state->ID.nop = true;
     } else {
         state->ID.PC = state->IF.PC;
         state->IF.PC += 4;
-        state->ID.instr = instr;
+        state->ID.instr = d.raw;
     }
 }
 
 // --- Instruction Decode ---
-InstructionDecodeStage::InstructionDecodeStage(State_five* s, RegisterFile* r) 
-    : state(s), rf(r) {}
-
-int InstructionDecodeStage::detect_hazard(uint32_t rs) {
+int ForwardingHazards::detect(State_five* state, uint32_t rs) {
     if (rs == state->MEM.write_reg_addr && rs != 0 && state->MEM.read_mem == 0) {
         return 2; // EX to 1st
     } else if (rs == state->WB.write_reg_addr && rs != 0 && state->WB.write_enable) {
@@ -330,15 +294,34 @@ int InstructionDecodeStage::detect_hazard(uint32_t rs) {
     return 0;
 }
 
-uint32_t InstructionDecodeStage::read_data(uint32_t rs, int forward_signal) {
+uint32_t ForwardingHazards::read(State_five* state, RegisterFile* rf, uint32_t rs, int forward_signal) {
     if (forward_signal == 1) return state->WB.write_data;
     if (forward_signal == 2) return state->MEM.alu_result;
     
-    // INTERFACE CALL: readRF(bitset<5>) -> bitset<32>
-    return (uint32_t)rf->readRF(bitset<5>(rs)).to_ulong();
+    return rf->readReg(rs);
+}
+
+int StallingHazards::detect(State_five* state, uint32_t rs) {
+    if (rs == 0) return 0;
+    // producers still in flight: the one EX just moved into MEM and the one
+    // MEM just moved into WB (WB has already written back this cycle)
+    bool inMem = exLive && state->MEM.write_enable && rs == state->MEM.write_reg_addr;
+    bool inWb = memLive && state->WB.write_enable && rs == state->WB.write_reg_addr;
+    if (inMem || inWb) state->ID.hazard_nop = true;
+    return 0;
+}
+
+uint32_t StallingHazards::read(State_five*, RegisterFile* rf, uint32_t rs, int) {
+    return rf->readReg(rs);
 }
 
-void InstructionDecodeStage::run() {
+template <class Hazards, class Stats>
+InstructionDecodeStage<Hazards, Stats>::InstructionDecodeStage(State_five* s, RegisterFile* r, const DecodedProgram* p,
+                                                               Hazards* h, Stats* st)
+    : state(s), rf(r), program(p), hazards(h), stats(st) {}
+
+template <class Hazards, class Stats>
+void InstructionDecodeStage<Hazards, Stats>::run() {
     if (state->ID.nop) {
         if (!state->IF.nop) state->ID.nop = false;
         return;
@@ -352,123 +335,59 @@ void InstructionDecodeStage::run() {
     state->ID.hazard_nop = false;
     state->EX.write_reg_addr = 0;
 
-    uint32_t opcode = get_bits(state->ID.instr, 6, 0);
-    uint32_t func3 = get_bits(state->ID.instr, 14, 12);
-    uint32_t rd = get_bits(state->ID.instr, 11, 7);
-    uint32_t rs1 = get_bits(state->ID.instr, 19, 15);
-    uint32_t rs2 = get_bits(state->ID.instr, 24, 20);
-    uint32_t func7 = get_bits(state->ID.instr, 31, 25);
-
-    // R-Type
-    if (opcode == 0x33) { 
-        int fwd1 = detect_hazard(rs1);
-        int fwd2 = detect_hazard(rs2);
-
-        if (state->ID.hazard_nop) { state->EX.nop = true; return; }
-
-        state->EX.rs = rs1;
-        state->EX.rt = rs2;
-        state->EX.read_data_1 = read_data(rs1, fwd1);
-        state->EX.read_data_2 = read_data(rs2, fwd2);
-        state->EX.write_reg_addr = rd;
-        state->EX.write_enable = true;
+    const DecodedInstr& d = program->at(state->ID.PC);
 
-        if (func3 == 0x0) { 
-            state->EX.alu_op = "00";
-            if (func7 == 0x20) { 
-                state->EX.read_data_2 = -((int32_t)state->EX.read_data_2);
-            }
-        } else if (func3 == 0x7) state->EX.alu_op = "01"; 
-        else if (func3 == 0x6) state->EX.alu_op = "10"; 
-        else if (func3 == 0x4) state->EX.alu_op = "11"; 
+    // hazards are checked for the source registers the instruction reads
+    int fwd1 = (d.flags & READS_RS1) ? detect_hazard(d.rs1) : 0;
+    int fwd2 = (d.flags & READS_RS2) ? detect_hazard(d.rs2) : 0;
+    if (state->ID.hazard_nop) {
+        stats->stall();
+        state->EX.nop = true;
+        return;
     }
-    // I-Type
-    else if (opcode == 0x13 || opcode == 0x03) { 
-        int fwd1 = detect_hazard(rs1);
-        if (state->ID.hazard_nop) { state->EX.nop = true; return; }
-
-        state->EX.rs = rs1;
-        state->EX.read_data_1 = read_data(rs1, fwd1);
-        state->EX.write_reg_addr = rd;
-        state->EX.is_I_type = true;
-        
-        state->EX.imm = sign_extend(get_bits(state->ID.instr, 31, 20), 12);
-        
-        state->EX.write_enable = true;
-        state->EX.read_mem = (opcode == 0x03);
 
-        if (func3 == 0x0) state->EX.alu_op = "00";
-        else if (func3 == 0x7) state->EX.alu_op = "01";
-        else if (func3 == 0x6) state->EX.alu_op = "10";
-        else if (func3 == 0x4) state->EX.alu_op = "11";
+    if (d.flags & READS_RS1) {
+        state->EX.rs = d.rs1;
+        state->EX.read_data_1 = read_data(d.rs1, fwd1);
     }
-    // J-Type (JAL)
-    else if (opcode == 0x6F) { 
-        uint32_t bit31 = get_bits(state->ID.instr, 31, 31);
-        uint32_t bit19_12 = get_bits(state->ID.instr, 19, 12);
-        uint32_t bit20 = get_bits(state->ID.instr, 20, 20);
-        uint32_t bit30_21 = get_bits(state->ID.instr, 30, 21);
-        
-        uint32_t imm_val = (bit31 << 20) | (bit19_12 << 12) | (bit20 << 11) | (bit30_21 << 1);
-        state->EX.imm = sign_extend(imm_val, 21);
-        
-        state->EX.write_reg_addr = rd;
-        state->EX.read_data_1 = state->ID.PC;
-        state->EX.read_data_2 = 4;
+    if (d.flags & READS_RS2) {
+        state->EX.rt = d.rs2;
+        state->EX.read_data_2 = read_data(d.rs2, fwd2);
+    }
+    if (specOf(d.op).format != Format::R && specOf(d.op).format != Format::None) {
+        state->EX.imm = d.imm;
+    }
+    if (d.flags & WRITES_RD) {
+        state->EX.write_reg_addr = d.rd;
         state->EX.write_enable = true;
-        state->EX.alu_op = "00";
-        
-        state->IF.PC = state->ID.PC + (int32_t)state->EX.imm;
-        state->ID.nop = true;
     }
-    // B-Type
-    else if (opcode == 0x63) { 
-        int fwd1 = detect_hazard(rs1);
-        int fwd2 = detect_hazard(rs2);
-        if (state->ID.hazard_nop) { state->EX.nop = true; return; }
-
-        state->EX.rs = rs1;
-        state->EX.rt = rs2;
-        state->EX.read_data_1 = read_data(rs1, fwd1);
-        state->EX.read_data_2 = read_data(rs2, fwd2);
-        
-        int32_t diff = (int32_t)state->EX.read_data_1 - (int32_t)state->EX.read_data_2;
-        
-        uint32_t bit31 = get_bits(state->ID.instr, 31, 31);
-        uint32_t bit7 = get_bits(state->ID.instr, 7, 7);
-        uint32_t bit30_25 = get_bits(state->ID.instr, 30, 25);
-        uint32_t bit11_8 = get_bits(state->ID.instr, 11, 8);
-        
-        uint32_t imm_val = (bit31 << 12) | (bit7 << 11) | (bit30_25 << 5) | (bit11_8 << 1);
-        state->EX.imm = sign_extend(imm_val, 13);
-
-        bool branch = ((diff == 0 && func3 == 0x0) || (diff != 0 && func3 == 0x1)); 
-        
-        if (branch) {
-            state->IF.PC = state->ID.PC + (int32_t)state->EX.imm;
+    state->EX.is_I_type = d.flags & IMM_OPERAND;
+    state->EX.read_mem = d.flags & MEM_READ;
+    state->EX.write_mem = d.flags & MEM_WRITE;
+
+    if (d.flags & BRANCH) {
+        // resolved here; the branch itself never enters EX
+        if (branchTaken(d.cond, state->EX.read_data_1, state->EX.read_data_2)) {
+            state->IF.PC = d.target;
             state->ID.nop = true;
-            state->EX.nop = true;
-        } else {
-            state->EX.nop = true;
+            stats->flush();
+        }
+        state->EX.nop = true;
+    } else if (d.flags & JUMP) {
+        // the return address is computed by EX as PC + 4
+        state->EX.read_data_1 = state->ID.PC;
+        state->EX.read_data_2 = 4;
+        state->EX.alu_op = d.alu;
+        state->IF.PC = d.target;
+        state->ID.nop = true;
+        stats->flush();
+    } else if (d.op != Op::NOP) {
+        state->EX.alu_op = d.alu;
+        // SUB runs as ADD of the negated operand
+        if (d.alu == AluOp::SUB) {
+            state->EX.alu_op = AluOp::ADD;
+            state->EX.read_data_2 = -state->EX.read_data_2;
         }
-    }
-    // S-Type
-    else if (opcode == 0x23) { 
-        int fwd1 = detect_hazard(rs1);
-        int fwd2 = detect_hazard(rs2);
-        if (state->ID.hazard_nop) { state->EX.nop = true; return; }
-
-        state->EX.rs = rs1;
-        state->EX.rt = rs2;
-        state->EX.read_data_1 = read_data(rs1, fwd1);
-        state->EX.read_data_2 = read_data(rs2, fwd2);
-        
-        uint32_t imm_val = (get_bits(state->ID.instr, 31, 25) << 5) | get_bits(state->ID.instr, 11, 7);
-        state->EX.imm = sign_extend(imm_val, 12);
-        
-        state->EX.is_I_type = true;
-        state->EX.write_mem = true;
-        state->EX.alu_op = "00";
     }
 
     if (state->IF.nop) state->ID.nop = true;
@@ -488,16 +407,7 @@ void ExecutionStage::run() {
                          ? state->EX.read_data_2 
                          : state->EX.imm;
 
-    int32_t op1_signed = (int32_t)operand_1;
-    int32_t op2_signed = (int32_t)operand_2;
-    int32_t result = 0;
-
-    if (state->EX.alu_op == "00") result = op1_signed + op2_signed;
-    else if (state->EX.alu_op == "01") result = op1_signed & op2_signed;
-    else if (state->EX.alu_op == "10") result = op1_signed | op2_signed;
-    else if (state->EX.alu_op == "11") result = op1_signed ^ op2_signed;
-
-    state->MEM.alu_result = (uint32_t)result;
+    state->MEM.alu_result = aluCompute(state->EX.alu_op, operand_1, operand_2);
     state->MEM.rs = state->EX.rs;
     state->MEM.rt = state->EX.rt;
     state->MEM.read_mem = state->EX.read_mem;
@@ -512,25 +422,21 @@ void ExecutionStage::run() {
 }
 
 // --- Memory Access ---
-MemoryAccessStage::MemoryAccessStage(State_five* s, DataMem* dm) 
+template <class Memory>
+MemoryAccessStage<Memory>::MemoryAccessStage(State_five* s, DataMem* dm) 
     : state(s), data_mem(dm) {}
 
-void MemoryAccessStage::run() {
+template <class Memory>
+void MemoryAccessStage<Memory>::run() {
     if (state->MEM.nop) {
         if (!state->EX.nop) state->MEM.nop = false;
         return;
     }
 
     if (state->MEM.read_mem) {
-        // INTERFACE ADAPTER
-        bitset<32> addr(state->MEM.alu_result);
-        bitset<32> data = data_mem->readDataMem(addr);
-        state->WB.write_data = (uint32_t)data.to_ulong();
+        state->WB.write_data = Memory::load(*data_mem, state->MEM.alu_result);
     } else if (state->MEM.write_mem) {
-        // INTERFACE ADAPTER
-        bitset<32> addr(state->MEM.alu_result);
-        bitset<32> data(state->MEM.store_data);
-        data_mem->writeDataMem(addr, data);
+        Memory::store(*data_mem, state->MEM.alu_result, state->MEM.store_data);
     } else {
         state->WB.write_data = state->MEM.alu_result;
         state->MEM.store_data = state->MEM.alu_result;
@@ -553,8 +459,7 @@ void WriteBackStage::run() {
     }
 
     if (state->WB.write_enable) {
-        // INTERFACE ADAPTER
-        rf->writeRF(bitset<5>(state->WB.write_reg_addr), bitset<32>(state->WB.write_data));
+        rf->writeReg(state->WB.write_reg_addr, state->WB.write_data);
     }
 
     if (state->MEM.nop) state->WB.nop = true;
@@ -564,22 +469,33 @@ void WriteBackStage::run() {
 // CORE CLASS IMPLEMENTATION
 // ==========================================
 
-FiveStageCore::FiveStageCore(string ioDir, InsMem& imem, DataMem& dmem)
+template <class Tracer, class Stats, class Memory, class Hazards>
+FiveStageCoreT<Tracer, Stats, Memory, Hazards>::FiveStageCoreT(string ioDir, const InsMem& imem, DataMem& dmem)
     : ioDir(ioDir), 
       opFilePath(ioDir + "/StateResult_FS.txt"),
       ext_imem(&imem), 
       ext_dmem(&dmem),
       myRF(ioDir),
-      if_stage(&state, &imem),
-      id_stage(&state, &myRF),
+      if_stage(&state, &imem.getProgram()),
+      id_stage(&state, &myRF, &imem.getProgram(), &hazards, &stats),
       ex_stage(&state),
       mem_stage(&state, &dmem),
       wb_stage(&state, &myRF),
-      cycle(0), num_instr(0), halted(false) {
+      cycle(0), halted(false) {
           myRF.setFilePrefix("FS_");
       }
 
-void FiveStageCore::step() {
+template <class Tracer, class Stats, class Memory, class Hazards>
+void FiveStageCoreT<Tracer, Stats, Memory, Hazards>::setArchState(const ArchState& s) {
+    for (uint32_t r = 1; r < 32; r++) myRF.writeReg(r, s.regs[r]);
+    state.IF.PC = s.pc;
+    fastForwarded = s.instructions;
+}
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+bool FiveStageCoreT<Tracer, Stats, Memory, Hazards>::stepCycle() {
+    if (bubbleSkip && state.ID.nop && !state.IF.nop && !state.ID.hazard_nop) return refillCycle();
+
     // Check if already halted (all stages were nop in previous cycle)
     bool was_all_nop = state.IF.nop && state.ID.nop && state.EX.nop && state.MEM.nop && state.WB.nop;
     
@@ -588,6 +504,8 @@ void FiveStageCore::step() {
     bool if_was_nop = state.IF.nop;
     uint32_t prev_id_instr = state.ID.instr;
 
+    hazards.beginCycle(state);
+
     // Run stages in reverse order
     wb_stage.run();
     mem_stage.run();
@@ -599,17 +517,19 @@ void FiveStageCore::step() {
     // 1. ID was nop but now has an instruction, OR
     // 2. ID was not nop and now has a different instruction
     // 3. IF fetched HALT (IF was not nop, but now both IF and ID are nop)
+    bool counted = false;
     if (!state.ID.nop) {
         if (id_was_nop || state.ID.instr != prev_id_instr) {
-            num_instr++;
+            stats.retire(ext_imem->getProgram().at(state.ID.PC).op);
+            counted = true;
         }
     } else if (!if_was_nop && state.IF.nop && state.ID.nop) {
         // IF fetched HALT instruction, count it
-        num_instr++;
+        stats.retire(Op::HALT);
+        counted = true;
     }
 
-    myRF.outputRF(cycle);
-    printState(state, cycle);
+    dumpCycle(was_all_nop);
 
     cycle++;
     
@@ -617,92 +537,244 @@ void FiveStageCore::step() {
     if (was_all_nop) {
         halted = true;
     }
+    return counted;
+}
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+bool FiveStageCoreT<Tracer, Stats, Memory, Hazards>::refillCycle() {
+    wb_stage.run();
+    mem_stage.run();
+    ex_stage.run();  // holds its bubble, or runs the JAL that made the one in ID
+    state.ID.nop = false;
+    if_stage.run();
+    // the first instruction after the bubble, or HALT
+    stats.retire(state.ID.nop ? Op::HALT : ext_imem->getProgram().at(state.ID.PC).op);
+    dumpCycle(false);
+    cycle++;
+    return true;
+}
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+uint64_t FiveStageCoreT<Tracer, Stats, Memory, Hazards>::drain(uint64_t maxCycles, const bool& stop) {
+    TraceRecord records[maxDrainCycles];
+    int traced = 0;
+    uint64_t n = 0;
+    while (n < maxCycles && !halted) {
+        bool last = state.EX.nop && state.MEM.nop && state.WB.nop;
+        // IF and ID hold HALT's bubbles for good
+        wb_stage.run();
+        mem_stage.run();
+        ex_stage.run();
+        if (Tracer::everyCycle) {
+            fillRecord(records[traced++]);
+        } else if (last) {
+            dumpCycle(true);
+        }
+        cycle++;
+        n++;
+        halted = last;
+        if (stop) break;
+    }
+    if (traced) {
+        openCycleTrace();
+        traceWriter->push(records, traced);
+        if (halted) flushTrace();
+    }
+    return n;
+}
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+RunResult FiveStageCoreT<Tracer, Stats, Memory, Hazards>::runUntil(const StopCondition& stop) {
+    RunResult r{StopReason::Halted, 0, 0};
+    bool written = false;
+    int watch = stop.watchWrites
+        ? ext_dmem->addWriteWatch(stop.writeLo, stop.writeHi, [&written](uint32_t) { written = true; })
+        : -1;
+
+    while (true) {
+        if (halted) { r.reason = StopReason::Halted; break; }
+        if (r.cycles >= stop.maxCycles) { r.reason = StopReason::CycleLimit; break; }
+        if (r.instructions >= stop.maxInstructions) { r.reason = StopReason::InstructionLimit; break; }
+        if (stop.matchPC && r.cycles > 0 && !state.IF.nop && state.IF.PC == stop.pc) {
+            r.reason = StopReason::PCMatch;
+            break;
+        }
+        if (bubbleSkip && state.IF.nop && state.ID.nop) {
+            r.cycles += drain(stop.maxCycles - r.cycles, written);
+        } else {
+            r.instructions += stepCycle();
+            r.cycles++;
+        }
+        if (written) { r.reason = StopReason::MemoryWrite; break; }
+    }
+
+    if (watch >= 0) ext_dmem->removeWriteWatch(watch);
+    return r;
+}
+
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+void FiveStageCoreT<Tracer, Stats, Memory, Hazards>::dumpCycle(bool last) {
+    if (!(Tracer::everyCycle || (Tracer::finalCycle && last))) return;
+    openCycleTrace();
+    TraceRecord record;
+    fillRecord(record);
+    if (traceWriter) traceWriter->push(record);
+    else formatCycle(record);
+    if (last) flushTrace();
+}
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+void FiveStageCoreT<Tracer, Stats, Memory, Hazards>::openCycleTrace() {
+    // the final-cycle tracer opens (and so truncates) the files at halt
+    if (!rfSink.isOpen()) rfSink.open(myRF.outputFile);
+    if (!stateSink.isOpen()) stateSink.open(opFilePath);
+    if (Tracer::everyCycle && !traceWriter) {
+        traceWriter = make_unique<TraceWriter<TraceRecord>>(
+            [this](const TraceRecord& record) { formatCycle(record); });
+    }
+}
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+void FiveStageCoreT<Tracer, Stats, Memory, Hazards>::fillRecord(TraceRecord& record) const {
+    record.cycle = cycle;
+    record.state = state;
+    memcpy(record.regs, myRF.values(), sizeof(record.regs));
+}
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+void FiveStageCoreT<Tracer, Stats, Memory, Hazards>::formatCycle(const TraceRecord& record) {
+    myRF.traceRF(rfSink, record.cycle, record.regs);
+    printState(record.state, record.cycle);
+}
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+void FiveStageCoreT<Tracer, Stats, Memory, Hazards>::flushTrace() {
+    if (traceWriter) traceWriter->flush();
+    rfSink.flush();
+    stateSink.flush();
 }
 
-bool FiveStageCore::isHalted() const { 
+template <class Tracer, class Stats, class Memory, class Hazards>
+bool FiveStageCoreT<Tracer, Stats, Memory, Hazards>::isHalted() const { 
     return halted; 
 }
 
 
 
-void FiveStageCore::printState(State_five state, int cycle) {
-    ofstream printstate;
-    if (cycle == 0)
-        printstate.open(opFilePath, std::ios_base::trunc);
-    else 
-        printstate.open(opFilePath, std::ios_base::app);
-    if (printstate.is_open()) {
-        printstate<<"----------------------------------------------------------------------"<<endl;
-        printstate<<"State after executing cycle: "<<cycle<<endl; 
+// --- state record helpers, formatting straight into the sink ---
 
-        printstate<<"IF.nop: "<<(state.IF.nop ? "True" : "False")<<endl;
-        printstate<<"IF.PC: "<<state.IF.PC<<endl;        
+static void traceNop(TraceSink& out, const char* label, size_t n, bool nop) {
+    out.put(label, n);
+    if (nop) out.put("True\n");
+    else out.put("False\n");
+}
 
-        printstate<<"ID.nop: "<<(state.ID.nop ? "True" : "False")<<endl;
-        printstate<<"ID.Instr: "<<bitset<32>(state.ID.instr)<<endl; 
+static void traceBits(TraceSink& out, const char* label, size_t n, uint32_t value, int width) {
+    out.put(label, n);
+    out.putBits(value, width);
+    out.newline();
+}
 
-        printstate<<"EX.nop: "<<(state.EX.nop ? "True" : "False")<<endl;
-        // Print EX.instr - empty if instr is 0, otherwise show the instruction
-        if (state.EX.instr == 0) {
-            printstate<<"EX.instr: "<<endl;
-        } else {
-            printstate<<"EX.instr: "<<bitset<32>(state.EX.instr)<<endl;
-        }
-        printstate<<"EX.Read_data1: "<<bitset<32>(state.EX.read_data_1)<<endl;
-        printstate<<"EX.Read_data2: "<<bitset<32>(state.EX.read_data_2)<<endl;
+static void traceFlag(TraceSink& out, const char* label, size_t n, bool value) {
+    out.put(label, n);
+    out.put(value ? "1\n" : "0\n", 2);
+}
+
+#define LABEL(s) s, sizeof(s) - 1
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+void FiveStageCoreT<Tracer, Stats, Memory, Hazards>::printState(const State_five& state, int cycle) {
+    TraceSink& out = stateSink;
+    out.put("----------------------------------------------------------------------\n");
+    out.put("State after executing cycle: ");
+    out.putUnsigned(cycle);
+    out.newline();
+
+    // bubble stages keep their latches, so their sections are usually replayed
+    ifTrace.emit(out, state.IF, [&](TraceSink& out) {
+        traceNop(out, LABEL("IF.nop: "), state.IF.nop);
+        out.put("IF.PC: ");
+        out.putUnsigned(state.IF.PC);
+        out.newline();
+    });
+
+    idTrace.emit(out, state.ID, [&](TraceSink& out) {
+        traceNop(out, LABEL("ID.nop: "), state.ID.nop);
+        traceBits(out, LABEL("ID.Instr: "), state.ID.instr, 32);
+    });
+
+    exTrace.emit(out, state.EX, [&](TraceSink& out) {
+        traceNop(out, LABEL("EX.nop: "), state.EX.nop);
+        // EX.instr is empty until the first instruction reaches EX
+        if (state.EX.instr == 0) out.put("EX.instr: \n");
+        else traceBits(out, LABEL("EX.instr: "), state.EX.instr, 32);
+        traceBits(out, LABEL("EX.Read_data1: "), state.EX.read_data_1, 32);
+        traceBits(out, LABEL("EX.Read_data2: "), state.EX.read_data_2, 32);
         // Imm: 12 bits when EX has/had an instruction, 32 bits only for initial empty state
-        if (state.EX.instr == 0) {
-            printstate<<"EX.Imm: "<<bitset<32>(state.EX.imm)<<endl;  // 32 bits for initial empty state
-        } else {
-            printstate<<"EX.Imm: "<<bitset<12>(state.EX.imm & 0xFFF)<<endl;  // 12 bits when has instruction
-        }
-        printstate<<"EX.Rs: "<<bitset<5>(state.EX.rs)<<endl;
-        printstate<<"EX.Rt: "<<bitset<5>(state.EX.rt)<<endl;
-        printstate<<"EX.Wrt_reg_addr: "<<bitset<5>(state.EX.write_reg_addr)<<endl;
-        printstate<<"EX.is_I_type: "<<(state.EX.is_I_type ? 1 : 0)<<endl; 
-        printstate<<"EX.rd_mem: "<<(state.EX.read_mem ? 1 : 0)<<endl;
-        printstate<<"EX.wrt_mem: "<<(state.EX.write_mem ? 1 : 0)<<endl;        
-        printstate<<"EX.alu_op: "<<state.EX.alu_op<<endl;
-        printstate<<"EX.wrt_enable: "<<(state.EX.write_enable ? 1 : 0)<<endl;
-
-        printstate<<"MEM.nop: "<<(state.MEM.nop ? "True" : "False")<<endl;
-        printstate<<"MEM.ALUresult: "<<bitset<32>(state.MEM.alu_result)<<endl;
-        printstate<<"MEM.Store_data: "<<bitset<32>(state.MEM.store_data)<<endl; 
-        printstate<<"MEM.Rs: "<<bitset<5>(state.MEM.rs)<<endl;
-        printstate<<"MEM.Rt: "<<bitset<5>(state.MEM.rt)<<endl;   
+        if (state.EX.instr == 0) traceBits(out, LABEL("EX.Imm: "), state.EX.imm, 32);
+        else traceBits(out, LABEL("EX.Imm: "), state.EX.imm & 0xFFF, 12);
+        traceBits(out, LABEL("EX.Rs: "), state.EX.rs, 5);
+        traceBits(out, LABEL("EX.Rt: "), state.EX.rt, 5);
+        traceBits(out, LABEL("EX.Wrt_reg_addr: "), state.EX.write_reg_addr, 5);
+        traceFlag(out, LABEL("EX.is_I_type: "), state.EX.is_I_type);
+        traceFlag(out, LABEL("EX.rd_mem: "), state.EX.read_mem);
+        traceFlag(out, LABEL("EX.wrt_mem: "), state.EX.write_mem);
+        traceBits(out, LABEL("EX.alu_op: "), (uint32_t)state.EX.alu_op, 2);
+        traceFlag(out, LABEL("EX.wrt_enable: "), state.EX.write_enable);
+    });
+
+    memTrace.emit(out, state.MEM, [&](TraceSink& out) {
+        traceNop(out, LABEL("MEM.nop: "), state.MEM.nop);
+        traceBits(out, LABEL("MEM.ALUresult: "), state.MEM.alu_result, 32);
+        traceBits(out, LABEL("MEM.Store_data: "), state.MEM.store_data, 32);
+        traceBits(out, LABEL("MEM.Rs: "), state.MEM.rs, 5);
+        traceBits(out, LABEL("MEM.Rt: "), state.MEM.rt, 5);
         // MEM.Wrt_reg_addr: 6 bits if wrt_enable is 0, otherwise 5 bits
         if (state.MEM.write_reg_addr == 0 && !state.MEM.write_enable) {
-            printstate<<"MEM.Wrt_reg_addr: "<<bitset<6>(0)<<endl;
+            traceBits(out, LABEL("MEM.Wrt_reg_addr: "), 0, 6);
         } else {
-            printstate<<"MEM.Wrt_reg_addr: "<<bitset<5>(state.MEM.write_reg_addr)<<endl;
+            traceBits(out, LABEL("MEM.Wrt_reg_addr: "), state.MEM.write_reg_addr, 5);
         }
-        printstate<<"MEM.rd_mem: "<<(state.MEM.read_mem ? 1 : 0)<<endl;
-        printstate<<"MEM.wrt_mem: "<<(state.MEM.write_mem ? 1 : 0)<<endl; 
-        printstate<<"MEM.wrt_enable: "<<(state.MEM.write_enable ? 1 : 0)<<endl;         
-
-        printstate<<"WB.nop: "<<(state.WB.nop ? "True" : "False")<<endl;
-        printstate<<"WB.Wrt_data: "<<bitset<32>(state.WB.write_data)<<endl;
-        printstate<<"WB.Rs: "<<bitset<5>(state.WB.rs)<<endl;
-        printstate<<"WB.Rt: "<<bitset<5>(state.WB.rt)<<endl;
-        printstate<<"WB.Wrt_reg_addr: "<<bitset<5>(state.WB.write_reg_addr)<<endl;
-        printstate<<"WB.wrt_enable: "<<(state.WB.write_enable ? 1 : 0)<<endl;
-    }
-    else cout<<"Unable to open FS StateResult output file." << endl;
-    printstate.close();
+        traceFlag(out, LABEL("MEM.rd_mem: "), state.MEM.read_mem);
+        traceFlag(out, LABEL("MEM.wrt_mem: "), state.MEM.write_mem);
+        traceFlag(out, LABEL("MEM.wrt_enable: "), state.MEM.write_enable);
+    });
+
+    wbTrace.emit(out, state.WB, [&](TraceSink& out) {
+        traceNop(out, LABEL("WB.nop: "), state.WB.nop);
+        traceBits(out, LABEL("WB.Wrt_data: "), state.WB.write_data, 32);
+        traceBits(out, LABEL("WB.Rs: "), state.WB.rs, 5);
+        traceBits(out, LABEL("WB.Rt: "), state.WB.rt, 5);
+        traceBits(out, LABEL("WB.Wrt_reg_addr: "), state.WB.write_reg_addr, 5);
+        traceFlag(out, LABEL("WB.wrt_enable: "), state.WB.write_enable);
+    });
 }
 
-void FiveStageCore::setOutputDirectory(const string& outputDir) {
+#undef LABEL
+
+template <class Tracer, class Stats, class Memory, class Hazards>
+void FiveStageCoreT<Tracer, Stats, Memory, Hazards>::setOutputDirectory(const string& outputDir) {
     ioDir = outputDir;
+    std::error_code ec;
+    std::filesystem::create_directories(ioDir, ec);
     opFilePath = outputDir + "/StateResult_FS.txt";
     myRF.outputFile = outputDir + "/FS_RFResult.txt";
 }
 
-void FiveStageCore::outputPerformanceMetrics(const string& outputDir) {
+template <class Tracer, class Stats, class Memory, class Hazards>
+void FiveStageCoreT<Tracer, Stats, Memory, Hazards>::outputPerformanceMetrics(const string& outputDir) {
     string perfFile = outputDir + "/PerformanceMetrics.txt";
     ofstream perfOut(perfFile, ios::app);
     if (perfOut.is_open()) {
-        perfOut << "Performance of Five Stage:" << endl;
+        if (fastForwarded) {
+            perfOut << "Performance of Five Stage (window after " << fastForwarded
+                    << " fast-forwarded instructions):" << endl;
+        } else {
+            perfOut << "Performance of Five Stage:" << endl;
+        }
         perfOut << "#Cycles -> " << cycle << endl;
+        uint64_t num_instr = stats.instructions();
         perfOut << "#Instructions -> " << num_instr << endl;
         if (num_instr > 0) {
             double cpi = (double)cycle / num_instr;
@@ -715,4 +787,15 @@ void FiveStageCore::outputPerformanceMetrics(const string& outputDir) {
     } else {
         cout << "Unable to open performance metrics file: " << perfFile << endl;
     }
-}
\ No newline at end of file
+}
+
+// ==========================================
+// EXPLICIT INSTANTIATIONS
+// ==========================================
+
+#define INSTANTIATE_SS(T, S, M) template class SingleStageCoreT<T, S, M>;
+#define INSTANTIATE_FS(T, S, M, H) template class FiveStageCoreT<T, S, M, H>;
+SS_CORE_CONFIGS(INSTANTIATE_SS)
+FS_CORE_CONFIGS(INSTANTIATE_FS)
+#undef INSTANTIATE_SS
+#undef INSTANTIATE_FS
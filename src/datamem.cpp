@@ -1,11 +1,22 @@
 #include "../include/datamem.h"
+#include "../include/tracesink.h"
+#include <filesystem>
+#include <stdexcept>
 
-DataMem::DataMem(string name, string ioDir) : id{name}, ioDir{ioDir} {
-    DMem.resize(MemSize);
+DataMem::DataMem(string name, string ioDir, bool binaryImage) : id{name}, ioDir{ioDir} {
     opFilePath = ioDir + getFileSeparator() + name + "_DMEMResult.txt";
+    if (binaryImage) {
+        string filepath = ioDir + getFileSeparator() + "dmem.bin";
+        try {
+            DMem.attachImage(make_shared<MappedImage>(filepath));
+        } catch (const runtime_error& e) {
+            cout << e.what() << endl;
+        }
+        return;
+    }
     ifstream dmem;
     string line;
-    int i = 0;
+    uint32_t i = 0;
     
     string filepath = ioDir + getFileSeparator() + "dmem.txt";
     dmem.open(filepath);
@@ -18,7 +29,7 @@ DataMem::DataMem(string name, string ioDir) : id{name}, ioDir{ioDir} {
             }
             // Skip empty lines
             if (!line.empty()) {
-                DMem[i] = bitset<8>(line);
+                DMem.writeByte(i, (uint8_t)bitset<8>(line).to_ulong());
                 i++;
             }
         }
@@ -27,25 +38,59 @@ DataMem::DataMem(string name, string ioDir) : id{name}, ioDir{ioDir} {
         cout << "Unable to open DMEM input file: " << filepath << endl;
     }
     dmem.close();          
+    DMem.clearDirty();  // loading is not a store
 }
 
+DataMem::DataMem(const DataMem& other)
+    : id{other.id}, opFilePath{other.opFilePath}, ioDir{other.ioDir}, DMem{other.DMem},
+      dumpRanges{other.dumpRanges} {}
+
+DataMem::DataMem(string name, const DataMem& base)
+    : id{name}, opFilePath{base.ioDir + getFileSeparator() + name + "_DMEMResult.txt"}, ioDir{base.ioDir},
+      DMem{base.DMem}, dumpRanges{base.dumpRanges} {}
+
 bitset<32> DataMem::readDataMem(bitset<32> Address) {	
-    // read data memory - big endian (dmem.txt stores bytes in big-endian order)
-    bitset<32> val;
-    for (int i = 0; i < 4; i++) {
-        bitset<32> byte_val = bitset<32>(DMem[Address.to_ulong() + i].to_ulong());
-        val |= (byte_val << ((3 - i) * 8));  // Changed: 3-i for big-endian
-    }
-    return val;
+    return bitset<32>(readWord(Address.to_ulong()));
 }
 
 void DataMem::writeDataMem(bitset<32> Address, bitset<32> WriteData) {
-    // write into memory - big endian (dmem.txt stores bytes in big-endian order)
-    uint32_t addr = Address.to_ulong();
-    uint32_t data = WriteData.to_ulong();
-    
-    for (int i = 0; i < 4; i++) {
-        DMem[addr + i] = bitset<8>((data >> ((3 - i) * 8)) & 0xFF);  // Changed: 3-i for big-endian
+    writeWord(Address.to_ulong(), WriteData.to_ulong());
+}
+
+void DataMem::notifyWatches(uint32_t addr) {
+    for (size_t i = 0; i < writeWatches.size(); i++) {
+        const WriteWatch& w = writeWatches[i];
+        if (addr < w.hi && addr + 4 > w.lo) w.callback(addr);
+    }
+}
+
+int DataMem::addWriteWatch(uint32_t lo, uint32_t hi, function<void(uint32_t)> callback) {
+    writeWatches.push_back({nextWatchId, lo, hi, std::move(callback)});
+    return nextWatchId++;
+}
+
+void DataMem::removeWriteWatch(int id) {
+    for (size_t i = 0; i < writeWatches.size(); i++) {
+        if (writeWatches[i].id == id) {
+            writeWatches.erase(writeWatches.begin() + i);
+            return;
+        }
+    }
+}
+
+void DataMem::writeDump(ostream& out) const {
+    // formatted a chunk of bytes at a time
+    const size_t chunk = 1024;
+    uint8_t bytes[chunk];
+    char text[9 * chunk];
+    for (const MemRange& r : dumpRanges) {
+        for (uint64_t j = r.lo; j < r.hi;) {
+            size_t n = (size_t)min<uint64_t>(chunk, r.hi - j);
+            for (size_t i = 0; i < n; i++) bytes[i] = DMem.readByte((uint32_t)(j + i));
+            TraceSink::formatBytes(text, bytes, n);
+            out.write(text, 9 * n);
+            j += n;
+        }
     }
 }
 
@@ -53,9 +98,7 @@ void DataMem::outputDataMem() {
     ofstream dmemout;
     dmemout.open(opFilePath, std::ios_base::trunc);
     if (dmemout.is_open()) {
-        for (int j = 0; j < 1000; j++) {     
-            dmemout << DMem[j] << endl;
-        }
+        writeDump(dmemout);
     }
     else {
         cout << "Unable to open " << id << " DMEM result file." << endl;
@@ -65,8 +108,8 @@ void DataMem::outputDataMem() {
 
 void DataMem::outputDataMem(string outputDir) {
     // Create result directory if it doesn't exist
-    string createDirCommand = "mkdir -p " + outputDir;
-    system(createDirCommand.c_str());
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir, ec);
     
     // Generate output file path in the specified directory
     string outputPath = outputDir + getFileSeparator() + id + "_DMEMResult.txt";
@@ -74,9 +117,7 @@ void DataMem::outputDataMem(string outputDir) {
     ofstream dmemout;
     dmemout.open(outputPath, std::ios_base::trunc);
     if (dmemout.is_open()) {
-        for (int j = 0; j < 1000; j++) {     
-            dmemout << DMem[j] << endl;
-        }
+        writeDump(dmemout);
     }
     else {
         cout << "Unable to open " << id << " DMEM result file at: " << outputPath << endl;
@@ -84,16 +125,23 @@ void DataMem::outputDataMem(string outputDir) {
     dmemout.close();
 }
 
+void DataMem::outputDataImage(string outputDir) {
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir, ec);
+    DMem.writeImage(outputDir + getFileSeparator() + id + "_DMEMResult.bin");
+}
+
 void DataMem::debugPrintMemory(int start, int end) {
     cout << "Data Memory contents from " << start << " to " << end << ":" << endl;
-    for (int i = start; i <= end && i < MemSize; i++) {
-        cout << "DMem[" << i << "] = " << DMem[i] << " (0x" << hex << DMem[i].to_ulong() << dec << ")" << endl;
+    for (int i = start; i <= end; i++) {
+        uint8_t b = DMem.readByte(i);
+        cout << "DMem[" << i << "] = " << bitset<8>(b) << " (0x" << hex << (int)b << dec << ")" << endl;
     }
 }
 
 bitset<8> DataMem::debugGetMemoryByte(int index) {
-    if (index >= 0 && index < MemSize) {
-        return DMem[index];
+    if (index >= 0) {
+        return bitset<8>(DMem.readByte(index));
     }
     return bitset<8>(0);
 }
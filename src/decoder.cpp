@@ -0,0 +1,51 @@
+#include "../include/decoder.h"
+
+static uint32_t get_bits(uint32_t val, int high, int low) {
+    uint32_t mask = (1ULL << (high - low + 1)) - 1;
+    return (val >> low) & mask;
+}
+
+static int32_t sign_extend(uint32_t val, int bits) {
+    int32_t shift = 32 - bits;
+    return ((int32_t)val << shift) >> shift;
+}
+
+DecodedInstr decodeInstr(uint32_t instr, uint32_t pc) {
+    // one table lookup, then the row's full mask check selects it or NOP
+    const InstrSpec* spec = &isaTable[decodeTable[decodeKey(instr)]];
+    bool matches = (instr & spec->mask) == spec->match;
+    spec = &isaTable[matches ? (size_t)spec->op : nopSpec];
+
+    // immediates of every format, selected by the row's format
+    int32_t imms[] = {
+        0,                                                                   // R
+        sign_extend(get_bits(instr, 31, 20), 12),                            // I
+        sign_extend((get_bits(instr, 31, 25) << 5) | get_bits(instr, 11, 7), 12),  // S
+        sign_extend((get_bits(instr, 31, 31) << 12) | (get_bits(instr, 7, 7) << 11) |
+                    (get_bits(instr, 30, 25) << 5) | (get_bits(instr, 11, 8) << 1), 13),  // B
+        sign_extend((get_bits(instr, 31, 31) << 20) | (get_bits(instr, 19, 12) << 12) |
+                    (get_bits(instr, 20, 20) << 11) | (get_bits(instr, 30, 21) << 1), 21),  // J
+        0                                                                    // None
+    };
+
+    DecodedInstr d;
+    d.raw = instr;
+    d.op = spec->op;
+    d.rd = get_bits(instr, 11, 7);
+    d.rs1 = get_bits(instr, 19, 15);
+    d.rs2 = get_bits(instr, 24, 20);
+    d.imm = imms[(size_t)spec->format];
+    d.alu = spec->alu;
+    d.cond = spec->cond;
+    d.flags = spec->flags;
+    d.target = (spec->flags & (BRANCH | JUMP)) ? pc + d.imm : (d.op == Op::HALT ? pc : pc + 4);
+    return d;
+}
+
+void DecodedProgram::build(const vector<uint32_t>& words) {
+    instrs.clear();
+    instrs.reserve(words.size());
+    for (size_t i = 0; i < words.size(); i++) {
+        instrs.push_back(decodeInstr(words[i], (uint32_t)(i * 4)));
+    }
+}
@@ -0,0 +1,38 @@
+#include "../include/decoupled.h"
+#include <thread>
+
+DecoupledResult runDecoupled(FrontEndCore& core, size_t capacityLog2) {
+    SpscQueue<CommitRecord> queue(capacityLog2);
+    core.getStats().queue = &queue;
+
+    DecoupledResult result;
+    std::thread backEnd([&queue, &result] {
+        CommitRecord r;
+        while (queue.pop(r)) {
+            result.timing.commit(r, r.taken);
+            result.records++;
+        }
+    });
+
+    // the threaded engine leaves HALT and the drain cycle to step()
+    while (!core.halted && core.runThreaded(UINT64_MAX)) {}
+    core.runUntil(StopCondition());
+    queue.close();
+    backEnd.join();
+
+    core.getStats().queue = nullptr;
+    return result;
+}
+
+PipelineTiming runPipeline(PipelineCore& core) {
+    while (!core.halted && core.runThreaded(UINT64_MAX)) {}
+    core.runUntil(StopCondition());
+    return core.getStats().model;
+}
+
+IntervalModel runInterval(IntervalCore& core) {
+    core.runThreaded(intervalWarmup);
+    while (!core.halted) core.runJit(UINT64_MAX);
+    core.runUntil(StopCondition());
+    return core.getStats().model;
+}
@@ -0,0 +1,16 @@
+#include "../include/fastforward.h"
+
+RunResult fastForward(FastForwardCore& core, const StopCondition& to) {
+    // a marker can sit in the middle of a block, so it is matched per step
+    if (to.matchPC) return core.runUntil(StopCondition::atPC(to.pc));
+
+    uint64_t start = core.getInstructionCount();
+    uint64_t done = 0;
+    uint32_t startCycle = core.cycle;
+    while (!core.halted && done < to.maxInstructions) {
+        core.runThreaded(to.maxInstructions - done);
+        done = core.getInstructionCount() - start;
+    }
+    StopReason reason = core.halted ? StopReason::Halted : StopReason::InstructionLimit;
+    return {reason, core.cycle - startCycle, done};
+}
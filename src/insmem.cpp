@@ -1,15 +1,23 @@
 #include "../include/insmem.h"
+#include <stdexcept>
 
-InsMem::InsMem(string name, string ioDir) {       
-    id = name;
-    this->ioDir = ioDir;
-    IMem.resize(MemSize);
+InsMem::InsMem(string name, string ioDir, bool binaryImage) : id{name}, ioDir{ioDir} {
     ifstream imem;
     string line;
-    int i = 0;
     
-    string filepath = ioDir + getFileSeparator() + "imem.txt";
-    imem.open(filepath);
+    string filepath = ioDir + getFileSeparator() + (binaryImage ? "imem.bin" : "imem.txt");
+    if (binaryImage) {
+        try {
+            // the words are read from the mapping, nothing is copied
+            image = make_shared<MappedImage>(filepath);
+            byteCount = image->size();
+        } catch (const runtime_error& e) {
+            cout << e.what() << endl;
+        }
+    }
+    else {
+        imem.open(filepath);
+    }
     
     if (imem.is_open()) {
         // 4 line x 8 bits = 32 bits instruction
@@ -20,46 +28,52 @@ InsMem::InsMem(string name, string ioDir) {
             }
             // Skip empty lines
             if (!line.empty()) {
-                IMem[i] = bitset<8>(line);
-                i++;
+                IMem.push_back((uint8_t)bitset<8>(line).to_ulong());
             }
         }                    
     }
-    else {
+    else if (!binaryImage) {
         cout << "Unable to open IMEM input file: " << filepath << endl;
     }
-    imem.close();                     
+    imem.close();
+    if (!image) byteCount = IMem.size();
+    // reads as zero past the program, whole words, at least MemSize bytes
+    imageSize = max<size_t>((byteCount + 3) & ~(size_t)3, MemSize);
+
+    // predecode every aligned word once so the cores never decode per cycle
+    vector<uint32_t> words;
+    words.reserve(imageSize / 4);
+    for (size_t addr = 0; addr + 4 <= imageSize; addr += 4) {
+        words.push_back(readWord(addr));
+    }
+    program.build(words);
 }
 
-bitset<32> InsMem::readInstr(bitset<32> ReadAddress) {    
+bitset<32> InsMem::readInstr(bitset<32> ReadAddress) const {    
     // read instruction memory - big endian (imem.txt stores bytes in big-endian order)
-    bitset<32> val;
-    for (int i = 0; i < 4; i++) {
-        bitset<32> byte_val = bitset<32>(IMem[ReadAddress.to_ulong() + i].to_ulong());
-        val |= (byte_val << ((3 - i) * 8));  // Changed: 3-i for big-endian
-    }
-    return val;
+    uint32_t addr = ReadAddress.to_ulong();
+    return bitset<32>(addr + 4 <= imageSize ? readWord(addr) : 0);
 }
 
-void InsMem::debugPrintMemory(int start, int end) {
+void InsMem::debugPrintMemory(int start, int end) const {
     cout << "Memory contents from " << start << " to " << end << ":" << endl;
-    for (int i = start; i <= end && i < MemSize; i++) {
-        cout << "IMem[" << i << "] = " << IMem[i] << " (0x" << hex << IMem[i].to_ulong() << dec << ")" << endl;
+    for (int i = start; i <= end && i < (int)imageSize; i++) {
+        cout << "IMem[" << i << "] = " << bitset<8>(byteAt(i)) << " (0x" << hex << (int)byteAt(i) << dec << ")" << endl;
     }
 }
 
-size_t InsMem::debugGetMemorySize() {
-    return IMem.size();
+size_t InsMem::debugGetMemorySize() const {
+    return imageSize;
 }
 
-bitset<8> InsMem::debugGetMemoryByte(int index) {
-    if (index >= 0 && index < MemSize) {
-        return IMem[index];
+bitset<8> InsMem::debugGetMemoryByte(int index) const {
+    if (index >= 0 && index < (int)imageSize) {
+        return bitset<8>(byteAt(index));
     }
     return bitset<8>(0);
 }
 
-string InsMem::getFileSeparator() {
+string InsMem::getFileSeparator() const {
 #ifdef _WIN32
     return "\\";
 #else
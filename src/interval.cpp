@@ -0,0 +1,53 @@
+#include "../include/interval.h"
+#include <iomanip>
+
+BlockTiming BlockTiming::of(const DecodedInstr* ops, size_t n) {
+    // replay the block on a fresh model; only the first instruction's
+    // dependence on what ran before is left open
+    BlockTiming t;
+    if (n == 0) return t;
+    IntervalModel m;
+    for (size_t i = 0; i < n; i++) m.commit(ops[i], false);
+    t.count = (uint32_t)n;
+    t.innerStalls = (uint32_t)m.stalls;
+    t.lastOffset = (uint32_t)(m.nextID - 2);
+    t.exOffset = m.lastEX ? (int32_t)(m.lastEX - 1) : -1;
+    t.firstRs1 = (ops[0].flags & READS_RS1) ? ops[0].rs1 : 0;
+    t.firstRs2 = (ops[0].flags & READS_RS2) ? ops[0].rs2 : 0;
+    t.loadRd = m.loadRd;
+    // replayed with nothing in EX before the block, so a stall of the
+    // second instruction on a leading LW was always counted
+    if (n > 1 && (ops[0].flags & MEM_READ) && ops[0].rd != 0) {
+        const DecodedInstr& d = ops[1];
+        bool reads = ((d.flags & READS_RS1) && d.rs1 == ops[0].rd) || ((d.flags & READS_RS2) && d.rs2 == ops[0].rd);
+        if (reads) t.entryShadow = ops[0].rd;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!(ops[i].flags & BRANCH)) t.exCount++;
+    }
+    t.exCount = min<uint8_t>(t.exCount, 2);
+    t.exRd = m.exRd;
+    t.exRd2 = m.exRd2;
+    t.lastFlags = ops[n - 1].flags;
+    return t;
+}
+
+void IntervalModel::outputPerformanceMetrics(const string& outputDir) const {
+    string perfFile = outputDir + "/PerformanceMetrics.txt";
+    ofstream perfOut(perfFile, ios::app);
+    if (!perfOut.is_open()) {
+        cout << "Unable to open performance metrics file: " << perfFile << endl;
+        return;
+    }
+    uint64_t num_cycles = cycles();
+    perfOut << "Performance of Five Stage (interval model):" << endl;
+    perfOut << "#Cycles -> " << num_cycles << endl;
+    perfOut << "#Instructions -> " << instrs << endl;
+    if (instrs > 0) {
+        perfOut << "CPI -> " << fixed << setprecision(16) << (double)num_cycles / instrs << endl;
+        perfOut << "IPC -> " << fixed << setprecision(16) << (double)instrs / num_cycles << endl;
+    }
+    perfOut << "#Load-use stalls -> " << stalls << endl;
+    perfOut << "#Redirect bubbles -> " << redirects << endl;
+    perfOut << endl;
+}
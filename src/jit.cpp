@@ -0,0 +1,433 @@
+#include "../include/jit.h"
+#include "../include/core.h"
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+// ==========================================
+// X86-64 EMITTER
+// ==========================================
+
+namespace {
+
+// Register numbers as used in ModRM
+enum X86Reg : uint8_t { EAX = 0, ECX = 1, EDX = 2, EBX = 3, ESI = 6, EDI = 7 };
+
+class X86Emitter {
+public:
+    vector<uint8_t> buf;
+    uintptr_t origin;  // address buf[0] is copied to
+
+    explicit X86Emitter(uintptr_t origin) : origin(origin) {}
+
+    void byte(uint8_t b) { buf.push_back(b); }
+    void imm32(uint32_t v) {
+        for (int i = 0; i < 4; i++) byte((v >> (i * 8)) & 0xFF);
+    }
+    void imm64(uint64_t v) {
+        for (int i = 0; i < 8; i++) byte((v >> (i * 8)) & 0xFF);
+    }
+
+    // <op> reg, [rbx + 4 * guest]   (also mov [rbx + 4 * guest], reg with 0x89)
+    void guestOp(uint8_t opcode, X86Reg reg, uint32_t guest) {
+        byte(opcode);
+        byte(0x80 | (reg << 3) | EBX);  // mod=10 (disp32), rm=rbx
+        imm32(guest * 4);
+    }
+    void loadGuest(X86Reg reg, uint32_t guest)  { guestOp(0x8B, reg, guest); }
+    void storeGuest(X86Reg reg, uint32_t guest) { guestOp(0x89, reg, guest); }
+
+    void prologue() {
+        byte(0x53);                          // push rbx
+        byte(0x55);                          // push rbp (keeps rsp 16-byte aligned)
+        byte(0x41); byte(0x54);              // push r12
+        byte(0x48); byte(0x89); byte(0xFB);  // mov rbx, rdi   (guest regs)
+        byte(0x49); byte(0x89); byte(0xF4);  // mov r12, rsi   (JitContext*)
+    }
+    // returns the next guest PC held in eax
+    void epilogue() {
+        byte(0x41); byte(0x5C);              // pop r12
+        byte(0x5D);                          // pop rbp
+        byte(0x5B);                          // pop rbx
+        byte(0xC3);                          // ret
+    }
+    void movImm(X86Reg reg, uint32_t v) { byte(0xB8 + reg); imm32(v); }
+    void movImm64(X86Reg reg, const void* p) {
+        byte(0x48); byte(0xB8 + reg);        // mov r64, imm64
+        imm64((uint64_t)(uintptr_t)p);
+    }
+    // Short forward jump to be pointed at a later position with bind()
+    size_t jump(uint8_t opcode) {
+        byte(opcode);
+        byte(0);
+        return buf.size() - 1;
+    }
+    void bind(size_t at) { buf[at] = (uint8_t)(buf.size() - at - 1); }
+    // eax = the word at esi when it hits the read side of the PagedMemory
+    // TLB (PagedMemory::readWord's fast path); jumps past it otherwise and
+    // returns that jump
+    size_t probeTlb(const PagedMemory::TlbProbe& tlb) {
+        byte(0x89); byte(0xF0);                          // mov eax, esi
+        byte(0xC1); byte(0xE8); byte(PagedMemory::PageBits);  // shr eax, PageBits
+        movImm64(ECX, tlb.readPage);
+        byte(0x3B); byte(0x01);                          // cmp eax, [rcx]
+        size_t otherPage = jump(0x75);                   // jne
+        byte(0x89); byte(0xF1);                          // mov ecx, esi
+        byte(0x81); byte(0xE1); imm32(PagedMemory::PageMask);     // and ecx, PageMask
+        byte(0x81); byte(0xF9); imm32(PagedMemory::PageSize - 4);  // cmp ecx, PageSize - 4
+        size_t crossing = jump(0x77);                    // ja
+        movImm64(EDX, tlb.data);
+        byte(0x48); byte(0x8B); byte(0x12);              // mov rdx, [rdx]
+        byte(0x8B); byte(0x04); byte(0x0A);              // mov eax, [rdx + rcx]
+        byte(0x0F); byte(0xC8);                          // bswap eax
+        size_t hit = jump(0xEB);                         // jmp
+        bind(otherPage);
+        bind(crossing);
+        return hit;
+    }
+    // fn(DataMem&, esi, edx) of the memory model
+    void callMemory(const void* fn) {
+        byte(0x49); byte(0x8B); byte(0x3C); byte(0x24);  // mov rdi, [r12]   (ctx->dmem)
+        int64_t rel = (int64_t)(uintptr_t)fn - (int64_t)(origin + buf.size() + 5);
+        if (rel == (int32_t)rel) {
+            byte(0xE8);                      // call rel32
+            imm32((uint32_t)rel);
+        } else {
+            byte(0x48); byte(0xB8);          // mov rax, imm64
+            imm64((uint64_t)(uintptr_t)fn);
+            byte(0xFF); byte(0xD0);          // call rax
+        }
+    }
+};
+
+// Register-register ALU opcode (op r32, r/m32) for R-type ops, eax-immediate
+// opcode for I-type ops
+uint8_t aluRegOpcode(Op op) {
+    switch (op) {
+        case Op::ADD: return 0x03;
+        case Op::SUB: return 0x2B;
+        case Op::XOR: return 0x33;
+        case Op::OR:  return 0x0B;
+        default:      return 0x23;  // AND
+    }
+}
+
+uint8_t aluImmOpcode(Op op) {
+    switch (op) {
+        case Op::ADDI: return 0x05;
+        case Op::XORI: return 0x35;
+        case Op::ORI:  return 0x0D;
+        default:       return 0x25;  // ANDI
+    }
+}
+
+} // namespace
+
+// ==========================================
+// JIT ENGINE
+// ==========================================
+
+JitEngine::JitEngine(DataMem& dmem, JitLoadFn load, JitStoreFn store, bool inlineLoads)
+    : load(load), store(store), inlineLoads(inlineLoads) {
+    ctx.dmem = &dmem;
+#ifdef JIT_X86_64
+    // ask for the buffer 256 MiB from the simulator's code, so that calls
+    // into the memory model fit in a rel32; anywhere else works too
+    uintptr_t text = (uintptr_t)(void*)load & ~(uintptr_t)0xFFFFF;
+    uintptr_t hint = text > ((uintptr_t)1 << 29) ? text - ((uintptr_t)1 << 28) : text + ((uintptr_t)1 << 28);
+    void* p = mmap((void*)hint, codeBufferSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p != MAP_FAILED) code = (uint8_t*)p;
+#endif
+}
+
+JitEngine::~JitEngine() {
+#ifdef JIT_X86_64
+    if (code) munmap(code, codeBufferSize);
+#endif
+}
+
+bool JitEngine::available() {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool JitEngine::nearCalls() const {
+    // from every call site in the buffer
+    auto near = [this](const void* fn) {
+        int64_t d = (int64_t)(uintptr_t)fn - (int64_t)(uintptr_t)code;
+        return d > INT32_MIN + (int64_t)codeBufferSize && d < INT32_MAX - (int64_t)codeBufferSize;
+    };
+    return code && near((const void*)load) && near((const void*)store);
+}
+
+// The buffer is never writable and executable at the same time
+bool JitEngine::setWritable(bool writable) {
+#ifdef JIT_X86_64
+    int prot = writable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC);
+    return mprotect(code, codeBufferSize, prot) == 0;
+#else
+    (void)writable;
+    return false;
+#endif
+}
+
+JitBlockFn JitEngine::compile(const TranslatedBlock& block, size_t n) {
+    if (!code || n == 0) return nullptr;
+
+    X86Emitter e((uintptr_t)(code + used));
+    e.prologue();
+    uint32_t pc = block.startPC;
+    bool exited = false;
+    for (size_t i = 0; i < n; i++, pc += 4) {
+        const DecodedInstr& d = block.ops[i];
+        switch (d.op) {
+            case Op::ADD: case Op::SUB: case Op::XOR: case Op::OR: case Op::AND:
+                if (d.rd == 0) break;
+                e.loadGuest(EAX, d.rs1);
+                e.guestOp(aluRegOpcode(d.op), EAX, d.rs2);
+                e.storeGuest(EAX, d.rd);
+                break;
+            case Op::ADDI: case Op::XORI: case Op::ORI: case Op::ANDI:
+                if (d.rd == 0) break;
+                e.loadGuest(EAX, d.rs1);
+                e.byte(aluImmOpcode(d.op));
+                e.imm32((uint32_t)d.imm);
+                e.storeGuest(EAX, d.rd);
+                break;
+            case Op::LW:
+                e.loadGuest(ESI, d.rs1);
+                e.byte(0x81); e.byte(0xC6); e.imm32((uint32_t)d.imm);  // add esi, imm32
+                if (inlineLoads) {
+                    size_t hit = e.probeTlb(ctx.dmem->contents().tlbProbe());
+                    e.callMemory((const void*)load);
+                    e.bind(hit);
+                } else {
+                    e.callMemory((const void*)load);
+                }
+                if (d.rd != 0) e.storeGuest(EAX, d.rd);
+                break;
+            case Op::SW:
+                e.loadGuest(ESI, d.rs1);
+                e.byte(0x81); e.byte(0xC6); e.imm32((uint32_t)d.imm);  // add esi, imm32
+                e.loadGuest(EDX, d.rs2);
+                e.callMemory((const void*)store);
+                break;
+            case Op::BEQ: case Op::BNE:
+                e.loadGuest(EAX, d.rs1);
+                e.guestOp(0x3B, EAX, d.rs2);                            // cmp eax, rs2
+                e.movImm(EAX, pc + 4);
+                e.movImm(ECX, d.target);
+                e.byte(0x0F); e.byte(d.op == Op::BEQ ? 0x44 : 0x45);   // cmove/cmovne
+                e.byte(0xC1);                                           // eax, ecx
+                exited = true;
+                break;
+            case Op::JAL:
+                if (d.rd != 0) {
+                    e.byte(0xC7); e.byte(0x83); e.imm32(d.rd * 4);      // mov [rbx+4*rd], imm32
+                    e.imm32(pc + 4);
+                }
+                e.movImm(EAX, d.target);
+                exited = true;
+                break;
+            case Op::NOP:
+                break;
+            default:
+                return nullptr;  // HALT is never part of the compiled range
+        }
+    }
+    if (!exited) e.movImm(EAX, pc);
+    e.epilogue();
+
+    if (used + e.buf.size() > codeBufferSize || !setWritable(true)) return nullptr;
+    uint8_t* entry = code + used;
+    memcpy(entry, e.buf.data(), e.buf.size());
+    used += e.buf.size();
+    if (!setWritable(false)) return nullptr;
+    numCompiled++;
+    return (JitBlockFn)(void*)entry;
+}
+
+// ==========================================
+// JIT DISPATCH FOR SingleStageCore
+// ==========================================
+
+// Reference semantics for blocks that are not compiled (and for the
+// differential check); returns the next PC
+template <class Memory>
+static uint32_t interpretOps(const DecodedInstr* ops, size_t n, uint32_t* regs,
+                             uint32_t pc, DataMem& dmem) {
+    for (size_t i = 0; i < n; i++) {
+        const DecodedInstr& d = ops[i];
+        uint32_t next_pc = pc + 4;
+        switch (d.op) {
+            case Op::ADD:  regs[d.rd] = regs[d.rs1] + regs[d.rs2]; break;
+            case Op::SUB:  regs[d.rd] = regs[d.rs1] - regs[d.rs2]; break;
+            case Op::XOR:  regs[d.rd] = regs[d.rs1] ^ regs[d.rs2]; break;
+            case Op::OR:   regs[d.rd] = regs[d.rs1] | regs[d.rs2]; break;
+            case Op::AND:  regs[d.rd] = regs[d.rs1] & regs[d.rs2]; break;
+            case Op::ADDI: regs[d.rd] = regs[d.rs1] + (uint32_t)d.imm; break;
+            case Op::XORI: regs[d.rd] = regs[d.rs1] ^ (uint32_t)d.imm; break;
+            case Op::ORI:  regs[d.rd] = regs[d.rs1] | (uint32_t)d.imm; break;
+            case Op::ANDI: regs[d.rd] = regs[d.rs1] & (uint32_t)d.imm; break;
+            case Op::LW:
+                regs[d.rd] = Memory::load(dmem, regs[d.rs1] + d.imm);
+                break;
+            case Op::SW:
+                Memory::store(dmem, regs[d.rs1] + d.imm, regs[d.rs2]);
+                break;
+            case Op::BEQ:
+                if (regs[d.rs1] == regs[d.rs2]) next_pc = d.target;
+                break;
+            case Op::BNE:
+                if (regs[d.rs1] != regs[d.rs2]) next_pc = d.target;
+                break;
+            case Op::JAL:
+                regs[d.rd] = pc + 4;
+                next_pc = d.target;
+                break;
+            default:
+                break;
+        }
+        regs[0] = 0;
+        pc = next_pc;
+    }
+    return pc;
+}
+
+template <class Tracer, class Stats, class Memory>
+void SingleStageCoreT<Tracer, Stats, Memory>::setJitDiff(bool enable) {
+    jitDiff = enable;
+}
+
+template <class Tracer, class Stats, class Memory>
+uint64_t SingleStageCoreT<Tracer, Stats, Memory>::runJit(uint64_t maxInstrs) {
+    if (halted || maxInstrs == 0) return 0;
+    if (state.IF.nop) {  // HALT already executed, only the drain cycle is left
+        step();
+        return 0;
+    }
+    // per-cycle traces need the interpreter, and so do memory policies that
+    // throw: an exception cannot unwind through compiled code
+    if constexpr (Tracer::everyCycle || (Stats::commits && !Stats::commitsBlocks) ||
+                  !std::is_same<Memory, DirectMemory>::value)
+        return runBlocks(maxInstrs);
+    if (!blocks) blocks.reset(new BlockCache(program));
+
+    uint32_t regs[32];
+    for (int i = 0; i < 32; i++) {
+        regs[i] = myRF.readReg(i);
+    }
+    uint32_t pc = state.IF.PC;
+    uint64_t executed = 0;
+
+    // differential mode: an interpreted shadow copy checks every block
+    if (jitDiff && !jitShadowMem) {
+        jitShadowMem.reset(new DataMem(ext_dmem));
+        memcpy(jitShadowRegs, regs, sizeof(regs));
+    }
+
+    TranslatedBlock* b = blocks->lookup(pc);
+    while (true) {
+        size_t n = b->ops.size();
+        if (b->ops[n - 1].op == Op::HALT) n--;
+        if (n == 0 || executed + n > maxInstrs) break;
+
+        if (!b->native && ++b->execCount == JitEngine::hotThreshold && JitEngine::available()) {
+            // the code buffer is mapped for the first hot block, so short
+            // runs never pay for it
+            if (!jit) {
+                jit.reset(new JitEngine(ext_dmem, &Memory::load, &Memory::store,
+                                        std::is_same<Memory, DirectMemory>::value));
+            }
+            b->native = (void*)jit->compile(*b, n);
+        }
+
+        uint32_t next_pc;
+        if (b->native) {
+            next_pc = ((JitBlockFn)b->native)(regs, jit->context());
+        } else {
+            next_pc = interpretOps<Memory>(b->ops.data(), n, regs, pc, ext_dmem);
+        }
+
+        if (jitDiff) {
+            uint32_t ref_pc = interpretOps<Memory>(b->ops.data(), n, jitShadowRegs, pc, *jitShadowMem);
+            if (ref_pc != next_pc || memcmp(regs, jitShadowRegs, sizeof(regs)) != 0) {
+                cout << "JIT mismatch in block at PC " << b->startPC << ": next PC "
+                     << next_pc << " vs " << ref_pc << endl;
+                for (int i = 0; i < 32; i++) {
+                    if (regs[i] != jitShadowRegs[i]) {
+                        cout << "  x" << i << ": jit " << regs[i] << " interp " << jitShadowRegs[i] << endl;
+                    }
+                }
+                jitMismatches++;
+                memcpy(jitShadowRegs, regs, sizeof(regs));
+            }
+        }
+
+        stats.retire(b->ops.data(), n);
+        if constexpr (Stats::commitsBlocks) {
+            // a branch leaves its operands alone, so its outcome can be
+            // recomputed from the registers after the block
+            const DecodedInstr& last = b->ops[n - 1];
+            bool taken = (last.flags & JUMP) ||
+                         ((last.flags & BRANCH) && branchTaken(last.cond, regs[last.rs1], regs[last.rs2]));
+            stats.commit(b->timing, taken);
+        }
+        cycle += n;
+        executed += n;
+        pc = next_pc;
+        if (n < b->ops.size()) break;  // stopped in front of HALT
+
+        TranslatedBlock* next;
+        if (b->valid) {
+            TranslatedBlock*& link = (pc != b->endPC) ? b->taken : b->fallthrough;
+            if (!link) link = blocks->lookup(pc);
+            next = link;
+        } else {
+            next = blocks->lookup(pc);
+        }
+        blocks->collect();
+        b = next;
+    }
+
+    for (int i = 1; i < 32; i++) {
+        myRF.writeReg(i, regs[i]);
+    }
+    state.IF.PC = pc;
+    nextState = state;
+
+    // HALT, the drain cycle and any remaining budget go through step()
+    while (!halted && executed < maxInstrs) {
+        if (!state.IF.nop) {
+            executed++;
+            if (jitDiff) {
+                uint32_t cur = state.IF.PC;
+                interpretOps<Memory>(&program.at(cur), 1, jitShadowRegs, cur, *jitShadowMem);
+            }
+        }
+        step();
+    }
+
+    if (jitDiff && halted) {
+        // the shadow started as a copy, so only lines either one stored to can differ
+        int64_t at = ext_dmem.contents().firstDirtyDifference(jitShadowMem->contents());
+        if (at >= 0) {
+            cout << "JIT mismatch in data memory at " << at << endl;
+            jitMismatches++;
+        }
+    }
+    return executed;
+}
+
+#define INSTANTIATE_SS(T, S, M) \
+    template void SingleStageCoreT<T, S, M>::setJitDiff(bool); \
+    template uint64_t SingleStageCoreT<T, S, M>::runJit(uint64_t);
+SS_CORE_CONFIGS(INSTANTIATE_SS)
+#undef INSTANTIATE_SS
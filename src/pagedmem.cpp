@@ -0,0 +1,360 @@
+#include "../include/pagedmem.h"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ==========================================
+// BINARY MEMORY IMAGES
+// ==========================================
+
+MappedImage::MappedImage(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("Unable to open memory image: " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size > ((uint64_t)1 << 32)) {
+        close(fd);
+        throw runtime_error("Not a memory image of at most 4 GiB: " + path);
+    }
+    length = (size_t)st.st_size;
+    mapped = (length + PagedMemory::PageMask) & ~(size_t)PagedMemory::PageMask;
+    if (length > 0) {
+        void* p = mmap(nullptr, mapped, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Unable to map memory image: " + path);
+        }
+        base = (uint8_t*)p;
+    }
+    close(fd);
+}
+
+MappedImage::~MappedImage() {
+    if (base) munmap(base, mapped);
+}
+
+bool convertTextImage(const string& textPath, const string& binaryPath) {
+    ifstream in(textPath);
+    if (!in.is_open()) {
+        cout << "Unable to open text image: " << textPath << endl;
+        return false;
+    }
+    vector<uint8_t> bytes;
+    string line;
+    while (getline(in, line)) {
+        // Remove carriage return if present (for Windows line endings)
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) bytes.push_back((uint8_t)bitset<8>(line).to_ulong());
+    }
+    ofstream out(binaryPath, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        cout << "Unable to open binary image: " << binaryPath << endl;
+        return false;
+    }
+    out.write((const char*)bytes.data(), bytes.size());
+    return (bool)out;
+}
+
+// ==========================================
+// PAGE TABLE
+// ==========================================
+
+// What unmapped pages read as; the TLB never writes through it
+static uint8_t zeroPage[PagedMemory::PageSize];
+
+PagedMemory::PagedMemory(const PagedMemory& other) {
+    *this = other;
+}
+
+PagedMemory::~PagedMemory() {
+    clear();
+}
+
+bool PagedMemory::isPrivate(const Page* owner) {
+    return owner && owner->refs.load(memory_order_acquire) == 1;
+}
+
+void PagedMemory::release(Page* owner) {
+    if (owner && owner->refs.fetch_sub(1, memory_order_acq_rel) == 1) delete owner;
+}
+
+void PagedMemory::clear() {
+    for (unique_ptr<Table>& table : directory) {
+        if (!table) continue;
+        for (Page* owner : table->owners) release(owner);
+        table.reset();
+    }
+    image.reset();
+    pages = 0;
+    dirtyList.clear();
+    tlbRead = tlbWrite = NoPage;
+    tlbData = nullptr;
+    tlbDirty = nullptr;
+}
+
+PagedMemory& PagedMemory::operator=(const PagedMemory& other) {
+    if (this == &other) return *this;
+    clear();
+    for (size_t t = 0; t < directory.size(); t++) {
+        if (!other.directory[t]) continue;
+        directory[t].reset(new Table(*other.directory[t]));
+        for (Page* owner : directory[t]->owners) {
+            if (owner) owner->refs.fetch_add(1, memory_order_relaxed);
+        }
+    }
+    image = other.image;
+    pages = other.pages;
+    dirtyList = other.dirtyList;
+    // other's pages are shared now, its next store must copy
+    other.tlbWrite = NoPage;
+    return *this;
+}
+
+size_t PagedMemory::privatePages() const {
+    size_t n = 0;
+    for (const unique_ptr<Table>& table : directory) {
+        if (!table) continue;
+        for (const Page* owner : table->owners) n += isPrivate(owner);
+    }
+    return n;
+}
+
+void PagedMemory::attachImage(shared_ptr<MappedImage> newImage) {
+    clear();
+    image = move(newImage);
+    for (size_t offset = 0; offset < image->mappedSize(); offset += PageSize) {
+        uint32_t page = (uint32_t)(offset >> PageBits);
+        unique_ptr<Table>& table = directory[page >> TableBits];
+        if (!table) table.reset(new Table());
+        table->pages[page & TableMask] = image->data() + offset;
+        pages++;
+    }
+}
+
+const uint8_t* PagedMemory::findPage(uint32_t page) const {
+    const unique_ptr<Table>& table = directory[page >> TableBits];
+    if (!table) return nullptr;
+    return table->pages[page & TableMask];
+}
+
+uint64_t PagedMemory::dirtyMask(uint32_t page) const {
+    const unique_ptr<Table>& table = directory[page >> TableBits];
+    return table ? table->dirty[page & TableMask] : 0;
+}
+
+// Makes the page private (mapping or copying it), puts it on the dirty list
+// and into the TLB for writes; the caller marks the lines it stores to
+void PagedMemory::fillWriteTlb(uint32_t page) {
+    unique_ptr<Table>& table = directory[page >> TableBits];
+    if (!table) table.reset(new Table());
+    uint8_t*& data = table->pages[page & TableMask];
+    Page*& owner = table->owners[page & TableMask];
+    if (!data) {
+        owner = new Page();
+        data = owner->bytes;
+        pages++;
+    } else if (!isPrivate(owner)) {
+        Page* copy = new Page;
+        memcpy(copy->bytes, data, PageSize);
+        release(owner);
+        owner = copy;
+        data = copy->bytes;
+    }
+    uint64_t& mask = table->dirty[page & TableMask];
+    if (!mask) dirtyList.push_back(page);
+    tlbData = data;
+    tlbRead = tlbWrite = page;
+    tlbDirty = &mask;
+}
+
+uint8_t PagedMemory::readByte(uint32_t addr) const {
+    uint32_t page = addr >> PageBits;
+    if (page != tlbRead) {
+        const uint8_t* data = findPage(page);
+        tlbRead = page;
+        tlbData = data ? const_cast<uint8_t*>(data) : zeroPage;
+        // clean and shared pages take their first store on the slow path
+        tlbWrite = NoPage;
+        if (data && dirtyMask(page)) {
+            Table& table = *directory[page >> TableBits];
+            if (isPrivate(table.owners[page & TableMask])) {
+                tlbWrite = page;
+                tlbDirty = &table.dirty[page & TableMask];
+            }
+        }
+    }
+    return tlbData[addr & PageMask];
+}
+
+void PagedMemory::writeByte(uint32_t addr, uint8_t value) {
+    uint32_t page = addr >> PageBits;
+    if (page != tlbWrite) fillWriteTlb(page);
+    tlbData[addr & PageMask] = value;
+    *tlbDirty |= 1ull << ((addr & PageMask) >> LineBits);
+}
+
+uint32_t PagedMemory::readWordSlow(uint32_t addr) const {
+    if ((addr & PageMask) <= PageSize - 4) {
+        readByte(addr);  // refills the TLB
+        return loadBigEndian32(tlbData + (addr & PageMask));
+    }
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 4; i++) value = value << 8 | readByte(addr + i);
+    return value;
+}
+
+void PagedMemory::writeWordSlow(uint32_t addr, uint32_t value) {
+    for (uint32_t i = 0; i < 4; i++) writeByte(addr + i, (uint8_t)(value >> (24 - 8 * i)));
+}
+
+// ==========================================
+// DIRTY TRACKING
+// ==========================================
+
+void PagedMemory::clearDirty() {
+    for (uint32_t page : dirtyList) directory[page >> TableBits]->dirty[page & TableMask] = 0;
+    dirtyList.clear();
+    tlbWrite = NoPage;
+}
+
+vector<MemRange> PagedMemory::dirtyRanges(bool lines) const {
+    vector<uint32_t> sorted = dirtyList;
+    sort(sorted.begin(), sorted.end());
+    vector<MemRange> ranges;
+    auto add = [&](uint64_t lo, uint64_t hi) {
+        if (!ranges.empty() && ranges.back().hi == lo) ranges.back().hi = hi;
+        else ranges.push_back({(uint32_t)lo, hi});
+    };
+    for (uint32_t page : sorted) {
+        uint64_t base = (uint64_t)page << PageBits;
+        if (!lines) {
+            add(base, base + PageSize);
+            continue;
+        }
+        for (uint64_t mask = dirtyMask(page); mask; mask &= mask - 1) {
+            uint64_t lo = base + ((uint64_t)__builtin_ctzll(mask) << LineBits);
+            add(lo, lo + LineSize);
+        }
+    }
+    return ranges;
+}
+
+int64_t PagedMemory::firstDirtyDifference(const PagedMemory& other) const {
+    vector<uint32_t> candidates = dirtyList;
+    candidates.insert(candidates.end(), other.dirtyList.begin(), other.dirtyList.end());
+    sort(candidates.begin(), candidates.end());
+    candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+    for (uint32_t page : candidates) {
+        const uint8_t* a = findPage(page);
+        const uint8_t* b = other.findPage(page);
+        for (uint64_t mask = dirtyMask(page) | other.dirtyMask(page); mask; mask &= mask - 1) {
+            uint32_t lo = (uint32_t)__builtin_ctzll(mask) << LineBits;
+            for (uint32_t i = lo; i < lo + LineSize; i++) {
+                uint8_t x = a ? a[i] : 0;
+                uint8_t y = b ? b[i] : 0;
+                if (x != y) return (int64_t)((uint64_t)page << PageBits | i);
+            }
+        }
+    }
+    return -1;
+}
+
+// ==========================================
+// IMAGE DUMPS AND COMPARISON
+// ==========================================
+
+bool PagedMemory::writeImage(const string& path, bool dirtyOnly) const {
+    int fd = open(path.c_str(), dirtyOnly ? O_WRONLY | O_CREAT : O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        cout << "Unable to open memory image for writing: " << path << endl;
+        return false;
+    }
+    bool ok = true;
+    auto writeRun = [&](const uint8_t* data, uint64_t addr, uint64_t size) {
+        for (uint64_t done = 0; ok && done < size;) {
+            ssize_t n = pwrite(fd, data + done, size - done, (off_t)(addr + done));
+            if (n < 0 && errno == EINTR) continue;
+            ok = n > 0;
+            if (ok) done += n;
+        }
+    };
+    if (dirtyOnly) {
+        for (const MemRange& r : dirtyRanges()) {
+            for (uint64_t addr = r.lo; ok && addr < r.hi; addr += PageSize) {
+                writeRun(findPage((uint32_t)(addr >> PageBits)), addr, PageSize);
+            }
+        }
+        ok = close(fd) == 0 && ok;
+        if (!ok) cout << "Unable to write memory image: " << path << endl;
+        return ok;
+    }
+
+    uint64_t imageSize = image ? image->size() : 0;
+    uint64_t imageEnd = image ? image->mappedSize() : 0;
+    uint64_t extent = imageSize;
+    // one write per run of consecutive mapped pages
+    uint64_t runStart = 0, runEnd = 0;
+    auto flush = [&]() {
+        for (uint64_t addr = runStart; ok && addr < runEnd;) {
+            // pages of a run are contiguous only inside one allocation, so
+            // the run is written page by page unless it lies in the image
+            const uint8_t* data = findPage((uint32_t)(addr >> PageBits));
+            uint64_t end = addr + PageSize;
+            while (end < runEnd && findPage((uint32_t)(end >> PageBits)) == data + (end - addr)) end += PageSize;
+            writeRun(data, addr, end - addr);
+            addr = end;
+        }
+        extent = max(extent, runEnd <= imageEnd ? imageSize : runEnd);
+    };
+    for (uint64_t page = 0; ok && page < ((uint64_t)1 << (32 - PageBits)); page++) {
+        if ((page & TableMask) == 0 && !directory[page >> TableBits]) {
+            page += TableMask;  // no table, no pages
+            continue;
+        }
+        if (!findPage((uint32_t)page)) continue;
+        uint64_t addr = page << PageBits;
+        if (addr != runEnd) {
+            flush();
+            runStart = addr;
+        }
+        runEnd = addr + PageSize;
+    }
+    if (ok) flush();
+    // the image's last page ends with the image, unless stores went past it
+    if (imageSize > 0 && extent == imageSize) {
+        uint64_t lastPage = imageEnd - PageSize;
+        const uint8_t* last = findPage((uint32_t)(lastPage >> PageBits));
+        for (uint64_t a = imageEnd; a > imageSize; a--) {
+            if (last[a - 1 - lastPage]) {
+                extent = a;
+                break;
+            }
+        }
+    }
+    ok = ok && ftruncate(fd, (off_t)extent) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok) cout << "Unable to write memory image: " << path << endl;
+    return ok;
+}
+
+int64_t PagedMemory::firstDifference(const PagedMemory& other) const {
+    for (uint64_t page = 0; page < ((uint64_t)1 << (32 - PageBits)); page++) {
+        // skip whole tables that neither side maps
+        if ((page & TableMask) == 0 && !directory[page >> TableBits] && !other.directory[page >> TableBits]) {
+            page += TableMask;
+            continue;
+        }
+        const uint8_t* a = findPage((uint32_t)page);
+        const uint8_t* b = other.findPage((uint32_t)page);
+        if (a == b) continue;  // both unmapped
+        for (uint32_t i = 0; i < PageSize; i++) {
+            uint8_t x = a ? a[i] : 0;
+            uint8_t y = b ? b[i] : 0;
+            if (x != y) return (int64_t)(page << PageBits | i);
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,21 @@
+#include "../include/pipetiming.h"
+#include <iomanip>
+
+void PipelineTiming::outputPerformanceMetrics(const string& outputDir) const {
+    string perfFile = outputDir + "/PerformanceMetrics.txt";
+    ofstream perfOut(perfFile, ios::app);
+    if (!perfOut.is_open()) {
+        cout << "Unable to open performance metrics file: " << perfFile << endl;
+        return;
+    }
+    perfOut << "Performance of Five Stage (pipeline timing model):" << endl;
+    perfOut << "#Cycles -> " << cycleCount << endl;
+    perfOut << "#Instructions -> " << fetched << endl;
+    if (fetched > 0) {
+        perfOut << "CPI -> " << fixed << setprecision(16) << (double)cycleCount / fetched << endl;
+        perfOut << "IPC -> " << fixed << setprecision(16) << (double)fetched / cycleCount << endl;
+    }
+    perfOut << "#Load-use stalls -> " << stallCount << endl;
+    perfOut << "#Redirect bubbles -> " << flushCount << endl;
+    perfOut << endl;
+}
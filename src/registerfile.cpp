@@ -1,23 +1,14 @@
 #include "../include/registerfile.h"
+#include <filesystem>
 
-RegisterFile::RegisterFile(string ioDir): outputFile {ioDir + "RFResult.txt"}, filePrefix("SS") {
-    Registers.resize(32);  
-    Registers[0] = bitset<32>(0);  
-}
+RegisterFile::RegisterFile(string ioDir): outputFile {ioDir + "RFResult.txt"}, filePrefix("SS") {}
 
 bitset<32> RegisterFile::readRF(bitset<5> Reg_addr) {   
-    uint32_t addr = Reg_addr.to_ulong();
-    if (addr < 32) {
-        return Registers[addr];
-    }
-    return bitset<32>(0);
+    return bitset<32>(readReg(Reg_addr.to_ulong()));
 }
 
 void RegisterFile::writeRF(bitset<5> Reg_addr, bitset<32> Wrt_reg_data) {
-    uint32_t addr = Reg_addr.to_ulong();
-    if (addr < 32 && addr != 0) {  // Register 0 is always 0
-        Registers[addr] = Wrt_reg_data;
-    }
+    writeReg(Reg_addr.to_ulong(), Wrt_reg_data.to_ulong());  // Register 0 is always 0
 }
 
 void RegisterFile::setFilePrefix(string prefix) {
@@ -32,9 +23,12 @@ void RegisterFile::outputRF(int cycle) {
         rfout.open(outputFile, std::ios_base::app);
         
     if (rfout.is_open()) {
-        rfout << "State of RF after executing cycle:  " << cycle << endl;
+        rfout << "State of RF after executing cycle:  " << cycle << '\n';
         for (int j = 0; j < 32; j++) {
-            rfout << Registers[j] << endl;
+            char line[33];
+            TraceSink::formatBits(line, Registers[j], 32);
+            line[32] = '\n';
+            rfout.write(line, 33);
         }
     }
     else {
@@ -45,8 +39,8 @@ void RegisterFile::outputRF(int cycle) {
 
 void RegisterFile::outputRF(int cycle, string outputDir) {
     // Create directory if it doesn't exist
-    string createDirCommand = "mkdir -p " + outputDir;
-    system(createDirCommand.c_str());
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir, ec);
     
     // Always use the correct filename with prefix
     string filename = filePrefix + "_RFResult.txt";
@@ -61,9 +55,12 @@ void RegisterFile::outputRF(int cycle, string outputDir) {
         rfout.open(outputPath, std::ios_base::app);
         
     if (rfout.is_open()) {
-        rfout << "State of RF after executing cycle:  " << cycle << endl;
+        rfout << "State of RF after executing cycle:  " << cycle << '\n';
         for (int j = 0; j < 32; j++) {
-            rfout << Registers[j] << endl;
+            char line[33];
+            TraceSink::formatBits(line, Registers[j], 32);
+            line[32] = '\n';
+            rfout.write(line, 33);
         }
     }
     else {
@@ -72,22 +69,38 @@ void RegisterFile::outputRF(int cycle, string outputDir) {
     rfout.close();               
 }
 
+void RegisterFile::traceRF(TraceSink& sink, int cycle, const uint32_t* values) {
+    sink.put("State of RF after executing cycle:  ");
+    sink.putUnsigned(cycle);
+    sink.newline();
+    // at most one register changes per cycle, the rest is replayed
+    for (int j = 0; j < 32; j++) {
+        if (tracedValid && tracedValues[j] == values[j]) continue;
+        char* line = &tracedLines[j * lineSize];
+        TraceSink::formatBits(line, values[j], 32);
+        line[32] = '\n';
+        tracedValues[j] = values[j];
+    }
+    tracedValid = true;
+    sink.put(tracedLines, sizeof(tracedLines));
+}
+
 void RegisterFile::debugPrintRegisters() {
     cout << "Register File contents:" << endl;
     for (int i = 0; i < 32; i++) {
-        cout << "R" << i << ": " << Registers[i] << " (0x" << hex << Registers[i].to_ulong() << dec << ")" << endl;
+        cout << "R" << i << ": " << bitset<32>(Registers[i]) << " (0x" << hex << Registers[i] << dec << ")" << endl;
     }
 }
 
 bitset<32> RegisterFile::debugGetRegister(int index) {
     if (index >= 0 && index < 32) {
-        return Registers[index];
+        return bitset<32>(Registers[index]);
     }
     return bitset<32>(0);
 }
 
 void RegisterFile::debugSetRegister(int index, bitset<32> value) {
     if (index > 0 && index < 32) {  // Register 0 is always 0
-        Registers[index] = value;
+        Registers[index] = value.to_ulong();
     }
 }
\ No newline at end of file
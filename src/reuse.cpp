@@ -0,0 +1,158 @@
+#include "../include/reuse.h"
+#include <algorithm>
+#include <iomanip>
+
+// ==========================================
+// STACK DISTANCES
+// ==========================================
+
+void StackDistance::add(uint32_t time, int32_t delta) {
+    for (; time < tree.size(); time += time & -time) tree[time] += delta;
+}
+
+uint32_t StackDistance::prefix(uint32_t time) const {
+    uint32_t sum = 0;
+    for (; time > 0; time -= time & -time) sum += tree[time];
+    return sum;
+}
+
+void StackDistance::compact() {
+    vector<pair<uint32_t, uint32_t>> live;  // (time, line)
+    live.reserve(latest.size());
+    for (const auto& [line, time] : latest) live.push_back({time, line});
+    sort(live.begin(), live.end());
+    // room for as many new accesses as there are lines, at least 4096
+    size_t size = max<size_t>(2 * live.size(), 4096) + 1;
+    tree.assign(size, 0);
+    for (uint32_t i = 0; i < live.size(); i++) {
+        latest[live[i].second] = i + 1;
+        tree[i + 1] = 1;
+    }
+    // build the Fenwick tree in place
+    for (uint32_t i = 1; i < size; i++) {
+        uint32_t parent = i + (i & -i);
+        if (parent < size) tree[parent] += tree[i];
+    }
+    now = (uint32_t)live.size();
+}
+
+uint64_t StackDistance::access(uint32_t line) {
+    if (now + 1 >= tree.size()) compact();
+    uint32_t t = ++now;
+    auto [it, inserted] = latest.try_emplace(line, t);
+    uint64_t distance = Cold;
+    if (!inserted) {
+        distance = prefix(t - 1) - prefix(it->second);
+        add(it->second, -1);
+        it->second = t;
+    }
+    add(t, 1);
+    return distance;
+}
+
+// ==========================================
+// MISS RATIO CURVES
+// ==========================================
+
+constexpr uint32_t CacheProfiler::reportWays[];
+
+CacheProfiler::CacheProfiler(uint32_t lineBytes, uint32_t maxWays, uint32_t maxSetBits)
+    : lineBits(0), maxWays(maxWays), maxSetBits(maxSetBits) {
+    while ((2u << lineBits) <= lineBytes) lineBits++;
+    for (uint32_t s = 0; s <= maxSetBits; s++) {
+        stacks.emplace_back((size_t)maxWays << s);
+        depths.emplace_back((size_t)1 << s, 0);
+        hitsAt.emplace_back(maxWays, 0);
+    }
+}
+
+void CacheProfiler::access(uint32_t addr) {
+    uint32_t line = addr >> lineBits;
+    total++;
+
+    uint64_t d = full.access(line);
+    if (d == StackDistance::Cold) {
+        cold++;
+    } else {
+        if (d >= distances.size()) distances.resize(d + 1, 0);
+        distances[d]++;
+    }
+
+    for (uint32_t s = 0; s <= maxSetBits; s++) {
+        uint32_t set = line & ((1u << s) - 1);
+        uint32_t* stack = &stacks[s][(size_t)set * maxWays];
+        uint8_t& used = depths[s][set];
+        uint32_t depth = 0;
+        while (depth < used && stack[depth] != line) depth++;
+        if (depth < used) {
+            hitsAt[s][depth]++;
+        } else if (used < maxWays) {
+            used++;
+        } else {
+            depth = maxWays - 1;  // the least recent line falls out
+        }
+        // move to the front
+        for (; depth > 0; depth--) stack[depth] = stack[depth - 1];
+        stack[0] = line;
+    }
+}
+
+double CacheProfiler::missRatio(uint64_t capacity, uint32_t ways) const {
+    if (total == 0) return 0;
+    uint64_t lines = capacity >> lineBits;
+    if (ways == 0) {
+        uint64_t hits = 0;
+        for (uint64_t d = 0; d < lines && d < distances.size(); d++) hits += distances[d];
+        return (double)(total - hits) / total;
+    }
+    if (ways > maxWays || lines < ways || lines % ways) return -1;
+    uint64_t sets = lines / ways;
+    if (sets & (sets - 1)) return -1;
+    uint32_t s = 0;
+    while (((uint64_t)1 << s) < sets) s++;
+    if (s > maxSetBits) return -1;
+    uint64_t hits = 0;
+    for (uint32_t depth = 0; depth < ways; depth++) hits += hitsAt[s][depth];
+    return (double)(total - hits) / total;
+}
+
+void CacheProfiler::report(ostream& out, const string& stream) const {
+    out << stream << ": " << total << " accesses, " << full.lines() << " lines, " << cold << " cold misses" << endl;
+    out << setw(10) << "Capacity" << setw(10) << "full";
+    for (uint32_t ways : reportWays) out << setw(9) << ways << "w";
+    out << endl;
+    double floor = total ? (double)cold / total : 0;
+    uint64_t largest = (uint64_t)maxWays << (maxSetBits + lineBits);
+    for (uint64_t capacity = getLineBytes(); capacity <= largest; capacity *= 2) {
+        string size = capacity >= (1 << 20) ? to_string(capacity >> 20) + "M"
+                      : capacity >= (1 << 10) ? to_string(capacity >> 10) + "K"
+                                              : to_string(capacity) + "B";
+        out << setw(10) << size << fixed << setprecision(6) << setw(10) << missRatio(capacity);
+        bool flat = missRatio(capacity) <= floor;
+        for (uint32_t ways : reportWays) {
+            double ratio = missRatio(capacity, ways);
+            if (ratio < 0) {
+                out << setw(10) << "-";
+            } else {
+                out << setw(10) << ratio;
+                flat &= ratio <= floor;
+            }
+        }
+        out << endl;
+        if (flat) break;
+    }
+    out << endl;
+}
+
+void outputCacheReport(const string& outputDir, const CacheProfiler& fetches, const CacheProfiler& data) {
+    string reportFile = outputDir + "/CacheReport.txt";
+    ofstream out(reportFile, ios::trunc);
+    if (!out.is_open()) {
+        cout << "Unable to open cache report file: " << reportFile << endl;
+        return;
+    }
+    out << "LRU miss ratios by capacity and associativity (" << data.getLineBytes() << "-byte lines):" << endl;
+    out << endl;
+    fetches.report(out, "Instruction fetches");
+    data.report(out, "Data accesses");
+}
@@ -0,0 +1,289 @@
+#include "../include/simpoint.h"
+#include "../include/fastforward.h"
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <random>
+
+using WindowCore = FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>;
+
+// ==========================================
+// K-MEANS AND BIC
+// ==========================================
+
+namespace {
+
+struct Clustering {
+    vector<uint32_t> labels;
+    vector<vector<double>> centers;
+    double sse = 0;
+};
+
+double distance2(const vector<double>& a, const vector<double>& b) {
+    double sum = 0;
+    for (size_t i = 0; i < a.size(); i++) sum += (a[i] - b[i]) * (a[i] - b[i]);
+    return sum;
+}
+
+// Lloyd's algorithm from a k-means++ seeding
+Clustering kmeans(const vector<vector<double>>& points, uint32_t k, mt19937& rng) {
+    size_t n = points.size();
+    Clustering c;
+    c.centers.push_back(points[uniform_int_distribution<size_t>(0, n - 1)(rng)]);
+    vector<double> nearest(n);
+    while (c.centers.size() < k) {
+        double total = 0;
+        for (size_t i = 0; i < n; i++) {
+            nearest[i] = numeric_limits<double>::max();
+            for (const auto& center : c.centers) nearest[i] = min(nearest[i], distance2(points[i], center));
+            total += nearest[i];
+        }
+        if (total == 0) break;  // fewer distinct points than k
+        double pick = uniform_real_distribution<double>(0, total)(rng);
+        size_t i = 0;
+        for (; i + 1 < n && pick >= nearest[i]; i++) pick -= nearest[i];
+        c.centers.push_back(points[i]);
+    }
+
+    size_t dims = points[0].size();
+    c.labels.assign(n, UINT32_MAX);
+    for (int iteration = 0; iteration < 100; iteration++) {
+        bool changed = false;
+        c.sse = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t best = 0;
+            double bestDistance = numeric_limits<double>::max();
+            for (uint32_t j = 0; j < c.centers.size(); j++) {
+                double d = distance2(points[i], c.centers[j]);
+                if (d < bestDistance) {
+                    bestDistance = d;
+                    best = j;
+                }
+            }
+            changed |= c.labels[i] != best;
+            c.labels[i] = best;
+            c.sse += bestDistance;
+        }
+        if (!changed) break;
+        // an emptied cluster keeps its old center
+        vector<vector<double>> sums(c.centers.size(), vector<double>(dims, 0));
+        vector<size_t> sizes(c.centers.size(), 0);
+        for (size_t i = 0; i < n; i++) {
+            sizes[c.labels[i]]++;
+            for (size_t d = 0; d < dims; d++) sums[c.labels[i]][d] += points[i][d];
+        }
+        for (size_t j = 0; j < c.centers.size(); j++) {
+            if (!sizes[j]) continue;
+            for (size_t d = 0; d < dims; d++) c.centers[j][d] = sums[j][d] / sizes[j];
+        }
+    }
+    return c;
+}
+
+// Bayesian information criterion of a spherical Gaussian mixture, as in
+// X-means; higher is better
+double bic(const Clustering& c, size_t n, size_t dims) {
+    size_t k = c.centers.size();
+    double variance = max(c.sse / (double)(dims * (n - k)), 1e-12);
+    vector<size_t> sizes(k, 0);
+    for (uint32_t label : c.labels) sizes[label]++;
+    double likelihood = -(double)(n * dims) / 2 * log(2 * M_PI * variance) - (double)(dims * (n - k)) / 2;
+    for (size_t size : sizes) {
+        if (size) likelihood += size * log((double)size / n);
+    }
+    double parameters = (k - 1) + k * dims + 1;
+    return likelihood - parameters / 2 * log((double)n);
+}
+
+}  // namespace
+
+vector<uint32_t> clusterPoints(const vector<vector<double>>& points, uint32_t maxClusters, uint32_t seed) {
+    size_t n = points.size();
+    if (n <= 1) return vector<uint32_t>(n, 0);
+    mt19937 rng(seed);
+
+    // every k below n, each the best of a few seedings
+    uint32_t maxK = (uint32_t)min<size_t>(max<uint32_t>(maxClusters, 1), n - 1);
+    vector<Clustering> runs;
+    vector<double> scores;
+    for (uint32_t k = 1; k <= maxK; k++) {
+        Clustering best;
+        for (int attempt = 0; attempt < 5; attempt++) {
+            Clustering c = kmeans(points, k, rng);
+            if (attempt == 0 || c.sse < best.sse) best = move(c);
+        }
+        scores.push_back(bic(best, n, points[0].size()));
+        runs.push_back(move(best));
+    }
+    double lo = *min_element(scores.begin(), scores.end());
+    double hi = *max_element(scores.begin(), scores.end());
+    size_t chosen = 0;
+    while (scores[chosen] < lo + 0.9 * (hi - lo)) chosen++;
+    return runs[chosen].labels;
+}
+
+// ==========================================
+// SAMPLED SIMULATION
+// ==========================================
+
+// Block vectors as instruction fractions, projected to `dims` dimensions
+static vector<vector<double>> projectIntervals(const BbvProfiler& profile, uint32_t dims, uint32_t seed) {
+    mt19937 rng(seed);
+    uniform_real_distribution<double> uniform(-1, 1);
+    vector<double> projection(profile.blockCount() * dims);
+    for (double& p : projection) p = uniform(rng);
+
+    vector<vector<double>> points;
+    for (const BbvInterval& interval : profile.intervals()) {
+        vector<double> point(dims, 0);
+        for (const auto& [block, count] : interval.blocks) {
+            double fraction = (double)count / interval.instructions;
+            for (uint32_t d = 0; d < dims; d++) point[d] += fraction * projection[block * dims + d];
+        }
+        points.push_back(move(point));
+    }
+    return points;
+}
+
+// Cycles of the detailed pipeline from fetching instruction start to
+// fetching instruction start + count - 1, after warming the pipeline with up
+// to `warmup` instructions before start. The functional core is moved to
+// the start of the warm-up, and a window that ends the program runs on to
+// record the drain in result.drainCycles.
+static uint64_t simulateWindow(FastForwardCore& functional, DataMem& dmem, const string& ioDir, const InsMem& imem,
+                               uint64_t start, uint64_t count, uint64_t warmup, SimPointResult& result) {
+    uint64_t warm = min(warmup, start);
+    fastForward(functional, StopCondition::instructions(start - warm - functional.getInstructionCount()));
+    DataMem windowMem(dmem);
+    WindowCore window(ioDir, imem, windowMem);
+    window.setArchState(functional.getArchState());
+    window.runUntil(StopCondition::instructions(warm));
+    uint64_t cycles = window.runUntil(StopCondition::instructions(count)).cycles;
+    if (start + count == result.instructions) result.drainCycles = window.runUntil(StopCondition()).cycles;
+    return cycles;
+}
+
+SimPointResult runSimPoints(const string& ioDir, const InsMem& imem, DataMem& dmem, const SimPointOptions& opts) {
+    SimPointResult result;
+    result.intervalSize = opts.intervalSize;
+
+    // 1. profile on a copy of the initial memory
+    DataMem profileMem(dmem);
+    ProfileCore profiler(ioDir, imem, profileMem);
+    BbvProfiler& profile = profiler.getStats().profile;
+    profile = BbvProfiler(opts.intervalSize);
+    while (!profiler.halted && profiler.runBlocks(UINT64_MAX)) {}
+    profiler.runUntil(StopCondition());
+    profile.finish();
+    const vector<BbvInterval>& intervals = profile.intervals();
+    result.intervals = intervals.size();
+    result.instructions = profile.model().instructions();
+    if (intervals.empty()) return result;
+    result.modelCycles = profile.model().cycles();
+
+    // 2. cluster and pick the interval closest to each centroid
+    vector<vector<double>> points = projectIntervals(profile, opts.dimensions, opts.seed);
+    vector<uint32_t> labels = clusterPoints(points, opts.maxClusters, opts.seed);
+    uint32_t clusters = *max_element(labels.begin(), labels.end()) + 1;
+    vector<vector<double>> centers(clusters, vector<double>(opts.dimensions, 0));
+    vector<uint32_t> members(clusters, 0);
+    vector<uint64_t> clusterInstructions(clusters, 0);
+    for (size_t i = 0; i < points.size(); i++) {
+        members[labels[i]]++;
+        clusterInstructions[labels[i]] += intervals[i].instructions;
+        for (uint32_t d = 0; d < opts.dimensions; d++) centers[labels[i]][d] += points[i][d];
+    }
+    vector<size_t> representative(clusters, SIZE_MAX);
+    vector<double> closest(clusters, numeric_limits<double>::max());
+    for (size_t i = 0; i < points.size(); i++) {
+        uint32_t c = labels[i];
+        vector<double> center = centers[c];
+        for (double& x : center) x /= members[c];
+        double d = distance2(points[i], center);
+        if (d < closest[c]) {
+            closest[c] = d;
+            representative[c] = i;
+        }
+    }
+    for (uint32_t c = 0; c < clusters; c++) {
+        if (representative[c] == SIZE_MAX) continue;  // label never used
+        const BbvInterval& interval = intervals[representative[c]];
+        SimPoint p;
+        p.interval = representative[c];
+        p.start = interval.start;
+        p.instructions = interval.instructions;
+        p.members = members[c];
+        p.weight = (double)clusterInstructions[c] / result.instructions;
+        p.cpi = 0;
+        p.modelCpi = (double)interval.cycles / interval.instructions;
+        result.points.push_back(p);
+    }
+    sort(result.points.begin(), result.points.end(),
+         [](const SimPoint& a, const SimPoint& b) { return a.start < b.start; });
+
+    // 3. fast-forward to each representative and simulate it in detail.
+    // A program of a single interval is the whole run, drain included.
+    FastForwardCore functional(ioDir, imem, dmem);
+    bool drained = false;
+    double sampledCycles = 0;
+    for (SimPoint& p : result.points) {
+        p.cpi = (double)simulateWindow(functional, dmem, ioDir, imem, p.start, p.instructions, opts.warmup, result) /
+                p.instructions;
+        drained |= p.start + p.instructions == result.instructions;
+        sampledCycles += p.weight * p.cpi * result.instructions;
+    }
+    // the drain after HALT, when no representative ends the program
+    if (!drained) simulateWindow(functional, dmem, ioDir, imem, result.instructions - 1, 1, opts.warmup, result);
+    result.cpi = (sampledCycles + result.drainCycles) / result.instructions;
+    // leave the final memory behind
+    fastForward(functional, StopCondition());
+    return result;
+}
+
+uint64_t SimPointResult::cycles() const {
+    return (uint64_t)llround(cpi * instructions);
+}
+
+double SimPointResult::modelDifference() const {
+    if (modelCycles == 0) return 0;
+    return 100.0 * fabs((double)cycles() - (double)modelCycles) / modelCycles;
+}
+
+void SimPointResult::outputSimPoints(const string& outputDir) const {
+    string pointsFile = outputDir + "/SimPoints.txt";
+    ofstream out(pointsFile, ios::trunc);
+    if (!out.is_open()) {
+        cout << "Unable to open SimPoint output file: " << pointsFile << endl;
+        return;
+    }
+    out << "SimPoints of " << intervals << " intervals of " << intervalSize << " instructions:" << endl;
+    for (const SimPoint& p : points) {
+        out << "Interval " << p.interval << " (instructions " << p.start << ".." << p.start + p.instructions
+            << "): " << p.members << " intervals, weight " << fixed << setprecision(6) << p.weight
+            << ", CPI " << p.cpi << ", interval model CPI " << p.modelCpi << endl;
+    }
+    out << "Drain cycles -> " << drainCycles << endl;
+    out << "Interval model cycles -> " << modelCycles << endl;
+    out << "Estimated cycles -> " << cycles() << endl;
+    out << "Estimated CPI -> " << fixed << setprecision(16) << cpi << endl;
+    out << "Estimated IPC -> " << fixed << setprecision(16) << ipc() << endl;
+    out << "Difference from interval model -> " << fixed << setprecision(4) << modelDifference() << "%" << endl;
+}
+
+void SimPointResult::outputPerformanceMetrics(const string& outputDir) const {
+    string perfFile = outputDir + "/PerformanceMetrics.txt";
+    ofstream perfOut(perfFile, ios::app);
+    if (!perfOut.is_open()) {
+        cout << "Unable to open performance metrics file: " << perfFile << endl;
+        return;
+    }
+    perfOut << "Performance of Five Stage (SimPoint estimate):" << endl;
+    perfOut << "#Cycles -> " << cycles() << endl;
+    perfOut << "#Instructions -> " << instructions << endl;
+    if (instructions > 0) {
+        perfOut << "CPI -> " << fixed << setprecision(16) << cpi << endl;
+        perfOut << "IPC -> " << fixed << setprecision(16) << ipc() << endl;
+    }
+    perfOut << "Difference from interval model -> " << fixed << setprecision(4) << modelDifference() << "%" << endl;
+    perfOut << endl;
+}
@@ -0,0 +1,135 @@
+#include "../include/core.h"
+
+// Direct-threaded interpreter for SingleStageCore.
+//
+// Each handler ends by fetching the next predecoded instruction and jumping
+// straight to its handler through a label table (GCC/Clang computed goto), so
+// there is no central switch and no return to the driver per instruction.
+// Other compilers fall back to a switch that jumps to the same handlers.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SS_COMPUTED_GOTO 1
+#endif
+
+template <class Tracer, class Stats, class Memory>
+uint64_t SingleStageCoreT<Tracer, Stats, Memory>::runThreaded(uint64_t maxInstrs) {
+    if (halted || maxInstrs == 0) return 0;
+    if (state.IF.nop) {  // HALT already executed, only the drain cycle is left
+        step();
+        return 0;
+    }
+
+    uint32_t regs[32];
+    for (int i = 0; i < 32; i++) {
+        regs[i] = myRF.readReg(i);
+    }
+    uint32_t pc = state.IF.PC;
+    uint64_t executed = 0;
+    const DecodedInstr* d;
+    uint32_t mem_addr = 0;  // of the last LW/SW, for the commit hook
+
+#ifdef SS_COMPUTED_GOTO
+    // indexed by Op, must follow the enum order in decoder.h
+    static void* const dispatch[] = {
+        &&do_ADD, &&do_SUB, &&do_XOR, &&do_OR, &&do_AND,
+        &&do_ADDI, &&do_XORI, &&do_ORI, &&do_ANDI,
+        &&do_LW, &&do_SW,
+        &&do_BEQ, &&do_BNE,
+        &&do_JAL,
+        &&do_HALT, &&do_NOP
+    };
+    static_assert(sizeof(dispatch) / sizeof(dispatch[0]) == (size_t)Op::NOP + 1,
+                  "dispatch table out of sync with Op");
+#define DISPATCH() do { d = &program.at(pc); goto *dispatch[(size_t)d->op]; } while (0)
+#else
+#define DISPATCH() do { d = &program.at(pc); goto dispatch_switch; } while (0)
+#endif
+
+    // Retire the current instruction and continue with the one at next_pc
+#define NEXT(next_pc) do {                                                  \
+        if constexpr (Stats::commits) {                                     \
+            /* branches leave their operands alone */                       \
+            stats.commit(*d, pc, mem_addr, (d->flags & JUMP) ||             \
+                ((d->flags & BRANCH) && branchTaken(d->cond, regs[d->rs1], regs[d->rs2])));\
+        }                                                                   \
+        pc = (next_pc);                                                     \
+        regs[0] = 0;                                                        \
+        stats.retire(d->op);                                                \
+        if constexpr (Tracer::everyCycle) {                                 \
+            myRF.writeReg(d->rd, regs[d->rd]);        \
+            state.IF.PC = pc;                                               \
+            dumpCycle();                                                    \
+        }                                                                   \
+        cycle++;                                                            \
+        if (++executed >= maxInstrs) goto done;                             \
+        DISPATCH();                                                         \
+    } while (0)
+
+    DISPATCH();
+
+#ifndef SS_COMPUTED_GOTO
+dispatch_switch:
+    switch (d->op) {
+        case Op::ADD:  goto do_ADD;
+        case Op::SUB:  goto do_SUB;
+        case Op::XOR:  goto do_XOR;
+        case Op::OR:   goto do_OR;
+        case Op::AND:  goto do_AND;
+        case Op::ADDI: goto do_ADDI;
+        case Op::XORI: goto do_XORI;
+        case Op::ORI:  goto do_ORI;
+        case Op::ANDI: goto do_ANDI;
+        case Op::LW:   goto do_LW;
+        case Op::SW:   goto do_SW;
+        case Op::BEQ:  goto do_BEQ;
+        case Op::BNE:  goto do_BNE;
+        case Op::JAL:  goto do_JAL;
+        case Op::HALT: goto do_HALT;
+        default:       goto do_NOP;
+    }
+#endif
+
+do_ADD:  regs[d->rd] = regs[d->rs1] + regs[d->rs2];          NEXT(pc + 4);
+do_SUB:  regs[d->rd] = regs[d->rs1] - regs[d->rs2];          NEXT(pc + 4);
+do_XOR:  regs[d->rd] = regs[d->rs1] ^ regs[d->rs2];          NEXT(pc + 4);
+do_OR:   regs[d->rd] = regs[d->rs1] | regs[d->rs2];          NEXT(pc + 4);
+do_AND:  regs[d->rd] = regs[d->rs1] & regs[d->rs2];          NEXT(pc + 4);
+do_ADDI: regs[d->rd] = regs[d->rs1] + (uint32_t)d->imm;      NEXT(pc + 4);
+do_XORI: regs[d->rd] = regs[d->rs1] ^ (uint32_t)d->imm;      NEXT(pc + 4);
+do_ORI:  regs[d->rd] = regs[d->rs1] | (uint32_t)d->imm;      NEXT(pc + 4);
+do_ANDI: regs[d->rd] = regs[d->rs1] & (uint32_t)d->imm;      NEXT(pc + 4);
+do_LW:
+    mem_addr = regs[d->rs1] + d->imm;
+    regs[d->rd] = Memory::load(ext_dmem, mem_addr);
+    NEXT(pc + 4);
+do_SW:
+    mem_addr = regs[d->rs1] + d->imm;
+    Memory::store(ext_dmem, mem_addr, regs[d->rs2]);
+    NEXT(pc + 4);
+do_BEQ:  NEXT(regs[d->rs1] == regs[d->rs2] ? d->target : pc + 4);
+do_BNE:  NEXT(regs[d->rs1] != regs[d->rs2] ? d->target : pc + 4);
+do_JAL:  regs[d->rd] = pc + 4;                               NEXT(d->target);
+do_NOP:                                                      NEXT(pc + 4);
+do_HALT:
+done:
+#undef NEXT
+#undef DISPATCH
+
+    for (int i = 1; i < 32; i++) {
+        myRF.writeReg(i, regs[i]);
+    }
+    state.IF.PC = pc;
+    nextState = state;
+
+    // HALT and the following drain cycle go through the reference path
+    if (executed < maxInstrs && program.at(pc).op == Op::HALT) {
+        step();
+        step();
+        executed++;
+    }
+    return executed;
+}
+
+#define INSTANTIATE_SS(T, S, M) template uint64_t SingleStageCoreT<T, S, M>::runThreaded(uint64_t);
+SS_CORE_CONFIGS(INSTANTIATE_SS)
+#undef INSTANTIATE_SS
@@ -0,0 +1,105 @@
+#include "../include/tracesink.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define TRACE_AVX2 1
+#endif
+
+TraceSink::TraceSink() : buf(bufferSize) {}
+
+TraceSink::~TraceSink() {
+    close();
+}
+
+bool TraceSink::open(const string& path) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        cout << "Unable to open " << path << " for writing." << endl;
+        return false;
+    }
+    setvbuf(file, nullptr, _IONBF, 0);  // buf is the only buffer
+    return true;
+}
+
+void TraceSink::flush() {
+    if (used) writeOut(buf.data(), used);
+    used = 0;
+}
+
+void TraceSink::close() {
+    if (!file) return;
+    flush();
+    fclose(file);
+    file = nullptr;
+}
+
+void TraceSink::putUnsigned(uint64_t value) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    if (used + n > bufferSize) flush();
+    while (n) buf[used++] = digits[--n];
+}
+
+void TraceSink::writeOut(const char* s, size_t n) {
+    if (file) fwrite(s, 1, n, file);
+}
+
+// ==========================================
+// BINARY DIGITS
+// ==========================================
+
+bool TraceSink::simdSupported() {
+#ifdef TRACE_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+#ifdef TRACE_AVX2
+// Four bytes to four dump lines: the bytes are broadcast, each 128-bit half
+// spreads two of them over eight lanes apiece, and the lanes are tested
+// against one bit each like formatBits
+__attribute__((target("avx2")))
+static size_t formatBytesAvx2(char* out, const uint8_t* bytes, size_t n) {
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i bits = _mm256_set1_epi64x(0x0102040810204080);
+    const __m256i zero = _mm256_set1_epi8('0');
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t four;
+        memcpy(&four, bytes + i, 4);
+        __m256i x = _mm256_shuffle_epi8(_mm256_set1_epi32((int)four), spread);
+        __m256i digits = _mm256_sub_epi8(zero, _mm256_cmpeq_epi8(_mm256_and_si256(x, bits), bits));
+        char text[32];
+        _mm256_storeu_si256((__m256i*)text, digits);
+        for (int j = 0; j < 4; j++, out += 9) {
+            memcpy(out, text + 8 * j, 8);
+            out[8] = '\n';
+        }
+    }
+    return i;
+}
+#endif
+
+void TraceSink::formatBytes(char* out, const uint8_t* bytes, size_t n, bool simd) {
+    size_t i = 0;
+#ifdef TRACE_AVX2
+    if (simd && simdSupported()) i = formatBytesAvx2(out, bytes, n);
+#else
+    (void)simd;
+#endif
+    for (; i < n; i++) {
+        char text[32];
+        formatBits(text, bytes[i], 8);
+        memcpy(out + 9 * i, text, 8);
+        out[9 * i + 8] = '\n';
+    }
+}
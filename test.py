@@ -12,7 +12,7 @@ import shutil
 import filecmp
 from pathlib import Path
 
-def run_command(cmd, cwd=None, input_text=None):
+def run_command(cmd, cwd=None, input_text=None, timeout=30):
     """Run a shell command and return the result"""
     try:
         result = subprocess.run(
@@ -22,7 +22,7 @@ def run_command(cmd, cwd=None, input_text=None):
             input=input_text,
             text=True,
             capture_output=True,
-            timeout=30
+            timeout=timeout
         )
         return result.returncode, result.stdout, result.stderr
     except subprocess.TimeoutExpired:
@@ -34,7 +34,13 @@ def run_command(cmd, cwd=None, input_text=None):
 
 
 
-def run_testcase(testcase_num):
+# Extra simulator options whose output must match the default run exactly
+ENGINE_VARIANTS = [
+    ["--engine=threaded"],
+    ["--engine=block"],
+]
+
+def run_testcase(testcase_num, extra_args=None):
     """Run a specific test case"""
     testcase = f"testcase{testcase_num}"
     input_path = f"Sample_Testcases_SS_FS/input/{testcase}"
@@ -56,7 +62,11 @@ def run_testcase(testcase_num):
     
     # Run simulator
     print(f"Running simulator with input path: {input_path}")
-    returncode, stdout, stderr = run_command("./simulator", input_text=simulator_input)
+    if extra_args:
+        print(f"Options: {' '.join(extra_args)}")
+        returncode, stdout, stderr = run_command(f"./simulator {input_path} {' '.join(extra_args)}")
+    else:
+        returncode, stdout, stderr = run_command("./simulator", input_text=simulator_input)
     
     if returncode != 0:
         print(f"Simulator failed for {testcase}")
@@ -400,6 +410,44 @@ def compare_results(testcase_num):
     
     return all_match
 
+def check_aot(testcase_num, reference):
+    """Translate the test case ahead of time and compare the native run's final state"""
+    testcase = f"testcase{testcase_num}"
+    input_path = f"Sample_Testcases_SS_FS/input/{testcase}"
+    out_dir = f"result/aot_{testcase}"
+    os.makedirs(out_dir, exist_ok=True)
+    returncode, _, stderr = run_command(
+        f"./simulator {input_path} --aot={out_dir}/prog.cpp --aot-exe={out_dir}/prog", timeout=120)
+    if returncode != 0:
+        print(f"❌ AOT translation failed: {stderr}")
+        return False
+    returncode, _, _ = run_command(f"{out_dir}/prog {input_path} {out_dir}")
+    if returncode != 0:
+        print(f"❌ AOT program failed")
+        return False
+    with open(f"{out_dir}/SS_DMEMResult.txt") as f:
+        dmem = f.read()
+    with open(f"{out_dir}/SS_RFResult.txt") as f:
+        rf = f.read()
+    # the native program only writes the final RF record
+    final_rf = "\n".join(reference["SS_RFResult.txt"].rstrip("\n").split("\n")[-33:]) + "\n"
+    shutil.rmtree(out_dir)
+    if dmem != reference["SS_DMEMResult.txt"] or rf != final_rf:
+        print(f"❌ AOT native results differ from the default run")
+        return False
+    print(f"✅ AOT native run: identical final state")
+    return True
+
+def snapshot_results(testcase_num):
+    """Read every result file of a test case, keyed by file name"""
+    result_path = f"result/testcase{testcase_num}"
+    snapshot = {}
+    if os.path.exists(result_path):
+        for name in sorted(os.listdir(result_path)):
+            with open(os.path.join(result_path, name), 'r') as f:
+                snapshot[name] = f.read()
+    return snapshot
+
 def main():
     """Main test function"""
     print("RISC-V Simulator Test Suite")
@@ -432,6 +480,17 @@ def main():
             test_results[testcase_num] = match
         else:
             test_results[testcase_num] = False
+        
+        # Alternative engines must reproduce the default run's files
+        reference = snapshot_results(testcase_num)
+        for variant in ENGINE_VARIANTS:
+            if not run_testcase(testcase_num, variant) or snapshot_results(testcase_num) != reference:
+                print(f"❌ {' '.join(variant)} output differs from the default run")
+                test_results[testcase_num] = False
+            else:
+                print(f"✅ {' '.join(variant)}: identical output")
+        if not check_aot(testcase_num, reference):
+            test_results[testcase_num] = False
     
     # Step 3: Summary
     print("\n" + "=" * 40)
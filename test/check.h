@@ -0,0 +1,21 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include "common.h"
+
+// Shared by the unit tests: each check prints one PASS/FAIL line, and
+// main() ends with `return checkSummary();`.
+
+inline int failures = 0;
+
+inline void check(bool ok, const string& what) {
+    cout << (ok ? "PASS: " : "FAIL: ") << what << endl;
+    if (!ok) failures++;
+}
+
+inline int checkSummary() {
+    cout << (failures ? "FAILED" : "ALL PASSED") << endl;
+    return failures ? 1 : 0;
+}
+
+#endif // TEST_CHECK_H
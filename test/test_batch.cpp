@@ -0,0 +1,143 @@
+// The lane-batched engine against standalone --no-trace single stage runs,
+// with lanes that diverge and reconverge or access memory outside the
+// dense window, on AVX2 and on the scalar path.
+#include "batch.h"
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <sstream>
+
+using namespace bench;
+
+static string readFile(const string& path) {
+    ifstream in(path);
+    stringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+// Data-dependent branches: each lane skips a different subset of the
+// loop body and rejoins the others at PC 28
+static const vector<uint32_t> divergentProgram = {
+    encI(0, 0, 2, 1, 0x03),        // 0:  LW   R1, R0, #0     trip count
+    encI(4, 0, 2, 3, 0x03),        // 4:  LW   R3, R0, #4     lane key
+    encI(1, 2, 0, 2, 0x13),        // 8:  ADDI R2, R2, #1
+    encR(0, 3, 2, 7, 4),           // 12: AND  R4, R2, R3
+    encB(12, 0, 4, 0),             // 16: BEQ  R4, R0, #12
+    encR(0, 2, 5, 0, 5),           // 20: ADD  R5, R5, R2
+    encS(8, 5, 0),                 // 24: SW   R5, R0, #8
+    encR(0, 4, 6, 4, 6),           // 28: XOR  R6, R6, R4
+    encB(-24, 1, 2, 1),            // 32: BNE  R2, R1, #-24
+    encS(12, 6, 0),                // 36: SW   R6, R0, #12
+    HALT                           // 40: HALT
+};
+
+static vector<string> makeLanes(const string& root, size_t lanes, uint32_t seed) {
+    vector<string> dirs;
+    uint32_t x = seed;
+    for (size_t l = 0; l < lanes; l++) {
+        string dir = root + "/testcase" + to_string(l);
+        std::filesystem::create_directories(dir);
+        writeBytes(dir + "/imem.txt", divergentProgram);
+        vector<uint32_t> data(MemSize / 4, 0);
+        x = x * 1103515245 + 12345;
+        data[0] = 1 + (x >> 16) % 50;   // trips
+        data[1] = l;                    // key
+        writeBytes(dir + "/dmem.txt", data);
+        dirs.push_back(dir);
+    }
+    return dirs;
+}
+
+static void testLanes(const vector<string>& dirs, bool simd, const string& what) {
+    InsMem imem("Imem", dirs[0]);
+    vector<string> outputs;
+    for (const string& dir : dirs) outputs.push_back(dir + (simd ? "/batch_simd" : "/batch_scalar"));
+    unique_ptr<BatchEngine> batch = runBatch(imem, dirs, outputs, simd);
+
+    size_t same = 0;
+    uint64_t instructions = 0;
+    for (size_t l = 0; l < dirs.size(); l++) {
+        string ref = dirs[l] + "/standalone";
+        DataMem dmem("SS", dirs[l]);
+        FinalStateSingleStageCore core(dirs[l], imem, dmem);
+        core.setOutputDirectory(ref);
+        core.runUntil(StopCondition());
+        dmem.outputDataMem(ref);
+        instructions += core.getInstructionCount();
+
+        same += readFile(outputs[l] + "/SS_DMEMResult.txt") == readFile(ref + "/SS_DMEMResult.txt") &&
+                readFile(outputs[l] + "/SS_RFResult.txt") == readFile(ref + "/SS_RFResult.txt") &&
+                batch->getInstructionCount(l) == core.getInstructionCount();
+    }
+    check(same == dirs.size(), what + ": " + to_string(same) + " of " + to_string(dirs.size()) +
+                                   " lanes match their standalone runs");
+    check(batch->getSteps() < instructions, what + ": " + to_string(batch->getSteps()) + " steps for " +
+                                                to_string(instructions) + " lane instructions");
+}
+
+// Lanes whose words lie past the window, straddle its end or wrap around
+// the address space, next to lanes that stay inside it
+static void testOutsideWindow(const string& root) {
+    vector<uint32_t> addrs = {4096, 998, 20, 0xFFFFFFFE, 1u << 20, 996, 1000, 8};
+    vector<DataMem> inputs;
+    for (size_t l = 0; l < addrs.size(); l++) {
+        string dir = root + "/testcase_outside" + to_string(l);
+        std::filesystem::create_directories(dir);
+        writeBytes(dir + "/imem.txt", {
+            encI(0, 0, 2, 1, 0x03),    // 0:  LW   R1, R0, #0     address
+            encI(4, 0, 2, 2, 0x03),    // 4:  LW   R2, R0, #4     value
+            encS(0, 2, 1),             // 8:  SW   R2, R1, #0
+            encI(0, 1, 2, 3, 0x03),    // 12: LW   R3, R1, #0
+            encI(8, 1, 2, 4, 0x03),    // 16: LW   R4, R1, #8
+            encR(0, 4, 3, 0, 5),       // 20: ADD  R5, R3, R4
+            encS(12, 5, 0),            // 24: SW   R5, R0, #12
+            encS(-4, 5, 1),            // 28: SW   R5, R1, #-4
+            HALT                       // 32: HALT
+        });
+        vector<uint32_t> data(MemSize / 4, 0);
+        data[0] = addrs[l];
+        data[1] = 0xA1B2C3D4 + (uint32_t)l;
+        data[3] = 0x01020304;
+        writeBytes(dir + "/dmem.txt", data);
+        inputs.emplace_back("SS", dir);
+    }
+    InsMem imem("Imem", root + "/testcase_outside0");
+
+    vector<DataMem> refMems;
+    vector<uint32_t> refRegs;
+    for (const DataMem& in : inputs) {
+        refMems.emplace_back("SS", in);
+        SingleStageCoreT<NullTracer, BasicStats, DirectMemory> core("", imem, refMems.back());
+        while (!core.halted) core.step();
+        for (uint32_t r = 0; r < 32; r++) refRegs.push_back(core.myRF.readReg(r));
+    }
+
+    for (bool simd : {true, false}) {
+        if (simd && !BatchEngine::simdSupported()) continue;
+        BatchEngine batch(imem.getProgram(), addrs.size());
+        batch.setSimd(simd);
+        for (size_t l = 0; l < addrs.size(); l++) batch.loadMemory(l, inputs[l]);
+        batch.run();
+        size_t same = 0;
+        for (size_t l = 0; l < addrs.size(); l++) {
+            DataMem out("SS", inputs[l]);
+            batch.storeMemory(l, out);
+            bool lane = out.contents().firstDifference(refMems[l].contents()) < 0;
+            for (uint32_t r = 0; r < 32; r++) lane &= batch.readReg(l, r) == refRegs[l * 32 + r];
+            same += lane;
+        }
+        check(same == addrs.size(), string(simd ? "AVX2" : "scalar") + ": " + to_string(same) + " of " +
+                                        to_string(addrs.size()) + " lanes outside the window match step()");
+    }
+}
+
+int main() {
+    vector<string> dirs = makeLanes("test/test_data/batch", 37, 7);
+    if (BatchEngine::simdSupported()) testLanes(dirs, true, "AVX2");
+    else cout << "SKIP: host without AVX2" << endl;
+    testLanes(dirs, false, "scalar");
+    testOutsideWindow("test/test_data/batch");
+
+    return checkSummary();
+}
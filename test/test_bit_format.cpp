@@ -0,0 +1,57 @@
+// Binary digit formatting of the dumps against bitset, at every width the
+// traces use and more, on the SIMD and the portable paths.
+#include "tracesink.h"
+#include "check.h"
+
+static string reference(uint32_t value, int width) {
+    return bitset<32>(value).to_string().substr(32 - width);
+}
+
+static void testBits() {
+    vector<uint32_t> values = {0, 1, 0x80000000, 0xFFFFFFFF, 0xAAAAAAAA, 0x55555555, 0x12345678, 0xFFF, 0x3F};
+    uint32_t seed = 7;
+    for (int i = 0; i < 2000; i++) values.push_back(seed = seed * 1664525 + 1013904223);
+
+    bool ok = true;
+    for (int width = 1; width <= 32; width++) {
+        for (uint32_t v : values) {
+            char out[40];
+            memset(out, '#', sizeof(out));
+            TraceSink::formatBits(out, v, width);
+            ok &= string(out, width) == reference(v, width) && out[32] == '#';
+        }
+    }
+    check(ok, "formatBits matches bitset at every width from 1 to 32");
+
+    // as the five stage record prints them
+    TraceSink sink;
+    sink.putBits(0x2A, 6);
+    sink.putBits(0xFFFFF823 & 0xFFF, 12);
+    sink.putBits(0x1F, 5);
+    check(string(sink.data(0), sink.position()) == "101010" "100000100011" "11111",
+          "odd widths (6-bit Wrt_reg_addr, 12-bit Imm) leave no stray digits");
+}
+
+static void testBytes() {
+    vector<uint8_t> bytes(1027);
+    for (size_t i = 0; i < bytes.size(); i++) bytes[i] = (uint8_t)(i * 37 + (i >> 8));
+    string expected;
+    for (uint8_t b : bytes) expected += bitset<8>(b).to_string() + "\n";
+
+    for (bool simd : {true, false}) {
+        string what = simd ? (TraceSink::simdSupported() ? "AVX2" : "portable (no AVX2)") : "portable";
+        bool ok = true;
+        for (size_t n : {0, 1, 3, 4, 5, 256, 1027}) {
+            vector<char> out(9 * n + 1, '#');
+            TraceSink::formatBytes(out.data(), bytes.data(), n, simd);
+            ok &= string(out.data(), 9 * n) == expected.substr(0, 9 * n) && out[9 * n] == '#';
+        }
+        check(ok, what + " byte lines match bitset<8> and stop at the last line");
+    }
+}
+
+int main() {
+    testBits();
+    testBytes();
+    return checkSummary();
+}
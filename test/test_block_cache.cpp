@@ -0,0 +1,96 @@
+// BlockCache: blocks end at the first branch/JAL/HALT, are translated once,
+// chain to their successors while the block engine runs, and
+// invalidate() drops overlapping blocks and unlinks every chain without
+// changing what the engine computes, also when a watched store hits the
+// block that is running.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+
+using namespace bench;
+
+using BlockCore = SingleStageCoreT<NullTracer, BasicStats, DirectMemory>;
+
+static bool sameState(BlockCore& a, DataMem& aMem, BlockCore& b, DataMem& bMem) {
+    bool same = a.cycle == b.cycle && a.getInstructionCount() == b.getInstructionCount();
+    for (uint32_t r = 0; r < 32; r++) same &= a.myRF.readReg(r) == b.myRF.readReg(r);
+    for (uint32_t addr = 0; addr < MemSize; addr += 4) same &= aMem.readWord(addr) == bMem.readWord(addr);
+    return same;
+}
+
+static void testTranslation(const InsMem& imem) {
+    BlockCache cache(imem.getProgram());
+    TranslatedBlock* body = cache.lookup(8);
+    check(body->startPC == 8 && body->endPC == 60 && body->ops.back().op == Op::BEQ,
+          "a block runs up to and including its branch");
+    check(cache.lookup(8) == body && cache.translations() == 1, "a block is translated once");
+    TranslatedBlock* tail = cache.lookup(88);
+    check(tail->endPC == 92 && tail->ops.size() == 1 && tail->ops.back().op == Op::HALT, "HALT ends a block");
+}
+
+static void testChainsAndInvalidation(const string& dir, const InsMem& imem) {
+    DataMem mem("SS", dir);
+    BlockCore core(dir, imem, mem);
+    core.runBlocks(200);
+    BlockCache* cache = core.getBlockCache();
+    TranslatedBlock* body = cache->lookup(8);
+    TranslatedBlock* latch = cache->lookup(64);  // NOP, ADDI, BNE back to 8
+    check(body->taken == latch && latch->taken == body, "the loop's blocks are chained to each other");
+
+    uint64_t translated = cache->translations();
+    size_t blocks = cache->size();
+    cache->invalidate(200, 300);
+    check(cache->size() == blocks && latch->taken == body, "invalidating code-free addresses keeps every chain");
+
+    // the SW inside the loop body, also part of the entry block at 0
+    cache->invalidate(40, 44);
+    check(cache->size() == blocks - 2 && cache->lookup(64) == latch, "only the overlapping blocks are dropped");
+    check(latch->taken == nullptr && latch->fallthrough == nullptr, "every chain is unlinked");
+    TranslatedBlock* again = cache->lookup(8);
+    check(cache->translations() == translated + 1 && again->startPC == 8 && again->endPC == 60,
+          "the dropped block is retranslated on its next lookup");
+
+    // the run continues across the invalidation and again after dropping everything
+    core.runBlocks(100);
+    cache->invalidate(0, UINT32_MAX);
+    check(cache->size() == 0, "invalidating the whole address space empties the cache");
+    while (!core.halted) core.runBlocks(UINT64_MAX);
+
+    DataMem refMem("SS", dir);
+    BlockCore ref(dir, imem, refMem);
+    while (!ref.halted) ref.step();
+    check(sameState(core, mem, ref, refMem), "a run across invalidations ends in the stepped state");
+}
+
+// The loop stores to address 8, inside its own running block, every trip
+static void testStoreWatch() {
+    const uint32_t trips = 50;
+    string dir = makeLoopProgram("test/test_data/block_cache_watch", trips);
+    InsMem imem("Imem", dir);
+    DataMem refMem("SS", dir), mem("SS", dir);
+    BlockCore ref(dir, imem, refMem), core(dir, imem, mem);
+    while (!ref.halted) ref.step();
+
+    core.runBlocks(1);
+    BlockCache* cache = core.getBlockCache();
+    cache->watchStores(mem, 0, MemSize);
+    uint64_t before = cache->translations();
+    while (!core.halted) core.runBlocks(UINT64_MAX);
+    check(cache->translations() >= before + trips, "a store into cached code retranslates the block it hits");
+    check(sameState(core, mem, ref, refMem), "a run whose stores drop its running block ends in the stepped state");
+
+    uint64_t translated = cache->translations();
+    size_t blocks = cache->size();
+    mem.writeWord(1000, 1);
+    check(cache->translations() == translated && cache->size() == blocks,
+          "a watched store outside the translated code drops nothing");
+}
+
+int main() {
+    string dir = makeMixProgram("test/test_data/block_cache", 40);
+    InsMem imem("Imem", dir);
+    testTranslation(imem);
+    testChainsAndInvalidation(dir, imem);
+    testStoreWatch();
+    return checkSummary();
+}
@@ -0,0 +1,116 @@
+// Five stage bubble skipping against the full path: byte-identical trace,
+// register, memory and metrics files on the sample testcases and generated
+// programs, in one run or in chunks, and the same counters and stop points
+// for untraced configurations.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <sstream>
+
+using namespace bench;
+
+static string readText(const string& path) {
+    ifstream in(path);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+// Runs the graded core on dir into dir/<name>; chunk is the cycle budget
+// of each runUntil call
+static void runTraced(const string& dir, const string& name, bool skip, uint64_t chunk) {
+    string out = dir + "/" + name;
+    InsMem imem("Imem", dir);
+    DataMem dmem("FS", dir);
+    FiveStageCore core(dir, imem, dmem);
+    core.setOutputDirectory(out);
+    core.setBubbleSkip(skip);
+    while (!core.halted) core.runUntil(StopCondition::cycles(chunk));
+    dmem.outputDataMem(out);
+    std::remove((out + "/PerformanceMetrics.txt").c_str());
+    core.outputPerformanceMetrics(out);
+}
+
+static void testFiles(const string& what, const string& dir) {
+    runTraced(dir, "full", false, UINT64_MAX);
+    runTraced(dir, "skip", true, UINT64_MAX);
+    runTraced(dir, "skip_chunks", true, 3);
+    bool same = true, chunks = true;
+    for (const char* file : {"/StateResult_FS.txt", "/FS_RFResult.txt", "/FS_DMEMResult.txt", "/PerformanceMetrics.txt"}) {
+        string expected = readText(dir + "/full" + file);
+        same &= !expected.empty() && readText(dir + "/skip" + file) == expected;
+        chunks &= readText(dir + "/skip_chunks" + file) == expected;
+    }
+    check(same, what + ": every file is byte-identical with bubble skipping");
+    check(chunks, what + ": and when run three cycles at a time");
+}
+
+template <class CoreType>
+static void testCounters(const string& what, const string& dir) {
+    InsMem imem("Imem", dir);
+    DataMem fullMem("FS", dir), skipMem("FS", dir);
+    CoreType full(dir, imem, fullMem), skip(dir, imem, skipMem);
+    full.setBubbleSkip(false);
+    RunResult a = full.runUntil(StopCondition());
+    RunResult b = skip.runUntil(StopCondition());
+    bool same = a.cycles == b.cycles && a.instructions == b.instructions && full.getCycle() == skip.getCycle() &&
+                full.getInstructionCount() == skip.getInstructionCount() &&
+                fullMem.contents().firstDifference(skipMem.contents()) < 0;
+    for (uint32_t r = 0; r < 32; r++)
+        same &= full.getRegisterFile().readReg(r) == skip.getRegisterFile().readReg(r);
+    ostringstream fullReport, skipReport;
+    full.getStats().report(fullReport);
+    skip.getStats().report(skipReport);
+    check(same && fullReport.str() == skipReport.str(),
+          what + ": same cycles, instructions, statistics, registers and memory");
+}
+
+// A store still in the pipeline when HALT is fetched
+static void testStopInDrain() {
+    string dir = "test/test_data/bubble_skip/drain_store";
+    std::filesystem::create_directories(dir);
+    writeBytes(dir + "/imem.txt", {
+        encI(7, 0, 0, 1, 0x13),    // 0: ADDI R1, R0, #7
+        encS(40, 1, 0),            // 4: SW   R1, R0, #40
+        HALT                       // 8: HALT
+    });
+    writeBytes(dir + "/dmem.txt", vector<uint32_t>(MemSize / 4, 0));
+
+    InsMem imem("Imem", dir);
+    DataMem fullMem("FS", dir), skipMem("FS", dir);
+    using Core = FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>;
+    Core full(dir, imem, fullMem), skip(dir, imem, skipMem);
+    full.setBubbleSkip(false);
+    RunResult a = full.runUntil(StopCondition::onWrite(40, 44));
+    RunResult b = skip.runUntil(StopCondition::onWrite(40, 44));
+    check(a.reason == StopReason::MemoryWrite && b.reason == a.reason && b.cycles == a.cycles &&
+              skip.getCycle() == full.getCycle() && !skip.halted,
+          "a store watch stops inside the drain on the same cycle");
+    RunResult c = full.runUntil(StopCondition::cycles(1));
+    RunResult d = skip.runUntil(StopCondition::cycles(1));
+    check(c.cycles == 1 && d.cycles == 1 && skip.getCycle() == full.getCycle(), "a cycle limit splits the drain");
+    full.runUntil(StopCondition());
+    skip.runUntil(StopCondition());
+    check(skip.halted && skip.getCycle() == full.getCycle() && skipMem.readWord(40) == 7,
+          "the rest of the drain ends on the same cycle");
+}
+
+int main() {
+    for (int t = 0; t < 3; t++) {
+        string name = "testcase" + to_string(t);
+        string dir = "test/test_data/bubble_skip/" + name;
+        std::filesystem::create_directories(dir);
+        for (const char* file : {"/imem.txt", "/dmem.txt"})
+            std::filesystem::copy_file("Sample_Testcases_SS_FS/input/" + name + file, dir + file,
+                                       std::filesystem::copy_options::overwrite_existing);
+        testFiles(name, dir);
+    }
+    string mix = makeMixProgram("test/test_data/bubble_skip/mix", 30);
+    string loop = makeLoopProgram("test/test_data/bubble_skip/loop", 30);
+    testFiles("mix", mix);
+    testFiles("loop", loop);
+
+    testCounters<FiveStageCoreT<NullTracer, DetailedStats, DirectMemory, ForwardingHazards>>("DetailedStats", mix);
+    testCounters<FiveStageCoreT<NullTracer, NullStats, DirectMemory, StallingHazards>>("StallingHazards", mix);
+    testCounters<FiveStageCoreT<FinalTracer, BasicStats, DirectMemory, ForwardingHazards>>("FinalTracer", loop);
+    testStopInDrain();
+    return checkSummary();
+}
@@ -0,0 +1,103 @@
+// Single-pass cache simulation: stack distances and miss ratio curves
+// against a brute-force LRU cache of every geometry.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <list>
+
+using namespace bench;
+
+// One LRU cache of sets x ways lines, simulated directly
+static double lruMissRatio(const vector<uint32_t>& addrs, uint32_t lineBytes, uint32_t sets, uint32_t ways) {
+    vector<list<uint32_t>> cache(sets);
+    uint64_t misses = 0;
+    for (uint32_t addr : addrs) {
+        uint32_t line = addr / lineBytes;
+        list<uint32_t>& set = cache[line % sets];
+        auto it = find(set.begin(), set.end(), line);
+        if (it == set.end()) {
+            misses++;
+            if (set.size() == ways) set.pop_back();
+        } else {
+            set.erase(it);
+        }
+        set.push_front(line);
+    }
+    return (double)misses / addrs.size();
+}
+
+static void testStackDistance() {
+    StackDistance sd;
+    vector<uint64_t> got;
+    for (uint32_t line : {1, 2, 3, 1, 1, 3, 2, 4}) got.push_back(sd.access(line));
+    uint64_t cold = StackDistance::Cold;
+    check(got == vector<uint64_t>{cold, cold, cold, 2, 0, 1, 2, cold}, "stack distances of a known sequence");
+
+    // enough accesses over few lines to compact the tree many times
+    StackDistance cyclic;
+    bool ok = true;
+    for (uint32_t i = 0; i < 100000; i++) {
+        uint64_t d = cyclic.access(i % 7);
+        ok &= i < 7 ? d == cold : d == 6;
+    }
+    check(ok && cyclic.lines() == 7, "distances survive compaction");
+}
+
+static void testAgainstLru() {
+    // a mix of a hot region, a strided sweep and random lines
+    vector<uint32_t> addrs;
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < 20000; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t r = seed >> 8;
+        if (i % 3 == 0) addrs.push_back(r % 2048);
+        else if (i % 3 == 1) addrs.push_back(0x10000 + (i * 96) % 32768);
+        else addrs.push_back(r % 262144);
+    }
+    CacheProfiler profile(32, 8, 6);
+    for (uint32_t addr : addrs) profile.access(addr);
+
+    bool full = true;
+    for (uint32_t lines : {1, 3, 16, 100, 512, 5000})
+        full &= abs(profile.missRatio((uint64_t)lines * 32) - lruMissRatio(addrs, 32, 1, lines)) < 1e-12;
+    check(full, "fully associative ratios match an LRU cache");
+
+    bool sets = true;
+    for (uint32_t ways : {1, 2, 4, 8})
+        for (uint32_t setCount : {1, 4, 16, 64})
+            sets &= abs(profile.missRatio((uint64_t)setCount * ways * 32, ways) -
+                        lruMissRatio(addrs, 32, setCount, ways)) < 1e-12;
+    check(sets, "set associative ratios match an LRU cache");
+
+    check(profile.missRatio(32 * 16, 16) < 0 && profile.missRatio(32 * 3 * 4, 4) < 0 &&
+              profile.missRatio(32 * 128 * 8, 8) < 0,
+          "geometries outside the profile are rejected");
+}
+
+static void testCoreReport(const string& dir) {
+    InsMem imem("Imem", dir);
+    DataMem dmem("Cache", dir);
+    CacheCore core(dir, imem, dmem);
+    core.runUntil(StopCondition());
+    const CacheStats& stats = core.getStats();
+    check(stats.fetches.accesses() == stats.instructions(), "every committed instruction is fetched once");
+    check(stats.data.accesses() > 0 && stats.data.coldMisses() <= stats.data.accesses(), "LW/SW addresses are profiled");
+    // the loop body fits in a few lines, so anything larger only misses cold
+    double floor = (double)stats.fetches.coldMisses() / stats.fetches.accesses();
+    check(stats.fetches.missRatio(4096) == floor && stats.fetches.missRatio(4096, 4) == floor,
+          "a loop fits in a small instruction cache");
+
+    outputCacheReport(dir, stats.fetches, stats.data);
+    ifstream in(dir + "/CacheReport.txt");
+    string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    check(text.find("Instruction fetches: " + to_string(stats.instructions()) + " accesses") != string::npos &&
+              text.find("Data accesses") != string::npos,
+          "the report lists both streams");
+}
+
+int main() {
+    testStackDistance();
+    testAgainstLru();
+    testCoreReport(makeLoopProgram("test/test_data/cache_profile", 5000));
+    return checkSummary();
+}
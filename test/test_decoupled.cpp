@@ -0,0 +1,71 @@
+// The SPSC ring across two threads, and the pipeline replayed by the
+// decoupled functional/timing mode, and inline on one thread, against the
+// detailed five stage core.
+#include "decoupled.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <thread>
+
+using namespace bench;
+
+// A ring much smaller than the stream, so both sides block on each other
+static void testQueueOrder() {
+    const uint64_t count = 1000000;
+    SpscQueue<uint64_t> queue(4);
+    std::thread producer([&queue] {
+        for (uint64_t i = 0; i < count; i++) queue.push(i);
+        queue.close();
+    });
+    uint64_t expected = 0, value;
+    bool inOrder = true;
+    while (queue.pop(value)) {
+        inOrder &= value == expected;
+        expected++;
+    }
+    producer.join();
+    check(inOrder && expected == count, "SPSC ring delivers " + to_string(count) + " values in order");
+
+    uint64_t rest;
+    check(!queue.tryPop(rest) && !queue.pop(rest), "closed and drained ring pops nothing");
+}
+
+using DetailedCore = FiveStageCoreT<NullTracer, DetailedStats, DirectMemory, ForwardingHazards>;
+
+static bool sameTiming(const PipelineTiming& t, DetailedCore& ref) {
+    return t.isHalted() && t.cycles() == (uint64_t)ref.getCycle() && t.stalls() == ref.getStats().stalls &&
+           t.flushes() == ref.getStats().flushes;
+}
+
+static void testProgram(const string& dir, size_t capacityLog2) {
+    InsMem imem("Imem", dir);
+
+    DataMem refMem("FS", dir);
+    DetailedCore ref(dir, imem, refMem);
+    ref.runUntil(StopCondition());
+
+    DataMem mem("FS", dir);
+    FrontEndCore core(dir, imem, mem);
+    DecoupledResult got = runDecoupled(core, capacityLog2);
+    check(sameTiming(got.timing, ref), dir + ": decoupled " + to_string(got.timing.cycles()) + " cycles, detailed " +
+                                            to_string(ref.getCycle()) + ", same stalls and flushes");
+    check(got.records == core.getStats().instructions() && got.timing.instructions() == got.records,
+          dir + ": one record per retired instruction");
+    check(core.halted && mem.readWord(0) == refMem.readWord(0), dir + ": front-end runs to HALT");
+
+    DataMem inlineMem("FS", dir);
+    PipelineCore inlined(dir, imem, inlineMem);
+    PipelineTiming timing = runPipeline(inlined);
+    check(sameTiming(timing, ref), dir + ": and inline on one thread");
+}
+
+int main() {
+    testQueueOrder();
+    testProgram("Sample_Testcases_SS_FS/input/testcase0", 14);
+    testProgram("Sample_Testcases_SS_FS/input/testcase1", 14);
+    testProgram("Sample_Testcases_SS_FS/input/testcase2", 14);
+    testProgram(makeLoopProgram("test/test_data/decoupled_loop", 2000), 14);
+    testProgram(makeMixProgram("test/test_data/decoupled_mix", 200), 14);
+    testProgram(makeLoopProgram("test/test_data/decoupled_loop_small_ring", 2000), 3);
+
+    return checkSummary();
+}
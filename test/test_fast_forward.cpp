@@ -0,0 +1,82 @@
+// Fast-forwarding with FastForwardCore and handing the architectural state
+// to a five stage core: the detailed window finishes the program exactly
+// like a full detailed run and counts only its own instructions.
+#include "fastforward.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+
+using DetailedCore = FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>;
+
+static bool sameMemory(const DataMem& a, const DataMem& b) {
+    for (uint32_t addr = 0; addr < MemSize; addr += 4) {
+        if (a.readWord(addr) != b.readWord(addr)) return false;
+    }
+    return true;
+}
+
+static bool sameRegisters(RegisterFile& a, RegisterFile& b) {
+    for (uint32_t r = 0; r < 32; r++) {
+        if (a.readReg(r) != b.readReg(r)) return false;
+    }
+    return true;
+}
+
+// Fast-forward to `to`, then a detailed window to HALT
+static void testHandOver(const string& dir, const StopCondition& to, const string& what) {
+    InsMem imem("Imem", dir);
+    DataMem refMem("FS", dir);
+    DetailedCore ref(dir, imem, refMem);
+    ref.runUntil(StopCondition());
+
+    DataMem mem("FS", dir);
+    FastForwardCore functional(dir, imem, mem);
+    RunResult skipped = fastForward(functional, to);
+    ArchState arch = functional.getArchState();
+    // a HALT reached while fast-forwarding is executed again by the window
+    check(arch.instructions == skipped.instructions - functional.halted,
+          dir + ", " + what + ": hand-over counts the skipped instructions");
+
+    DetailedCore window(dir, imem, mem);
+    window.setArchState(arch);
+    window.runUntil(StopCondition());
+    check(window.halted && sameMemory(mem, refMem) && sameRegisters(window.getRegisterFile(), ref.getRegisterFile()),
+          dir + ", " + what + ": window ends in the full run's state");
+    check(arch.instructions + window.getInstructionCount() == ref.getInstructionCount(),
+          dir + ", " + what + ": skipped + window instructions = " + to_string(ref.getInstructionCount()));
+    check(window.getCycle() < ref.getCycle() || arch.instructions == 0,
+          dir + ", " + what + ": window cycles " + to_string(window.getCycle()) + " of " + to_string(ref.getCycle()));
+}
+
+static void testLimits(const string& dir) {
+    InsMem imem("Imem", dir);
+    DataMem mem("FS", dir);
+
+    // the loop head is at PC 8; the marker stops at its next visit
+    FastForwardCore functional(dir, imem, mem);
+    RunResult r = fastForward(functional, StopCondition::atPC(8));
+    check(r.reason == StopReason::PCMatch && functional.getArchState().pc == 8 && r.instructions == 2,
+          "PC marker stops before the loop head");
+    r = fastForward(functional, StopCondition::instructions(1000));
+    check(r.reason == StopReason::InstructionLimit && r.instructions == 1000 &&
+              functional.getInstructionCount() == 1002,
+          "instruction limit is exact on the threaded engine");
+
+    DetailedCore window(dir, imem, mem);
+    window.setArchState(functional.getArchState());
+    RunResult w = window.runUntil(StopCondition::instructions(500));
+    check(w.instructions == 500 && window.getInstructionCount() == 500 && (uint64_t)window.getCycle() == w.cycles,
+          "detailed window counts from the hand-over");
+}
+
+int main() {
+    string loop = bench::makeLoopProgram("test/test_data/fast_forward_loop", 300);
+    for (uint64_t n : {0, 1, 5, 9, 100, 1000, 2402, 5000}) {
+        testHandOver(loop, StopCondition::instructions(n), to_string(n) + " instructions");
+    }
+    testHandOver(loop, StopCondition::atPC(40), "PC 40");
+    testHandOver("Sample_Testcases_SS_FS/input/testcase0", StopCondition::instructions(3), "3 instructions");
+    testHandOver("Sample_Testcases_SS_FS/input/testcase1", StopCondition::instructions(7), "7 instructions");
+    testLimits(loop);
+
+    return checkSummary();
+}
@@ -0,0 +1,54 @@
+// FiveStageCore::step must not touch the heap once its trace sinks are open.
+// Global operator new is replaced with a counting version and a generated
+// loop program is run to completion with the graded and the untraced
+// configurations.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <cstdlib>
+#include <new>
+
+static uint64_t allocations = 0;
+
+void* operator new(size_t n) {
+    allocations++;
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+template <class CoreType>
+static void runWithoutAllocations(const char* name, const string& dir) {
+    InsMem imem("Imem", dir);
+    DataMem dmem("FS", dir);
+    CoreType core(dir, imem, dmem);
+    core.setOutputDirectory(dir + "/out_" + name);
+
+    core.step();  // the first cycle opens the trace files
+    uint64_t before = allocations;
+    while (!core.halted) core.step();
+    uint64_t during = allocations - before;
+    check(during == 0, string(name) + ": " + to_string(during) + " allocations in " +
+                           to_string(core.getCycle() - 1) + " cycles");
+
+    // the latches are plain bytes, so a snapshot is a memcpy
+    State_five snapshot;
+    memcpy(&snapshot, &core.getState(), sizeof(State_five));
+    check(memcmp(&snapshot, &core.getState(), sizeof(State_five)) == 0, string(name) + ": memcpy snapshot");
+}
+
+int main() {
+    string dir = bench::makeLoopProgram("test/test_data/fs_alloc", 200);
+
+    runWithoutAllocations<FiveStageCore>("graded", dir);
+    runWithoutAllocations<FiveStageCoreT<NullTracer, NullStats, DirectMemory, ForwardingHazards>>("untraced", dir);
+
+    // the graded run wrote one RF record (33 lines) per cycle
+    ifstream rf(dir + "/out_graded/FS_RFResult.txt");
+    size_t lines = 0;
+    for (string line; getline(rf, line);) lines++;
+    check(lines > 0 && lines % 33 == 0, "graded RF trace has " + to_string(lines / 33) + " records");
+
+    return checkSummary();
+}
@@ -0,0 +1,80 @@
+// The interval model against the detailed five stage pipeline, and the
+// commit hooks of every single stage engine against each other.
+#include "decoupled.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+
+using namespace bench;
+using DetailedCore = FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>;
+
+// Each miss event of the model once per trip: a load-use stall, a LW whose
+// stall the MEM/WB forward hides, a taken branch to PC + 4 and a JAL
+static string makeEventProgram(const string& dir, uint32_t trips) {
+    std::filesystem::create_directories(dir);
+    vector<uint32_t> prog = {
+        encI(0, 0, 2, 1, 0x03),        // 0:  LW   R1, R0, #0     trip count
+        encI(1, 2, 0, 2, 0x13),        // 4:  ADDI R2, R2, #1
+        encI(4, 0, 2, 3, 0x03),        // 8:  LW   R3, R0, #4
+        encR(0, 3, 2, 0, 4),           // 12: ADD  R4, R2, R3     load-use
+        encI(7, 0, 0, 5, 0x13),        // 16: ADDI R5, R0, #7
+        encI(4, 0, 2, 5, 0x03),        // 20: LW   R5, R0, #4
+        encR(0, 5, 0, 0, 6),           // 24: ADD  R6, R0, R5     forwarded from WB
+        encB(4, 0, 0, 0),              // 28: BEQ  R0, R0, #4     taken to PC + 4
+        encJ(8, 7),                    // 32: JAL  R7, #8
+        HALT,                          // 36: (skipped)
+        encB(-36, 1, 2, 1),            // 40: BNE  R2, R1, #-36
+        HALT                           // 44: HALT
+    };
+    writeBytes(dir + "/imem.txt", prog);
+    vector<uint32_t> data(MemSize / 4, 0);
+    data[0] = trips;
+    data[1] = 3;
+    writeBytes(dir + "/dmem.txt", data);
+    return dir;
+}
+
+static uint64_t detailedCycles(const string& dir, InsMem& imem) {
+    DataMem dmem("FS", dir);
+    DetailedCore core(dir, imem, dmem);
+    core.runUntil(StopCondition());
+    return core.getCycle();
+}
+
+template <class Run>
+static uint64_t intervalCycles(const string& dir, InsMem& imem, Run run) {
+    DataMem dmem("FS", dir);
+    IntervalCore core(dir, imem, dmem);
+    run(core);
+    core.runUntil(StopCondition());  // HALT is always left to step()
+    return core.getStats().model.cycles();
+}
+
+static void testProgram(const string& dir) {
+    InsMem imem("Imem", dir);
+    uint64_t ref = detailedCycles(dir, imem);
+    uint64_t step = intervalCycles(dir, imem, [](IntervalCore&) {});
+    uint64_t threaded = intervalCycles(dir, imem, [](IntervalCore& c) { c.runThreaded(UINT64_MAX); });
+    uint64_t blocks = intervalCycles(dir, imem, [](IntervalCore& c) { c.runBlocks(UINT64_MAX); });
+    uint64_t jit = intervalCycles(dir, imem, [](IntervalCore& c) {
+        while (!c.halted && c.runJit(UINT64_MAX)) {}
+    });
+    check(step == ref, dir + ": interval " + to_string(step) + " cycles, detailed " + to_string(ref));
+    DataMem dmem("FS", dir);
+    IntervalCore core(dir, imem, dmem);
+    uint64_t handedOver = runInterval(core).cycles();
+    check(threaded == step && blocks == step && jit == step && handedOver == step,
+          dir + ": every engine commits the same stream");
+}
+
+int main() {
+    testProgram("Sample_Testcases_SS_FS/input/testcase0");
+    testProgram("Sample_Testcases_SS_FS/input/testcase1");
+    testProgram("Sample_Testcases_SS_FS/input/testcase2");
+    testProgram(makeLoopProgram("test/test_data/interval_loop", 100));
+    // enough trips for the JIT to compile the loop
+    testProgram(makeEventProgram("test/test_data/interval_events", 100));
+    // runInterval hands over from the threaded engine to the JIT mid-loop
+    testProgram(makeEventProgram("test/test_data/interval_warmup", intervalWarmup / 9 + 500));
+
+    return checkSummary();
+}
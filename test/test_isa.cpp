@@ -0,0 +1,88 @@
+// isaTable and the generated decode table: every row decodes back from an
+// encoding of it, with its fields and immediate, and decodeInstr agrees
+// with a plain first-match scan of the table on random words.
+#include "decoder.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <random>
+
+using namespace bench;
+
+// First row whose mask/match accepts instr, NOP (the last row) otherwise
+static Op scanTable(uint32_t instr) {
+    for (size_t row = 0; row < isaTableSize; row++) {
+        if ((instr & isaTable[row].mask) == isaTable[row].match) return isaTable[row].op;
+    }
+    return Op::NOP;
+}
+
+struct Encoded {
+    uint32_t instr;
+    int32_t imm;
+};
+
+// An encoding of row op with rd 5, rs1 6, rs2 7 and immediate imm
+static Encoded encode(Op op, int32_t imm) {
+    switch (op) {
+        case Op::ADD:  return {encR(0x00, 7, 6, 0, 5), 0};
+        case Op::SUB:  return {encR(0x20, 7, 6, 0, 5), 0};
+        case Op::XOR:  return {encR(0x00, 7, 6, 4, 5), 0};
+        case Op::OR:   return {encR(0x00, 7, 6, 6, 5), 0};
+        case Op::AND:  return {encR(0x00, 7, 6, 7, 5), 0};
+        case Op::ADDI: return {encI(imm, 6, 0, 5, 0x13), imm};
+        case Op::XORI: return {encI(imm, 6, 4, 5, 0x13), imm};
+        case Op::ORI:  return {encI(imm, 6, 6, 5, 0x13), imm};
+        case Op::ANDI: return {encI(imm, 6, 7, 5, 0x13), imm};
+        case Op::LW:   return {encI(imm, 6, 2, 5, 0x03), imm};
+        case Op::SW:   return {encS(imm, 7, 6), imm};
+        case Op::BEQ:  return {encB(imm * 2, 7, 6, 0), imm * 2};
+        case Op::BNE:  return {encB(imm * 2, 7, 6, 1), imm * 2};
+        case Op::JAL:  return {encJ(imm * 2, 5), imm * 2};
+        case Op::HALT: return {HALT, 0};
+        default:       return {0, 0};
+    }
+}
+
+static void testRoundTrip() {
+    const int32_t imms[] = {0, 1, -1, 100, -100, 2047, -2048};
+    const uint32_t pc = 400;
+    for (size_t row = 0; row < isaTableSize; row++) {
+        const InstrSpec& spec = isaTable[row];
+        bool good = true;
+        for (int32_t imm : imms) {
+            Encoded e = encode(spec.op, imm);
+            DecodedInstr d = decodeInstr(e.instr, pc);
+            good &= d.op == spec.op && d.raw == e.instr && d.imm == e.imm;
+            good &= d.alu == spec.alu && d.cond == spec.cond && d.flags == spec.flags;
+            if (spec.format == Format::R || spec.format == Format::I || spec.format == Format::J)
+                good &= d.rd == 5;
+            if (spec.flags & READS_RS1) good &= d.rs1 == 6;
+            if (spec.flags & READS_RS2) good &= d.rs2 == 7;
+            if (spec.flags & (BRANCH | JUMP)) good &= d.target == pc + e.imm;
+            else if (spec.op == Op::HALT) good &= d.target == pc;
+            else good &= d.target == pc + 4;
+        }
+        check(good, string(spec.name) + " decodes back from its encodings");
+    }
+}
+
+static void testAgainstScan() {
+    std::mt19937 rng(6913);
+    uint64_t mismatches = 0;
+    for (int i = 0; i < 1000000; i++) {
+        uint32_t instr = rng();
+        // bias half the words towards the opcodes of the table
+        if (i & 1) instr = (instr & ~0x7Fu) | (isaTable[rng() % (isaTableSize - 1)].match & 0x7F);
+        mismatches += decodeInstr(instr, 0).op != scanTable(instr);
+    }
+    check(mismatches == 0,
+          "decode table agrees with a table scan on random words (" + to_string(mismatches) + " mismatches)");
+    check(decodeInstr(0, 0).op == Op::NOP && decodeInstr(0x0000007F, 0).op == Op::NOP,
+          "unknown encodings decode as NOP");
+}
+
+int main() {
+    testRoundTrip();
+    testAgainstScan();
+    return checkSummary();
+}
@@ -0,0 +1,155 @@
+// JIT engine against the interpreter: compiled blocks end in the stepped
+// state, including loads that miss the inlined TLB probe, the differential
+// check finds nothing, and runs the JIT leaves to the block interpreter
+// (cold blocks, per-cycle tracers, per-instruction commits, checked
+// memory) give the same results. A checked store that goes out of range in
+// a hot loop still throws.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+
+using namespace bench;
+
+template <class A, class B>
+static bool sameState(A& a, DataMem& aMem, B& b, DataMem& bMem) {
+    bool same = a.cycle == b.cycle && a.halted == b.halted;
+    for (uint32_t r = 0; r < 32; r++) same &= a.myRF.readReg(r) == b.myRF.readReg(r);
+    return same && aMem.contents().firstDifference(bMem.contents()) < 0;
+}
+
+template <class CoreType>
+static void runJit(CoreType& core) {
+    while (!core.halted) core.runJit(UINT64_MAX);
+}
+
+using JitCore = SingleStageCoreT<NullTracer, BasicStats, DirectMemory>;
+
+// Compiled blocks of program dir against step()
+static void testCompiled(const string& name, const string& dir) {
+    InsMem imem("Imem", dir);
+    DataMem refMem("SS", dir), jitMem("SS", dir), diffMem("SS", dir);
+    JitCore ref(dir, imem, refMem), jit(dir, imem, jitMem), diff(dir, imem, diffMem);
+    while (!ref.halted) ref.step();
+    runJit(jit);
+    check(jit.getJit() && jit.getJit()->compiledBlocks() > 0, name + ": hot blocks are compiled");
+    check(sameState(jit, jitMem, ref, refMem) && jit.getInstructionCount() == ref.getInstructionCount(),
+          name + ": compiled run ends in the stepped state");
+    diff.setJitDiff(true);
+    runJit(diff);
+    check(diff.getJitMismatches() == 0, name + ": differential check finds no mismatch");
+}
+
+// A hot loop whose loads cross a page boundary, read unmapped memory and
+// alternate between pages, so the inlined probe both hits and misses
+static string makePageProgram(const string& dir) {
+    std::filesystem::create_directories(dir);
+    vector<uint32_t> prog = {
+        encI(40, 0, 0, 1, 0x13),       // 0:  ADDI R1, R0, #40     trips
+        encI(2047, 0, 0, 2, 0x13),     // 4:  ADDI R2, R0, #2047
+        encI(2047, 2, 0, 2, 0x13),     // 8:  ADDI R2, R2, #2047   4094
+        encR(0, 2, 2, 0, 3),           // 12: ADD  R3, R2, R2      8188, end of page 1
+        encR(0, 3, 3, 0, 4),           // 16: ADD  R4, R3, R3      16376, page 3 (unmapped)
+        encS(0, 1, 3),                 // 20: SW   R1, R3, #0
+        encI(0, 2, 2, 5, 0x03),        // 24: LW   R5, R2, #0      crosses into page 1
+        encI(0, 3, 2, 6, 0x03),        // 28: LW   R6, R3, #0
+        encI(0, 4, 2, 7, 0x03),        // 32: LW   R7, R4, #0      zero
+        encI(-4, 3, 2, 8, 0x03),       // 36: LW   R8, R3, #-4
+        encI(8, 0, 2, 10, 0x03),       // 40: LW   R10, R0, #8     page 0
+        encR(0, 6, 9, 0, 9),           // 44: ADD  R9, R9, R6
+        encR(0, 5, 9, 0, 9),           // 48: ADD  R9, R9, R5
+        encR(0, 8, 9, 4, 9),           // 52: XOR  R9, R9, R8
+        encR(0, 10, 9, 0, 9),          // 56: ADD  R9, R9, R10
+        encS(4, 9, 2),                 // 60: SW   R9, R2, #4      4098
+        encS(8, 1, 0),                 // 64: SW   R1, R0, #8
+        encI(-1, 1, 0, 1, 0x13),       // 68: ADDI R1, R1, #-1
+        encB(-52, 0, 1, 1),            // 72: BNE  R1, R0, #-52
+        HALT                           // 76: HALT
+    };
+    writeBytes(dir + "/imem.txt", prog);
+    vector<uint32_t> data(MemSize / 4, 0);
+    data[2] = 0x01020304;
+    writeBytes(dir + "/dmem.txt", data);
+    return dir;
+}
+
+template <class CoreType>
+static void checkFallback(const string& name, const string& dir) {
+    InsMem imem("Imem", dir);
+    DataMem refMem("SS", dir), mem("SS", dir);
+    JitCore ref(dir, imem, refMem);
+    CoreType core(dir, imem, mem);
+    core.setOutputDirectory(dir + "/out");
+    while (!ref.halted) ref.step();
+    runJit(core);
+    check(sameState(core, mem, ref, refMem), name + " ends in the stepped state");
+}
+
+static void testFallbacks(const string& hotDir) {
+    // a loop too short for any block to reach the hot threshold
+    string coldDir = makeMixProgram("test/test_data/jit_cold", JitEngine::hotThreshold / 2);
+    InsMem imem("Imem", coldDir);
+    DataMem refMem("SS", coldDir), mem("SS", coldDir);
+    JitCore ref(coldDir, imem, refMem), cold(coldDir, imem, mem);
+    while (!ref.halted) ref.step();
+    runJit(cold);
+    check(!cold.getJit() && sameState(cold, mem, ref, refMem),
+          "cold blocks are interpreted, without mapping a code buffer, and end in the stepped state");
+
+    // configurations that keep runJit on the block interpreter or the call path
+    checkFallback<SingleStageCore>("a per-cycle tracer", hotDir);
+    checkFallback<SingleStageCoreT<NullTracer, BbvStats, DirectMemory>>("per-instruction commits", hotDir);
+    checkFallback<SingleStageCoreT<NullTracer, NullStats, CheckedMemory>>("checked memory", hotDir);
+
+    DataMem tracedMem("SS", hotDir);
+    SingleStageCore traced(hotDir, imem, tracedMem);
+    traced.setOutputDirectory(hotDir + "/out");
+    runJit(traced);
+    check(traced.getJit() == nullptr, "a per-cycle tracer never starts the JIT");
+}
+
+// A loop storing to R1 - trips/2 as R1 counts down, so the store is in
+// range while the block turns hot and wraps past the top of memory later
+static void testCheckedThrows() {
+    string dir = "test/test_data/jit_checked";
+    std::filesystem::create_directories(dir);
+    const int32_t trips = 8 * JitEngine::hotThreshold;
+    writeBytes(dir + "/imem.txt", {
+        encI(trips, 0, 0, 1, 0x13),       // 0:  ADDI R1, R0, #trips
+        encI(-trips / 2, 0, 0, 2, 0x13),  // 4:  ADDI R2, R0, #-trips/2
+        encR(0, 2, 1, 0, 3),              // 8:  ADD  R3, R1, R2
+        encS(0, 0, 3),                    // 12: SW   R0, R3, #0
+        encI(-1, 1, 0, 1, 0x13),          // 16: ADDI R1, R1, #-1
+        encB(-12, 0, 1, 1),               // 20: BNE  R1, R0, #-12
+        HALT                              // 24: HALT
+    });
+    writeBytes(dir + "/dmem.txt", vector<uint32_t>(MemSize / 4, 0));
+
+    InsMem imem("Imem", dir);
+    DataMem mem("SS", dir);
+    SingleStageCoreT<NullTracer, NullStats, CheckedMemory> core(dir, imem, mem);
+    bool thrown = false;
+    try {
+        runJit(core);
+    } catch (const out_of_range&) {
+        thrown = true;
+    }
+    check(thrown && !core.getJit(),
+          "an out-of-range store in a hot checked loop throws from the block interpreter");
+}
+
+int main() {
+    if (!JitEngine::available()) {
+        cout << "JIT not available on this host, skipped" << endl;
+        return checkSummary();
+    }
+    string mixDir = makeMixProgram("test/test_data/jit", 60);
+    testCompiled("mix", mixDir);
+    testCompiled("pages", makePageProgram("test/test_data/jit_pages"));
+    testFallbacks(mixDir);
+    testCheckedThrows();
+
+    DataMem mem("SS", mixDir);
+    JitEngine engine(mem, &DirectMemory::load, &DirectMemory::store, true);
+    cout << "LW/SW calls are " << (engine.nearCalls() ? "rel32" : "absolute") << endl;
+    return checkSummary();
+}
@@ -0,0 +1,97 @@
+// Binary memory images: text conversion, private mappings that leave the
+// file alone, and sparse image dumps.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <sys/stat.h>
+
+using namespace bench;
+
+static vector<uint8_t> readFile(const string& path) {
+    ifstream in(path, ios::binary);
+    return vector<uint8_t>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static string readText(const string& path) {
+    ifstream in(path);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static void testConversion(const string& dir) {
+    check(convertTextImage(dir + "/imem.txt", dir + "/imem.bin") &&
+              convertTextImage(dir + "/dmem.txt", dir + "/dmem.bin"),
+          "text images convert");
+    vector<uint8_t> data = readFile(dir + "/dmem.bin");
+    check(data.size() == MemSize && data[2] == 0x4E && data[3] == 0x20, "a binary image holds one byte per line");
+
+    InsMem text("Imem", dir), binary("Imem", dir, true);
+    bool same = true;
+    for (uint32_t addr = 0; addr < MemSize; addr += 4) same &= text.readWord(addr) == binary.readWord(addr);
+    check(same, "imem.bin loads the same program as imem.txt");
+}
+
+static void testMappedDataMem(const string& dir) {
+    InsMem imem("Imem", dir);
+    vector<uint8_t> before = readFile(dir + "/dmem.bin");
+
+    DataMem textMem("SS", dir), imageMem("SS", dir, true);
+    check(imageMem.contents().firstDifference(textMem.contents()) == -1, "dmem.bin maps the contents of dmem.txt");
+
+    SingleStageCoreT<NullTracer, BasicStats, DirectMemory> a(dir, imem, textMem), b(dir, imem, imageMem);
+    a.runUntil(StopCondition());
+    b.runUntil(StopCondition());
+    check(imageMem.readWord(8) == textMem.readWord(8) && imageMem.readWord(8) != 0,
+          "a core runs on a mapped image");
+    check(readFile(dir + "/dmem.bin") == before, "stores never reach the image file");
+
+    DataMem copy(imageMem);
+    copy.writeWord(8, 0);
+    check(imageMem.readWord(8) == textMem.readWord(8), "a copy of a mapped memory is independent");
+
+    textMem.outputDataMem(dir + "/text");
+    imageMem.outputDataMem(dir + "/image");
+    check(readText(dir + "/text/SS_DMEMResult.txt") == readText(dir + "/image/SS_DMEMResult.txt"),
+          "text dumps of both memories match");
+
+    imageMem.outputDataImage(dir + "/image");
+    vector<uint8_t> after = readFile(dir + "/image/SS_DMEMResult.bin");
+    check(after.size() == before.size() && loadBigEndian32(&after[8]) == textMem.readWord(8),
+          "the image dump holds the final memory");
+}
+
+static void testSparseDump(const string& dir) {
+    PagedMemory mem;
+    mem.writeWord(0, 0x01020304);
+    mem.writeWord(0x00400000, 0xA0B0C0D0);
+    mem.writeWord(0x00400FFE, 0x11223344);  // spills into the next page
+    string path = dir + "/sparse.bin";
+    check(mem.writeImage(path), "a sparse memory dumps");
+    struct stat st;
+    stat(path.c_str(), &st);
+    check(st.st_size == 0x00402000, "the dump ends with the last mapped page");
+    vector<uint8_t> data = readFile(path);
+    check(loadBigEndian32(&data[0]) == 0x01020304 && loadBigEndian32(&data[0x00400000]) == 0xA0B0C0D0 &&
+              loadBigEndian32(&data[0x00400FFE]) == 0x11223344 && data[0x200000] == 0,
+          "pages land at their addresses, holes read as zero");
+
+    // a store past the end of the image, still inside its last page
+    writeBytes(dir + "/short.bin.txt", {0x0A0B0C0D});
+    convertTextImage(dir + "/short.bin.txt", dir + "/short.bin");
+    PagedMemory image;
+    image.attachImage(make_shared<MappedImage>(dir + "/short.bin"));
+    check(image.readWord(0) == 0x0A0B0C0D && image.readWord(4) == 0, "a short image reads as zero past its end");
+    image.writeImage(path);
+    check(readFile(path).size() == 4, "an untouched image dumps at its own size");
+    image.writeWord(100, 0xFF);
+    image.writeImage(path);
+    data = readFile(path);
+    check(data.size() == 104 && data[103] == 0xFF, "stores past the image end extend the dump");
+}
+
+int main() {
+    string dir = makeLoopProgram("test/test_data/memory_image", 20000);
+    testConversion(dir);
+    testMappedDataMem(dir);
+    testSparseDump(dir);
+    return checkSummary();
+}
@@ -0,0 +1,261 @@
+// PagedMemory and DataMem over the full 32-bit address space: sparse
+// mapping, words across pages and around the top, copies, dump ranges,
+// dirty tracking, copy-on-write sharing, and both cores storing far above
+// the old 1000-byte memory.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <thread>
+
+using namespace bench;
+
+static vector<string> readLines(const string& path) {
+    ifstream in(path);
+    vector<string> lines;
+    string line;
+    while (getline(in, line)) lines.push_back(line);
+    return lines;
+}
+
+static void testPagedMemory() {
+    PagedMemory mem;
+    check(mem.readWord(0x12345678) == 0 && mem.readByte(0xFFFFFFFF) == 0 && mem.mappedPages() == 0,
+          "unmapped memory reads as zero without mapping pages");
+
+    mem.writeWord(0x80000000, 0xDEADBEEF);
+    check(mem.readWord(0x80000000) == 0xDEADBEEF && mem.readByte(0x80000000) == 0xDE && mem.mappedPages() == 1,
+          "a store maps one page, big-endian");
+
+    mem.writeWord(PagedMemory::PageSize - 2, 0x01020304);
+    check(mem.readWord(PagedMemory::PageSize - 2) == 0x01020304 && mem.readByte(PagedMemory::PageSize) == 0x03 &&
+              mem.mappedPages() == 3,
+          "a word across a page boundary");
+
+    mem.writeWord(0xFFFFFFFE, 0xA1B2C3D4);
+    check(mem.readByte(0xFFFFFFFF) == 0xB2 && mem.readByte(0) == 0xC3 && mem.readWord(0xFFFFFFFE) == 0xA1B2C3D4,
+          "a word wraps around the top of the address space");
+
+    // alternate pages so every access misses the TLB
+    for (uint32_t i = 0; i < 64; i++) mem.writeWord((i % 2 ? 0x40000000 : 0x7000) + 4 * i, i);
+    bool all = true;
+    for (uint32_t i = 0; i < 64; i++) all &= mem.readWord((i % 2 ? 0x40000000 : 0x7000) + 4 * i) == i;
+    check(all, "accesses alternating between pages");
+
+    PagedMemory copy(mem);
+    check(copy.firstDifference(mem) == -1 && copy.mappedPages() == mem.mappedPages(), "a copy has the same contents");
+    copy.writeWord(0x80000004, 7);
+    check(mem.readWord(0x80000004) == 0 && copy.firstDifference(mem) == 0x80000007,
+          "stores to a copy leave the original alone");
+    PagedMemory empty;
+    empty.writeWord(0x90000000, 0);
+    check(empty.firstDifference(PagedMemory()) == -1, "a mapped page of zeros equals an unmapped one");
+}
+
+static bool sameRanges(const vector<MemRange>& a, const vector<MemRange>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].lo != b[i].lo || a[i].hi != b[i].hi) return false;
+    }
+    return true;
+}
+
+static void testDirtyTracking() {
+    PagedMemory mem;
+    mem.writeWord(0x103E, 1);  // lines 0 and 1 of page 1
+    mem.writeByte(0x2FFF, 1);
+    check(sameRanges(mem.dirtyRanges(), {{0x1000, 0x3000}}), "dirty pages coalesce");
+    check(sameRanges(mem.dirtyRanges(true), {{0x1000, 0x1080}, {0x2FC0, 0x3000}}), "a word marks the lines it spans");
+
+    mem.clearDirty();
+    check(mem.dirtyRanges().empty() && mem.dirtyPageCount() == 0, "clearDirty empties the list");
+    mem.readWord(0x1000);  // the TLB holds the clean page
+    mem.writeWord(0x1100, 2);
+    mem.writeWord(0x1104, 3);
+    check(sameRanges(mem.dirtyRanges(true), {{0x1100, 0x1140}}), "the first store after a clear marks the page");
+
+    PagedMemory copy(mem);
+    check(copy.firstDirtyDifference(mem) == -1, "a copy has no dirty difference");
+    copy.writeWord(0x80000000, 9);
+    mem.writeWord(0x1200, 4);
+    check(copy.firstDirtyDifference(mem) == 0x1203 && copy.firstDifference(mem) == 0x1203,
+          "dirty comparison finds the first difference");
+    mem.writeWord(0x1200, 0);
+    check(copy.firstDirtyDifference(mem) == 0x80000003, "stores to either side are compared");
+
+    string dir = "test/test_data/paged_memory";
+    std::filesystem::create_directories(dir);
+    mem.writeImage(dir + "/full.bin");
+    mem.clearDirty();
+    mem.writeWord(0x1000, 0x12345678);
+    mem.writeWord(0x5000, 0x9ABCDEF0);
+    mem.writeImage(dir + "/full.bin", true);
+    mem.writeImage(dir + "/fresh.bin");
+    ifstream a(dir + "/full.bin", ios::binary), b(dir + "/fresh.bin", ios::binary);
+    check(string(istreambuf_iterator<char>(a), {}) == string(istreambuf_iterator<char>(b), {}),
+          "a dirty-only dump brings the last dump up to date");
+}
+
+static void testCopyOnWrite() {
+    PagedMemory base;
+    for (uint32_t page = 0; page < 256; page++) base.writeWord(page << PagedMemory::PageBits, page);
+    PagedMemory copy(base);
+    check(base.privatePages() == 0 && copy.privatePages() == 0 && copy.mappedPages() == 256,
+          "a copy shares every page");
+
+    copy.writeWord(4, 1);
+    check(copy.readWord(4) == 1 && base.readWord(4) == 0 && copy.privatePages() == 1 && base.privatePages() == 1,
+          "the first store copies one page");
+
+    // base's TLB held page 255 for writes before the copy
+    PagedMemory late(base);
+    base.writeWord(255 << PagedMemory::PageBits, 7);
+    check(late.readWord(255 << PagedMemory::PageBits) == 255, "the original copies too after being copied");
+
+    // many runs from one base cost what they write
+    vector<PagedMemory> runs(64, base);
+    for (size_t i = 0; i < runs.size(); i++) runs[i].writeWord((uint32_t)(i % 4) << PagedMemory::PageBits, (uint32_t)i);
+    size_t privatePages = 0;
+    bool own = true;
+    for (size_t i = 0; i < runs.size(); i++) {
+        privatePages += runs[i].privatePages();
+        own &= runs[i].readWord((uint32_t)(i % 4) << PagedMemory::PageBits) == i;
+    }
+    check(own && privatePages == runs.size(), "64 runs from one base hold one private page each");
+
+    // copies on threads
+    vector<PagedMemory> mems(4, base);
+    vector<std::thread> threads;
+    vector<bool> ok(mems.size());
+    for (size_t t = 0; t < mems.size(); t++) {
+        threads.emplace_back([&, t] {
+            bool good = true;
+            for (uint32_t round = 0; round < 200; round++) {
+                for (uint32_t page = 0; page < 256; page += 3) {
+                    uint32_t addr = page << PagedMemory::PageBits | 8;
+                    mems[t].writeWord(addr, (uint32_t)t * 1000 + round);
+                    good &= mems[t].readWord(addr) == t * 1000 + round &&
+                            mems[t].readWord(page << PagedMemory::PageBits) == (page == 255 ? 7u : page);
+                }
+            }
+            ok[t] = good;
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    bool all = true;
+    for (bool b : ok) all &= b;
+    for (uint32_t page = 0; page < 256; page++) all &= base.readWord(page << PagedMemory::PageBits | 8) == 0;
+    check(all, "copies store on different threads without seeing each other");
+}
+
+static void testDataMem() {
+    string dir = "test/test_data/paged_memory";
+    std::filesystem::create_directories(dir);
+    // an image larger than the old MemSize limit
+    vector<uint32_t> data(1500);
+    for (uint32_t i = 0; i < data.size(); i++) data[i] = i;
+    writeBytes(dir + "/dmem.txt", data);
+
+    DataMem mem("SS", dir);
+    check(mem.readWord(4 * 1499) == 1499, "dmem.txt loads past the first 1000 bytes");
+    check(mem.dirtyRanges().empty(), "loading leaves the memory clean");
+
+    mem.outputDataMem(dir);
+    vector<string> lines = readLines(dir + "/SS_DMEMResult.txt");
+    check(lines.size() == MemSize && lines[7] == "00000001", "the dump defaults to the first MemSize bytes");
+
+    mem.writeWord(0xC0000000, 0x55AA00FF);
+    mem.setDumpRanges({{0xC0000000, 0xC0000004}, {4, 6}});
+    mem.outputDataMem(dir);
+    lines = readLines(dir + "/SS_DMEMResult.txt");
+    check(lines == vector<string>({"01010101", "10101010", "00000000", "11111111", "00000000", "00000000"}),
+          "dump ranges are written in order");
+
+    DataMem copy(mem);
+    copy.outputDataMem(dir);
+    check(readLines(dir + "/SS_DMEMResult.txt") == lines, "copies keep the dump ranges");
+
+    DataMem fs("FS", mem);
+    fs.writeWord(0xC0000000, 0);
+    fs.outputDataMem(dir);
+    check(readLines(dir + "/FS_DMEMResult.txt")[0] == "00000000" && mem.readWord(0xC0000000) == 0x55AA00FF,
+          "a named copy dumps under its own name");
+}
+
+// Stores the dmem word at 0 at 0xFFFFFFFC, across pages 0 and 1, and 2 MiB
+// up, and loads each back into R3, R7 and R8
+static string makeFarProgram() {
+    string dir = "test/test_data/paged_far";
+    std::filesystem::create_directories(dir);
+    vector<uint32_t> prog = {
+        encI(0, 0, 2, 2, 0x03),         // LW   R2, R0, #0
+        encI(-4, 0, 0, 1, 0x13),        // ADDI R1, R0, #-4
+        encS(0, 2, 1),                  // SW   R2, R1, #0
+        encI(0, 1, 2, 3, 0x03),         // LW   R3, R1, #0
+        encI(2047, 0, 0, 6, 0x13),      // ADDI R6, R0, #2047
+        encR(0, 6, 6, 0, 6),            // ADD  R6, R6, R6     4094
+        encS(0, 2, 6),                  // SW   R2, R6, #0
+        encI(0, 6, 2, 7, 0x03),         // LW   R7, R6, #0
+        encI(2047, 0, 0, 5, 0x13),      // ADDI R5, R0, #2047
+    };
+    for (int i = 0; i < 10; i++) prog.push_back(encR(0, 5, 5, 0, 5));  // ADD R5, R5, R5
+    prog.push_back(encS(0, 2, 5));      // SW   R2, R5, #0
+    prog.push_back(encI(0, 5, 2, 8, 0x03));  // LW R8, R5, #0
+    prog.push_back(HALT);
+    writeBytes(dir + "/imem.txt", prog);
+    writeBytes(dir + "/dmem.txt", {0xCAFEF00D});
+    return dir;
+}
+
+static bool farStoresDone(RegisterFile& rf, const DataMem& mem) {
+    const uint32_t v = 0xCAFEF00D;
+    return rf.readReg(3) == v && rf.readReg(7) == v && rf.readReg(8) == v && mem.readWord(0xFFFFFFFC) == v &&
+           mem.readWord(4094) == v && mem.readWord(2047 << 10) == v && mem.contents().mappedPages() == 4;
+}
+
+static void testCores() {
+    string dir = makeFarProgram();
+    InsMem imem("Imem", dir);
+
+    DataMem ssMem("SS", dir);
+    SingleStageCoreT<NullTracer, BasicStats, DirectMemory> ss(dir, imem, ssMem);
+    ss.runUntil(StopCondition());
+    check(ss.halted && farStoresDone(ss.myRF, ssMem), "single stage stores and loads far addresses");
+    check(sameRanges(ssMem.dirtyRanges(true), {{4032, 4160}, {2047 << 10, (2047 << 10) + 64},
+                                               {0xFFFFFFC0, 0x100000000}}),
+          "the core's stores are the dirty lines");
+
+    DataMem fsMem("FS", dir);
+    FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards> fs(dir, imem, fsMem);
+    fs.runUntil(StopCondition());
+    check(fs.halted && farStoresDone(fs.getRegisterFile(), fsMem), "five stage stores and loads far addresses");
+
+    DataMem jitMem("SS", dir);
+    SingleStageCoreT<NullTracer, BasicStats, DirectMemory> jit(dir, imem, jitMem);
+    while (!jit.halted) jit.runJit(UINT64_MAX);
+    check(farStoresDone(jit.myRF, jitMem), "the JIT stores and loads far addresses");
+
+    // a word at 0xFFFFFFFE runs past the top
+    string wrapDir = "test/test_data/paged_wrap";
+    std::filesystem::create_directories(wrapDir);
+    writeBytes(wrapDir + "/imem.txt", {encI(-2, 0, 0, 1, 0x13), encI(0, 1, 2, 2, 0x03), HALT});
+    writeBytes(wrapDir + "/dmem.txt", {0});
+    InsMem wrapImem("Imem", wrapDir);
+    DataMem wrapMem("SS", wrapDir);
+    SingleStageCoreT<NullTracer, NullStats, CheckedMemory> checked(wrapDir, wrapImem, wrapMem);
+    bool thrown = false;
+    try {
+        checked.runUntil(StopCondition());
+    } catch (const out_of_range&) {
+        thrown = true;
+    }
+    check(thrown, "CheckedMemory rejects a word wrapping around the top");
+}
+
+int main() {
+    testPagedMemory();
+    testDirtyTracking();
+    testCopyOnWrite();
+    testDataMem();
+    testCores();
+    return checkSummary();
+}
@@ -0,0 +1,146 @@
+// Policy configurations of SingleStageCoreT/FiveStageCoreT: every entry of
+// SS_CORE_CONFIGS and FS_CORE_CONFIGS ends in the same registers and memory
+// as the graded core, the final-state tracer writes the graded core's last
+// record, and CheckedMemory rejects a word past the top of memory.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <stdexcept>
+
+using namespace bench;
+
+struct FinalState {
+    uint32_t regs[32];
+    vector<uint32_t> words;  // the first MemSize bytes of data memory
+    bool halted;
+
+    bool operator==(const FinalState& o) const {
+        return memcmp(regs, o.regs, sizeof(regs)) == 0 && words == o.words && halted == o.halted;
+    }
+};
+
+static FinalState capture(RegisterFile& rf, const DataMem& mem, bool halted) {
+    FinalState s;
+    memcpy(s.regs, rf.values(), sizeof(s.regs));
+    for (uint32_t addr = 0; addr < MemSize; addr += 4) s.words.push_back(mem.readWord(addr));
+    s.halted = halted;
+    return s;
+}
+
+static string readText(const string& path) {
+    ifstream in(path);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static bool endsWith(const string& text, const string& tail) {
+    return !tail.empty() && text.size() >= tail.size() &&
+           text.compare(text.size() - tail.size(), tail.size(), tail) == 0;
+}
+
+template <class CoreType>
+static FinalState runSingleStage(const string& dir, const InsMem& imem, const string& out) {
+    DataMem mem("SS", dir);
+    CoreType core(dir, imem, mem);
+    core.setOutputDirectory(out);
+    // a queue the whole loop's commits fit into, nobody reads it
+    SpscQueue<CommitRecord> commits(12);
+    if constexpr (std::is_same<std::decay_t<decltype(core.getStats())>, QueueStats>::value)
+        core.getStats().queue = &commits;
+    core.runUntil(StopCondition());
+    return capture(core.myRF, mem, core.halted);
+}
+
+template <class CoreType>
+static FinalState runFiveStage(const string& dir, const InsMem& imem, const string& out) {
+    DataMem mem("FS", dir);
+    CoreType core(dir, imem, mem);
+    core.setOutputDirectory(out);
+    core.runUntil(StopCondition());
+    return capture(core.getRegisterFile(), mem, core.halted);
+}
+
+static string name(const char* t, const char* s, const char* m) {
+    return string(t) + "/" + s + "/" + m;
+}
+
+static void testSingleStage(const string& dir, const InsMem& imem) {
+    FinalState graded = runSingleStage<SingleStageCore>(dir, imem, dir + "/ss_graded");
+#define CHECK_SS(T, S, M) \
+    check(runSingleStage<SingleStageCoreT<T, S, M>>(dir, imem, dir + "/ss_other") == graded, \
+          "single stage " + name(#T, #S, #M) + " ends in the graded state");
+    SS_CORE_CONFIGS(CHECK_SS)
+#undef CHECK_SS
+}
+
+static void testFiveStage(const string& dir, const InsMem& imem) {
+    FinalState graded = runFiveStage<FiveStageCore>(dir, imem, dir + "/fs_graded");
+#define CHECK_FS(T, S, M, H) \
+    check(runFiveStage<FiveStageCoreT<T, S, M, H>>(dir, imem, dir + "/fs_other") == graded, \
+          "five stage " + name(#T, #S, #M) + "/" #H " ends in the graded state");
+    FS_CORE_CONFIGS(CHECK_FS)
+#undef CHECK_FS
+
+    // fs_other was last written by an untraced core, so this run's files
+    // hold nothing but the final-state tracer's record
+    runFiveStage<FiveStageCoreT<FinalTracer, BasicStats, DirectMemory, ForwardingHazards>>(dir, imem,
+                                                                                         dir + "/fs_final");
+    string state = readText(dir + "/fs_graded/StateResult_FS.txt");
+    string last = readText(dir + "/fs_final/StateResult_FS.txt");
+    const string header = "State after executing cycle: ";
+    check(endsWith(state, last) && last.find(header) == last.rfind(header),
+          "five stage final-state tracer writes the graded last state record");
+    check(endsWith(readText(dir + "/fs_graded/FS_RFResult.txt"), readText(dir + "/fs_final/FS_RFResult.txt")),
+          "five stage final-state tracer writes the graded last RF record");
+}
+
+static void testStats(const string& dir, const InsMem& imem) {
+    DataMem basicMem("SS", dir), detailedMem("SS", dir), nullMem("SS", dir);
+    SingleStageCoreT<NullTracer, BasicStats, DirectMemory> basic(dir, imem, basicMem);
+    SingleStageCoreT<NullTracer, DetailedStats, DirectMemory> detailed(dir, imem, detailedMem);
+    SingleStageCoreT<NullTracer, NullStats, DirectMemory> none(dir, imem, nullMem);
+    basic.runUntil(StopCondition());
+    detailed.runUntil(StopCondition());
+    none.runUntil(StopCondition());
+    uint64_t mix = 0;
+    for (uint64_t n : detailed.getStats().opCounts) mix += n;
+    check(detailed.getInstructionCount() == basic.getInstructionCount() && mix == basic.getInstructionCount(),
+          "detailed statistics count the same instructions as the basic ones");
+    check(none.getInstructionCount() == 0 && none.cycle == basic.cycle,
+          "null statistics count nothing and change no timing");
+}
+
+static void testCheckedMemory() {
+    string dir = "test/test_data/policies_top";
+    std::filesystem::create_directories(dir);
+    // store to -2: the word would run past the top of memory
+    writeBytes(dir + "/imem.txt", {encI(-2, 0, 0, 1, 0x13), encS(0, 1, 1), HALT});
+    writeBytes(dir + "/dmem.txt", {0});
+    InsMem imem("Imem", dir);
+
+    DataMem checkedMem("SS", dir);
+    SingleStageCoreT<NullTracer, NullStats, CheckedMemory> checked(dir, imem, checkedMem);
+    bool threw = false;
+    try {
+        checked.runUntil(StopCondition());
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    check(threw, "checked memory rejects a store past the top of memory");
+
+    DataMem directMem("SS", dir);
+    SingleStageCoreT<NullTracer, NullStats, DirectMemory> direct(dir, imem, directMem);
+    direct.runUntil(StopCondition());
+    check(direct.halted && directMem.readByte(0xFFFFFFFE) == 0xFF, "direct memory wraps the same store");
+}
+
+int main() {
+    string dir = makeLoopProgram("test/test_data/policies", 40);
+    InsMem imem("Imem", dir);
+
+    testSingleStage(dir, imem);
+    testFiveStage(dir, imem);
+    testStats(dir, imem);
+    testCheckedMemory();
+
+    return checkSummary();
+}
@@ -0,0 +1,40 @@
+// DecodedProgram: InsMem predecodes every aligned word once, the records
+// match decoding the word at its PC, PCs outside the image stop the core
+// like HALT, and both cores run from the InsMem's one copy.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+
+using namespace bench;
+
+static bool sameRecord(const DecodedInstr& a, const DecodedInstr& b) {
+    return a.raw == b.raw && a.target == b.target && a.imm == b.imm && a.op == b.op && a.rd == b.rd &&
+           a.rs1 == b.rs1 && a.rs2 == b.rs2 && a.alu == b.alu && a.cond == b.cond && a.flags == b.flags;
+}
+
+int main() {
+    string dir = makeLoopProgram("test/test_data/predecode", 20);
+    InsMem imem("Imem", dir);
+    const DecodedProgram& program = imem.getProgram();
+
+    check(program.size() == imem.debugGetMemorySize() / 4, "one record per instruction word");
+    bool same = true;
+    for (uint32_t pc = 0; pc < program.size() * 4; pc += 4)
+        same &= sameRecord(program.at(pc), decodeInstr(imem.readWord(pc), pc));
+    check(same, "every record matches decoding its word at its PC");
+    check(program.at(40).op == Op::BNE && program.at(40).target == 8, "branch targets are resolved at load time");
+    check(program.at(2).op == Op::HALT && program.at((uint32_t)program.size() * 4).op == Op::HALT,
+          "misaligned PCs and PCs past the image decode as HALT");
+
+    // both cores read the shared records rather than a copy of their own
+    DataMem ssMem("SS", dir), fsMem("FS", dir);
+    SingleStageCoreT<NullTracer, BasicStats, DirectMemory> ss(dir, imem, ssMem);
+    FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards> fs(dir, imem, fsMem);
+    check(&ss.program == &program, "the single stage core uses the InsMem's program");
+    ss.runUntil(StopCondition());
+    fs.runUntil(StopCondition());
+    check(ss.getInstructionCount() == 3 + 8 * 20 && fs.getInstructionCount() == ss.getInstructionCount(),
+          "both cores retire the loop's instructions from the predecoded program");
+
+    return checkSummary();
+}
@@ -0,0 +1,68 @@
+// Core::runUntil / FiveStageCoreT::runUntil: every stop condition, and
+// chunked runs ending in the same architectural state as one full run.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+
+static bool sameRegisters(RegisterFile& a, RegisterFile& b) {
+    for (uint32_t r = 0; r < 32; r++) {
+        if (a.readReg(r) != b.readReg(r)) return false;
+    }
+    return true;
+}
+
+// the single stage core exposes its register file as Core::myRF
+static RegisterFile& registersOf(Core& core) { return core.myRF; }
+template <class CoreType>
+static auto registersOf(CoreType& core) -> decltype(core.getRegisterFile()) { return core.getRegisterFile(); }
+
+template <class CoreType>
+static void testCore(const char* name, const string& dir) {
+    string n = name;
+    InsMem imem("Imem", dir);
+
+    // reference: one call to completion
+    DataMem fullMem("FS", dir);
+    CoreType full(dir, imem, fullMem);
+    RunResult all = full.runUntil(StopCondition());
+    check(all.reason == StopReason::Halted && full.halted, n + ": full run halts");
+    check(all.instructions == full.getInstructionCount(), n + ": full run counts every instruction");
+
+    // cycle limit
+    DataMem mem("FS", dir);
+    CoreType core(dir, imem, mem);
+    RunResult r = core.runUntil(StopCondition::cycles(10));
+    check(r.reason == StopReason::CycleLimit && r.cycles == 10, n + ": stops after 10 cycles");
+
+    // instruction limit
+    r = core.runUntil(StopCondition::instructions(25));
+    check(r.reason == StopReason::InstructionLimit && r.instructions == 25, n + ": stops after 25 instructions");
+
+    // PC match: the loop head comes round once per trip
+    r = core.runUntil(StopCondition::atPC(8));
+    check(r.reason == StopReason::PCMatch, n + ": stops at the loop head");
+    uint64_t before = core.getInstructionCount();
+    r = core.runUntil(StopCondition::atPC(8));
+    check(r.reason == StopReason::PCMatch && core.getInstructionCount() - before == 8,
+          n + ": next visit of the loop head is one trip (8 instructions) later");
+
+    // memory write: the loop stores to address 8 every trip
+    r = core.runUntil(StopCondition::onWrite(8, 12));
+    check(r.reason == StopReason::MemoryWrite && mem.readWord(8) != 0, n + ": stops on the store to 8");
+    r = core.runUntil(StopCondition::onWrite(100, 104));
+    check(r.reason == StopReason::Halted, n + ": no store to 100, runs to halt");
+
+    check(sameRegisters(registersOf(core), registersOf(full)), n + ": chunked run ends with the full run's registers");
+    check(core.getInstructionCount() == full.getInstructionCount(), n + ": chunked run retires the same instructions");
+    r = core.runUntil(StopCondition());
+    check(r.reason == StopReason::Halted && r.cycles == 0, n + ": halted core does not step");
+}
+
+int main() {
+    string dir = bench::makeLoopProgram("test/test_data/run_until", 50);
+
+    testCore<SingleStageCoreT<NullTracer, BasicStats, DirectMemory>>("single stage", dir);
+    testCore<FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>>("five stage", dir);
+
+    return checkSummary();
+}
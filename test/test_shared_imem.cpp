@@ -0,0 +1,58 @@
+// One read-only InsMem shared by single and five stage cores running on
+// separate threads, as sim.cpp runs them, against sequential runs.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <thread>
+
+using SSCore = SingleStageCoreT<NullTracer, BasicStats, DirectMemory>;
+using FSCore = FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>;
+
+// Final registers, the loop's memory word and the counters of one run
+static vector<uint64_t> outcome(RegisterFile& rf, const DataMem& dmem, uint64_t instructions, uint64_t cycles) {
+    vector<uint64_t> o;
+    for (uint32_t r = 0; r < 32; r++) o.push_back(rf.readReg(r));
+    o.push_back(dmem.readWord(8));
+    o.push_back(instructions);
+    o.push_back(cycles);
+    return o;
+}
+
+static vector<uint64_t> runSingleStage(const string& dir, const InsMem& imem) {
+    DataMem dmem("SS", dir);
+    SSCore core(dir, imem, dmem);
+    while (!core.halted) core.runThreaded(UINT64_MAX);
+    core.runUntil(StopCondition());
+    return outcome(core.myRF, dmem, core.getInstructionCount(), core.cycle);
+}
+
+static vector<uint64_t> runFiveStage(const string& dir, const InsMem& imem) {
+    DataMem dmem("FS", dir);
+    FSCore core(dir, imem, dmem);
+    core.runUntil(StopCondition());
+    return outcome(core.getRegisterFile(), dmem, core.getInstructionCount(), core.getCycle());
+}
+
+int main() {
+    string dir = bench::makeLoopProgram("test/test_data/shared_imem", 20000);
+    const InsMem imem("Imem", dir);
+    vector<uint64_t> ss = runSingleStage(dir, imem);
+    vector<uint64_t> fs = runFiveStage(dir, imem);
+
+    // four models of each kind at once
+    const int pairs = 4;
+    vector<vector<uint64_t>> results(2 * pairs);
+    vector<std::thread> threads;
+    for (int i = 0; i < pairs; i++) {
+        threads.emplace_back([&, i] { results[2 * i] = runSingleStage(dir, imem); });
+        threads.emplace_back([&, i] { results[2 * i + 1] = runFiveStage(dir, imem); });
+    }
+    for (std::thread& t : threads) t.join();
+
+    bool same = true;
+    for (int i = 0; i < pairs; i++) same = same && results[2 * i] == ss && results[2 * i + 1] == fs;
+    check(same, to_string(2 * pairs) + " concurrent cores match their sequential runs");
+    check(ss[32] == fs[32] && ss[3] == fs[3], "single and five stage agree on the loop result");
+
+    return checkSummary();
+}
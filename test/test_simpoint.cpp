@@ -0,0 +1,142 @@
+// Basic block vector profiling, clustering and the SimPoint estimate of a
+// program with distinct phases against its full detailed simulation: warmed
+// windows plus the drain give the full run's cycles, a single interval is
+// simulated whole, and the difference from an exact interval model is the
+// estimate's real error.
+#include "simpoint.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <cmath>
+
+using namespace bench;
+using DetailedCore = FiveStageCoreT<NullTracer, BasicStats, DirectMemory, ForwardingHazards>;
+
+// A load-use heavy loop, a stall-free loop, then the first one again
+static string makePhaseProgram(const string& dir, uint32_t trips) {
+    std::filesystem::create_directories(dir);
+    vector<uint32_t> prog = {
+        encI(0, 0, 2, 1, 0x03),        // 0:  LW   R1, R0, #0     trip count
+        encI(0, 0, 0, 2, 0x13),        // 4:  ADDI R2, R0, #0
+        encI(1, 2, 0, 2, 0x13),        // 8:  ADDI R2, R2, #1     phase A
+        encI(8, 0, 2, 3, 0x03),        // 12: LW   R3, R0, #8
+        encR(0, 2, 3, 0, 4),           // 16: ADD  R4, R3, R2     load-use
+        encS(8, 4, 0),                 // 20: SW   R4, R0, #8
+        encB(-16, 1, 2, 1),            // 24: BNE  R2, R1, #-16
+        encI(0, 0, 0, 5, 0x13),        // 28: ADDI R5, R0, #0
+        encI(1, 5, 0, 5, 0x13),        // 32: ADDI R5, R5, #1     phase B
+        encR(0, 5, 6, 4, 6),           // 36: XOR  R6, R6, R5
+        encR(0, 6, 7, 0, 7),           // 40: ADD  R7, R7, R6
+        encB(-12, 1, 5, 1),            // 44: BNE  R5, R1, #-12
+        encI(1, 8, 0, 8, 0x13),        // 48: ADDI R8, R8, #1
+        encI(2, 0, 0, 9, 0x13),        // 52: ADDI R9, R0, #2
+        encB(-52, 9, 8, 1),            // 56: BNE  R8, R9, #-52   phase A again
+        HALT                           // 60: HALT
+    };
+    writeBytes(dir + "/imem.txt", prog);
+    vector<uint32_t> data(MemSize / 4, 0);
+    data[0] = trips;
+    writeBytes(dir + "/dmem.txt", data);
+    return dir;
+}
+
+static void testProfile(const string& dir) {
+    InsMem imem("Imem", dir);
+    DataMem mem("FS", dir);
+    ProfileCore core(dir, imem, mem);
+    core.getStats().profile = BbvProfiler(1000);
+    core.runBlocks(UINT64_MAX);
+    core.runUntil(StopCondition());
+    BbvProfiler& profile = core.getStats().profile;
+    profile.finish();
+
+    uint64_t instructions = 0, cycles = 0;
+    bool contiguous = true, counted = true;
+    for (const BbvInterval& interval : profile.intervals()) {
+        contiguous &= interval.start == instructions;
+        uint64_t sum = 0;
+        for (const auto& block : interval.blocks) sum += block.second;
+        counted &= sum == interval.instructions;
+        instructions += interval.instructions;
+        cycles += interval.cycles;
+    }
+    check(contiguous && counted && instructions == core.getInstructionCount(),
+          "intervals cover every instruction once, " + to_string(profile.intervals().size()) + " intervals");
+    check(cycles == profile.model().cycles(), "interval cycle estimates add up to the model's total");
+    // 0, both loop heads, both loop exits, the outer loop head and HALT
+    check(profile.blockCount() == 7, "7 distinct entry PCs, got " + to_string(profile.blockCount()));
+}
+
+static void testClustering() {
+    // two tight groups of points
+    vector<vector<double>> points;
+    for (int i = 0; i < 20; i++) points.push_back({(i % 2 ? 5.0 : 0.0) + i * 0.001, 1.0});
+    vector<uint32_t> labels = clusterPoints(points, 10, 1);
+    bool split = true;
+    for (int i = 0; i < 20; i++) split &= (labels[i] == labels[0]) == (i % 2 == 0);
+    check(split, "two groups become two clusters");
+
+    vector<vector<double>> same(8, vector<double>{1.0, 2.0});
+    labels = clusterPoints(same, 10, 1);
+    check(*max_element(labels.begin(), labels.end()) == 0, "identical points form one cluster");
+}
+
+static SimPointResult sample(const string& dir, const InsMem& imem, DataMem& mem, uint64_t intervalSize) {
+    SimPointOptions opts;
+    opts.intervalSize = intervalSize;
+    return runSimPoints(dir, imem, mem, opts);
+}
+
+static void testEstimate(const string& dir) {
+    InsMem imem("Imem", dir);
+    DataMem refMem("FS", dir);
+    DetailedCore ref(dir, imem, refMem);
+    ref.runUntil(StopCondition());
+    uint64_t refCycles = ref.getCycle();
+
+    DataMem mem("FS", dir);
+    SimPointResult sampled = sample(dir, imem, mem, 1000);
+    double weights = 0;
+    for (const SimPoint& p : sampled.points) weights += p.weight;
+    check(fabs(weights - 1) < 1e-9 && sampled.points.size() >= 2,
+          to_string(sampled.points.size()) + " simulation points, weights sum to 1");
+    check(sampled.instructions == ref.getInstructionCount(), "instruction count of the whole program");
+    check(sampled.modelCycles == refCycles, "the interval model is exact on this program");
+    check(sampled.cycles() == refCycles && sampled.drainCycles > 0,
+          "warmed windows plus a drain of " + to_string(sampled.drainCycles) + " give " + to_string(sampled.cycles()) + " cycles, detailed " +
+              to_string(refCycles));
+
+    bool sameMemory = true;
+    for (uint32_t addr = 0; addr < MemSize; addr += 4) sameMemory &= mem.readWord(addr) == refMem.readWord(addr);
+    check(sameMemory, "final memory of the functional pass");
+
+    // intervals too short to represent each other
+    DataMem shortMem("FS", dir);
+    SimPointResult coarse = sample(dir, imem, shortMem, 50);
+    double error = 100.0 * fabs((double)coarse.cycles() - refCycles) / refCycles;
+    check(error > 0 && error < 1 && fabs(coarse.modelDifference() - error) < 1e-9,
+          "50-instruction intervals: error " + to_string(error) + "%, difference from the interval model " +
+              to_string(coarse.modelDifference()) + "%");
+}
+
+// A program shorter than one interval is its own only representative
+static void testSingleInterval() {
+    string dir = makePhaseProgram("test/test_data/simpoint_short", 30);
+    InsMem imem("Imem", dir);
+    DataMem refMem("FS", dir), mem("FS", dir);
+    DetailedCore ref(dir, imem, refMem);
+    ref.runUntil(StopCondition());
+    SimPointResult sampled = sample(dir, imem, mem, 1000000);
+    check(sampled.points.size() == 1 && sampled.cycles() == (uint64_t)ref.getCycle(),
+          "a single interval is simulated whole, " + to_string(sampled.cycles()) + " cycles, detailed " +
+              to_string(ref.getCycle()));
+}
+
+int main() {
+    string dir = makePhaseProgram("test/test_data/simpoint_phases", 4000);
+    testProfile(dir);
+    testClustering();
+    testEstimate(dir);
+    testSingleInterval();
+
+    return checkSummary();
+}
@@ -0,0 +1,67 @@
+// SingleStageCoreT::runThreaded against step(): same registers, memory,
+// cycle and instruction counts whatever the chunk size, and byte-identical
+// trace files, on a program using every operation.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+
+using namespace bench;
+
+using UntracedCore = SingleStageCoreT<NullTracer, BasicStats, DirectMemory>;
+
+static string readText(const string& path) {
+    ifstream in(path);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static bool sameState(UntracedCore& a, DataMem& aMem, UntracedCore& b, DataMem& bMem) {
+    bool same = a.cycle == b.cycle && a.halted == b.halted && a.getInstructionCount() == b.getInstructionCount();
+    for (uint32_t r = 0; r < 32; r++) same &= a.myRF.readReg(r) == b.myRF.readReg(r);
+    for (uint32_t addr = 0; addr < MemSize; addr += 4) same &= aMem.readWord(addr) == bMem.readWord(addr);
+    return same;
+}
+
+static void testChunks(const string& dir, const InsMem& imem) {
+    DataMem refMem("SS", dir);
+    UntracedCore ref(dir, imem, refMem);
+    while (!ref.halted) ref.step();
+    check(ref.myRF.readReg(14) == 80 && ref.myRF.readReg(13) != 0, "the mix program runs through every path");
+
+    for (uint64_t chunk : {(uint64_t)1, (uint64_t)3, (uint64_t)17, UINT64_MAX}) {
+        DataMem mem("SS", dir);
+        UntracedCore core(dir, imem, mem);
+        uint64_t executed = 0;
+        bool withinBudget = true;
+        for (int calls = 0; !core.halted && calls < 100000; calls++) {
+            uint64_t n = core.runThreaded(chunk);
+            withinBudget &= n <= chunk;
+            executed += n;
+        }
+        string name = "chunks of " + (chunk == UINT64_MAX ? string("any size") : to_string(chunk));
+        check(withinBudget && executed == ref.getInstructionCount(), name + " execute every instruction once");
+        check(sameState(core, mem, ref, refMem), name + " end in the stepped state");
+    }
+}
+
+static void testTraces(const string& dir, const InsMem& imem) {
+    DataMem stepMem("SS", dir), threadedMem("SS", dir);
+    SingleStageCore stepped(dir, imem, stepMem), threaded(dir, imem, threadedMem);
+    stepped.setOutputDirectory(dir + "/step");
+    threaded.setOutputDirectory(dir + "/threaded");
+    stepped.runUntil(StopCondition());
+    while (!threaded.halted) threaded.runThreaded(5);
+    threaded.runUntil(StopCondition());
+    for (const char* file : {"/SS_RFResult.txt", "/StateResult_SS.txt"}) {
+        string expected = readText(dir + "/step" + file);
+        check(!expected.empty() && readText(dir + "/threaded" + file) == expected,
+              string(file + 1) + " is byte-identical to the stepped run");
+    }
+}
+
+int main() {
+    string dir = makeMixProgram("test/test_data/threaded", 30);
+    InsMem imem("Imem", dir);
+    testChunks(dir, imem);
+    testTraces(dir, imem);
+    return checkSummary();
+}
@@ -0,0 +1,90 @@
+// Single stage trace files: written through sinks that stay open for the
+// whole run, complete at halt or after flushTrace(), and the same for every
+// engine. One trace writer thread keeps records in order behind a full ring.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <chrono>
+#include <set>
+
+using namespace bench;
+
+static string readText(const string& path) {
+    ifstream in(path);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+static size_t count(const string& text, const string& what) {
+    size_t n = 0;
+    for (size_t pos = text.find(what); pos != string::npos; pos = text.find(what, pos + 1)) n++;
+    return n;
+}
+
+static void testWriter() {
+    vector<uint32_t> seen;
+    std::set<std::thread::id> threads;
+    TraceWriter<uint32_t> writer([&](const uint32_t& r) {
+        if (r % 16 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        seen.push_back(r);
+        threads.insert(std::this_thread::get_id());
+    }, 2);
+    for (uint32_t r = 0; r < 200; r++) writer.push(r);
+    writer.flush();
+    bool ordered = seen.size() == 200;
+    for (uint32_t r = 0; ordered && r < 200; r++) ordered = seen[r] == r;
+    check(ordered, "a slow writer behind a 4-record ring formats every record in order");
+    // long enough for the idle writer to go to sleep
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (uint32_t r = 200; r < 210; r++) writer.push(r);
+    writer.flush();
+    check(seen.size() == 210 && seen.back() == 209, "a sleeping writer wakes for the next push");
+    check(threads.size() == 1 && *threads.begin() == writer.threadId(), "one thread serves every flush");
+}
+
+int main() {
+    testWriter();
+
+    string dir = makeLoopProgram("test/test_data/trace_output", 200);
+    InsMem imem("Imem", dir);
+
+    DataMem stepMem("SS", dir);
+    SingleStageCore stepped(dir, imem, stepMem);
+    stepped.setOutputDirectory(dir + "/step");
+    stepped.runUntil(StopCondition::cycles(100));
+    stepped.flushTrace();
+    string partial = readText(dir + "/step/StateResult_SS.txt");
+    check(count(partial, "State after executing cycle: ") == 100 &&
+              partial.find("State after executing cycle: 99\nIF.PC: ") != string::npos,
+          "flushTrace() after a run leaves every record on disk");
+    stepped.runUntil(StopCondition());
+    string rf = readText(dir + "/step/SS_RFResult.txt");
+    string state = readText(dir + "/step/StateResult_SS.txt");
+    check(count(state, "State after executing cycle: ") == stepped.cycle &&
+              count(rf, "State of RF after executing cycle:  ") == stepped.cycle &&
+              state.find("IF.nop: True\n") != string::npos,
+          "one record per cycle in both files");
+
+    DataMem threadedMem("SS", dir);
+    SingleStageCore threaded(dir, imem, threadedMem);
+    threaded.setOutputDirectory(dir + "/threaded");
+    while (!threaded.halted) threaded.runThreaded(UINT64_MAX);
+    threaded.runUntil(StopCondition());
+    check(readText(dir + "/threaded/SS_RFResult.txt") == rf &&
+              readText(dir + "/threaded/StateResult_SS.txt") == state,
+          "the threaded engine writes the same files");
+
+    DataMem finalMem("SS", dir);
+    FinalStateSingleStageCore finalCore(dir, imem, finalMem);
+    finalCore.setOutputDirectory(dir + "/step");  // over the full trace
+    finalCore.runUntil(StopCondition());
+    string last = readText(dir + "/step/StateResult_SS.txt");
+    check(count(last, "State after executing cycle: ") == 1 && state.size() > last.size() &&
+              state.compare(state.size() - last.size(), last.size(), last) == 0,
+          "the final-state tracer replaces the files with the last record");
+    string lastRf = readText(dir + "/step/SS_RFResult.txt");
+    check(lastRf.size() == 33 * 32 + lastRf.find('\n') + 1 &&
+              rf.compare(rf.size() - lastRf.size(), lastRf.size(), lastRf) == 0,
+          "the final register record matches the traced one");
+
+    return checkSummary();
+}
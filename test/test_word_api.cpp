@@ -0,0 +1,67 @@
+// Word accessors of InsMem, DataMem and RegisterFile against the bitset
+// wrappers they replaced: same values, same big-endian byte order, x0
+// stays zero.
+#include "core.h"
+#include "../bench/bench_common.h"
+#include "check.h"
+#include <random>
+
+using namespace bench;
+
+static void testInsMem(const string& dir) {
+    InsMem imem("Imem", dir);
+    bool same = true;
+    for (uint32_t addr = 0; addr + 4 <= MemSize; addr += 4)
+        same &= imem.readInstr(bitset<32>(addr)).to_ulong() == imem.readWord(addr);
+    check(same, "InsMem::readWord matches readInstr on every word");
+    check(imem.readWord(0) == encI(0, 0, 2, 1, 0x03), "instruction words are big-endian");
+    check(imem.readInstr(bitset<32>(imem.debugGetMemorySize())).none(), "readInstr past the image reads zero");
+}
+
+static void testDataMem(const string& dir) {
+    DataMem words("SS", dir), bits("SS", dir);
+    std::mt19937 rng(8);
+    bool same = true;
+    for (int i = 0; i < 10000; i++) {
+        uint32_t addr = rng() % (MemSize - 4);  // unaligned too
+        uint32_t value = rng();
+        words.writeWord(addr, value);
+        bits.writeDataMem(bitset<32>(addr), bitset<32>(value));
+        uint32_t probe = rng() % (MemSize - 4);
+        same &= words.readWord(probe) == bits.readDataMem(bitset<32>(probe)).to_ulong();
+        same &= words.readWord(addr) == value;
+    }
+    for (uint32_t addr = 0; addr < MemSize; addr++) same &= words.readByte(addr) == bits.readByte(addr);
+    check(same, "DataMem writeWord/readWord match writeDataMem/readDataMem");
+
+    words.writeWord(100, 0x11223344);
+    check(words.readByte(100) == 0x11 && words.readByte(103) == 0x44 &&
+              words.debugGetMemoryByte(101) == bitset<8>(0x22),
+          "data words are stored big-endian");
+}
+
+static void testRegisterFile() {
+    RegisterFile rf("test/test_data/word_api/"), ref("test/test_data/word_api/");
+    std::mt19937 rng(32);
+    bool same = true;
+    for (int i = 0; i < 1000; i++) {
+        uint32_t reg = rng() % 32, value = rng();
+        rf.writeReg(reg, value);
+        ref.writeRF(bitset<5>(reg), bitset<32>(value));
+        uint32_t probe = rng() % 32;
+        same &= rf.readReg(probe) == ref.readRF(bitset<5>(probe)).to_ulong();
+    }
+    check(same, "RegisterFile writeReg/readReg match writeRF/readRF");
+    rf.writeReg(0, 123);
+    ref.writeRF(bitset<5>(0), bitset<32>(123));
+    check(rf.readReg(0) == 0 && ref.readRF(bitset<5>(0)).none() && rf.values()[0] == 0, "x0 stays zero");
+    check(rf.readReg(32) == 0, "registers past x31 read zero");
+}
+
+int main() {
+    string dir = makeLoopProgram("test/test_data/word_api", 10);
+    testInsMem(dir);
+    testDataMem(dir);
+    testRegisterFile();
+    return checkSummary();
+}